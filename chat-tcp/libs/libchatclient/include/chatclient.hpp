@@ -0,0 +1,506 @@
+#pragma once
+#include <algorithm>
+#include <charconv>
+#include <chrono>
+#include <cstdint>
+#include <functional>
+#include <string>
+#include <string_view>
+#include <utility>
+#include <cerrno>
+#include <cstddef>
+#include <cstring>
+#include <poll.h>
+#include <unistd.h>
+#include <fcntl.h>
+#include <sys/sendfile.h>
+#include <sys/socket.h>
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <sys/un.h>
+#include <zlib.h>
+
+// Cliente de chat no bloqueante (header-only).
+//  - Connection no bloqueia em connect/send/recv; pode ser usada com um
+//    poll externo (fd()/events()/handle()) ou com o lao prprio run_once().
+//  - Envio em lote: linhas acumulam num buffer e cada send leva quantas
+//    couberem no socket.
+//  - Linhas recebidas chegam por callback, sem o '\n'.
+//  - Reconexo automtica com backoff exponencial. Com resync, cada conexo
+//    comea com "/since <poca> <ltimo>" e o servidor manda s o histrico
+//    que faltou (ver server/Resync.hpp); a numerao "#<n> " das linhas 
+//    removida antes do callback.
+//  - Anexos: send_file manda "/file <bytes> <nome>" e o arquivo com
+//    sendfile; um "/file <id> <bytes> <nome>" recebido (resposta a "/get")
+//    tem os bytes seguintes gravados no fd dado por on_file, sem virar
+//    linhas. sendfile num socket fechado gera SIGPIPE: ignore-o.
+//  - Compresso (Options::compress): cada conexo comea pedindo
+//    "/compress deflate", e o servidor sempre responde "* compress ..."
+//    (nenhum usurio consegue mandar uma linha assim). S como primeira
+//    linha da conexo a resposta pode ser "* compress deflate": tudo o que
+//    vem depois  um fluxo deflate cru, descomprimido antes de virar
+//    linhas. Um pedido atrasado recebe "* compress off" depois do
+//    histrico, e a resposta no vira linha. Anexos no passam por
+//    conexes comprimidas.
+namespace chatclient {
+
+struct Options {
+    std::string host = "127.0.0.1";
+    uint16_t    port = 5555;
+    std::string unix_path;              // no vazio: conecta por socket UNIX (host/port ignorados)
+    bool        reconnect = true;
+    std::chrono::milliseconds backoff_min{200};
+    std::chrono::milliseconds backoff_max{5000};
+    size_t      max_pending = 8u << 20; // bytes aguardando envio
+    bool        resync = true;          // retoma o histrico pelo ltimo nmero visto
+    bool        compress = false;       // pede compresso da sada do servidor
+};
+
+enum class State { Connecting, Connected, Waiting, Closed };
+
+class Connection {
+public:
+    using LineHandler  = std::function<void(std::string_view)>;
+    using StateHandler = std::function<void(State)>;
+    // Anexo chegando: devolve o fd onde grav-lo (fechado ao fim) ou -1 para descartar
+    using FileHandler  = std::function<int(uint64_t id, uint64_t size, std::string_view name)>;
+    using FileDone     = std::function<void(uint64_t id, bool ok)>;
+    using clock        = std::chrono::steady_clock;
+
+    // A primeira conexo sai no primeiro tick()/run_once(), depois que os
+    // callbacks j foram registrados.
+    explicit Connection(Options opt) : opt_(std::move(opt)), backoff_(opt_.backoff_min) {}
+    ~Connection() {
+        if (fd_ >= 0) ::close(fd_);
+        if (up_fd_ >= 0) ::close(up_fd_);
+        if (down_fd_ >= 0) ::close(down_fd_);
+        if (inflating_) ::inflateEnd(&zin_);
+    }
+    Connection(const Connection&) = delete;
+    Connection& operator=(const Connection&) = delete;
+
+    void on_line(LineHandler h)   { on_line_ = std::move(h); }
+    void on_state(StateHandler h) { on_state_ = std::move(h); }
+    void on_file(FileHandler h, FileDone done = {}) { on_file_ = std::move(h); on_file_done_ = std::move(done); }
+
+    // Enfileira uma linha (o '\n'  acrescentado). false se o buffer encheu.
+    bool send_line(std::string_view line) {
+        if (!accepting(line.size() + 1)) return false;
+        out_.append(line);
+        out_ += '\n';
+        ++lines_sent_;
+        if (state_ == State::Connected) flush();
+        return true;
+    }
+
+    // Enfileira bytes j enquadrados (vrias linhas de uma vez).
+    bool send_raw(std::string_view data) {
+        if (!accepting(data.size())) return false;
+        out_.append(data);
+        for (char ch : data) lines_sent_ += (ch == '\n');
+        if (state_ == State::Connected) flush();
+        return true;
+    }
+
+    // Enfileira um anexo: a linha "/file <size> <name>" e depois `size` bytes
+    // de `file`, lidos pelo kernel (a conexo assume o fd). At o fim do
+    // envio no aceita mais nada; cair no meio descarta o anexo.
+    bool send_file(int file, uint64_t size, std::string_view name) {
+        const std::string header = "/file " + std::to_string(size) + " " + std::string(name) + "\n";
+        if (up_fd_ >= 0 || size == 0 || !accepting(header.size())) return false;
+        up_at_ = out_.size();
+        out_ += header;
+        ++lines_sent_;
+        up_fd_   = file;
+        up_off_  = 0;
+        up_left_ = size;
+        if (state_ == State::Connected) flush();
+        return true;
+    }
+
+    bool     uploading()   const { return up_fd_ >= 0; }
+    uint64_t upload_left() const { return up_left_; }
+
+    // Envia o que estiver pendente, fecha o lado de escrita e espera o
+    // servidor encerrar. No reconecta mais.
+    void finish() {
+        finishing_ = true;
+        if (state_ == State::Connected) flush();
+        else if (state_ == State::Waiting) set_state(State::Closed);
+    }
+
+    void close() {
+        if (fd_ >= 0) { ::close(fd_); fd_ = -1; }
+        set_state(State::Closed);
+    }
+
+    // --------- Integrao com poll externo ----------
+    int fd() const { return fd_; }
+
+    short events() const {
+        if (state_ == State::Connecting) return POLLOUT;
+        if (state_ != State::Connected)  return 0;
+        return POLLIN | (pending() || up_left_ ? POLLOUT : 0);
+    }
+
+    // Tempo at a prxima tentativa de reconexo (-1 se no h nenhuma).
+    int timeout_ms() const {
+        if (state_ != State::Waiting) return -1;
+        auto left = std::chrono::duration_cast<std::chrono::milliseconds>(retry_at_ - clock::now()).count();
+        return left > 0 ? static_cast<int>(left) : 0;
+    }
+
+    void handle(short revents) {
+        if (state_ == State::Connecting) {
+            if (!(revents & (POLLOUT | POLLERR | POLLHUP))) return;
+            int err = 0; socklen_t len = sizeof(err);
+            if (::getsockopt(fd_, SOL_SOCKET, SO_ERROR, &err, &len) < 0 || err != 0) { lost(); return; }
+            connected();
+            return;
+        }
+        if (state_ != State::Connected) return;
+        if (revents & (POLLIN | POLLHUP | POLLERR)) read_ready();
+        if (state_ == State::Connected && (revents & POLLOUT)) flush();
+    }
+
+    // Dispara a (re)conexo se o prazo venceu. Chamar a cada volta do poll.
+    void tick() {
+        if (state_ == State::Waiting && clock::now() >= retry_at_) start_connect();
+    }
+
+    // Lao prprio: espera at max_wait_ms por atividade nesta conexo.
+    // Retorna false quando a conexo terminou de vez.
+    bool run_once(int max_wait_ms) {
+        tick();
+        if (state_ == State::Closed) return false;
+        int wait = max_wait_ms;
+        if (int t = timeout_ms(); t >= 0 && (wait < 0 || t < wait)) wait = t;
+        pollfd p{fd_, events(), 0};
+        int n = ::poll(&p, fd_ >= 0 ? 1 : 0, wait);
+        if (n > 0) handle(p.revents);
+        return state_ != State::Closed;
+    }
+
+    State    state()          const { return state_; }
+    size_t   pending()        const { return out_.size() - out_off_; }
+    uint64_t lines_sent()     const { return lines_sent_; }
+    uint64_t lines_received() const { return lines_received_; }
+    uint64_t send_calls()     const { return send_calls_; }
+    uint64_t last_seq()       const { return last_seq_; }
+    bool     compressed()     const { return compressed_; } // ltima conexo comprimida
+    uint64_t bytes_wire()     const { return bytes_wire_; } // recebidos do socket
+    uint64_t bytes_text()     const { return bytes_text_; } // ... depois de descomprimidos
+
+private:
+    Options      opt_;
+    int          fd_ = -1;
+    State        state_ = State::Waiting;
+    bool         finishing_ = false;
+    bool         mid_line_ = false;  // o ltimo send parou no meio de uma linha
+    bool         wr_closed_ = false;
+    std::string  out_;
+    size_t       out_off_ = 0;
+    std::string  in_;
+    LineHandler  on_line_;
+    StateHandler on_state_;
+    std::chrono::milliseconds backoff_;
+    clock::time_point retry_at_{};
+    uint64_t lines_sent_ = 0, lines_received_ = 0, send_calls_ = 0;
+    uint64_t epoch_ = 0, last_seq_ = 0; // posio no histrico do servidor
+    // Anexo saindo: cabealho em out_[up_at_], bytes por sendfile depois dele
+    int      up_fd_ = -1;
+    off_t    up_off_ = 0;
+    uint64_t up_left_ = 0;
+    size_t   up_at_ = 0;
+    // Anexo chegando: bytes que ainda no so linhas
+    FileHandler on_file_;
+    FileDone    on_file_done_;
+    int         down_fd_ = -1;
+    uint64_t    down_id_ = 0, down_left_ = 0;
+    bool        down_ok_ = true;
+    // Compresso: inflate do que vem depois de "* compress deflate"
+    z_stream    zin_{};
+    bool        inflating_ = false;
+    bool        compressed_ = false;
+    bool        negotiating_ = false; //  espera da resposta ao "/compress deflate"
+    bool        first_line_ = false;  // nenhuma linha recebida nesta conexo ainda
+    uint64_t    bytes_wire_ = 0, bytes_text_ = 0;
+
+    bool accepting(size_t n) const {
+        return state_ != State::Closed && !finishing_ && up_fd_ < 0 && pending() + n <= opt_.max_pending;
+    }
+
+    void set_state(State s) {
+        if (s == state_) return;
+        state_ = s;
+        if (on_state_) on_state_(s);
+    }
+
+    void start_connect() {
+        sockaddr_storage addr{};
+        socklen_t len = 0;
+        if (!opt_.unix_path.empty()) {
+            auto& un = reinterpret_cast<sockaddr_un&>(addr);
+            if (opt_.unix_path.size() >= sizeof(un.sun_path)) { close(); return; }
+            un.sun_family = AF_UNIX;
+            std::memcpy(un.sun_path, opt_.unix_path.data(), opt_.unix_path.size());
+            len = static_cast<socklen_t>(offsetof(sockaddr_un, sun_path) + opt_.unix_path.size() + 1);
+        } else {
+            auto& in = reinterpret_cast<sockaddr_in&>(addr);
+            in.sin_family = AF_INET;
+            in.sin_port   = htons(opt_.port);
+            if (::inet_pton(AF_INET, opt_.host.c_str(), &in.sin_addr) <= 0) { close(); return; }
+            len = sizeof(in);
+        }
+
+        fd_ = ::socket(addr.ss_family, SOCK_STREAM | SOCK_NONBLOCK | SOCK_CLOEXEC, 0);
+        if (fd_ < 0) { lost(); return; }
+        wr_closed_ = false;
+        set_state(State::Connecting);
+        // AF_UNIX no bloqueante: EAGAIN = fila de aceitao cheia; tenta de novo depois
+        if (::connect(fd_, (sockaddr*)&addr, len) == 0) connected();
+        else if (errno != EINPROGRESS) lost();
+    }
+
+    void connected() {
+        backoff_ = opt_.backoff_min;
+        // Primeiras linhas da conexo, antes do que estiver pendente
+        compressed_ = false;
+        negotiating_ = opt_.compress;
+        first_line_ = true;
+        std::string hello;
+        if (opt_.compress) hello = "/compress deflate\n";
+        if (opt_.resync) hello += "/since " + std::to_string(epoch_) + " " + std::to_string(last_seq_) + "\n";
+        out_.insert(out_off_, hello);
+        if (up_fd_ >= 0) up_at_ += hello.size();
+        set_state(State::Connected);
+        flush();
+    }
+
+    // Numerao do servidor: atualiza a posio e devolve a linha sem ela.
+    // false se a linha  s de controle (no vai para o callback).
+    bool track(std::string_view& line) {
+        if (line.starts_with("#")) {
+            uint64_t seq = 0;
+            auto [p, ec] = std::from_chars(line.data() + 1, line.data() + line.size(), seq);
+            if (ec == std::errc{} && p < line.data() + line.size() && *p == ' ') {
+                last_seq_ = std::max(last_seq_, seq);
+                line.remove_prefix(static_cast<size_t>(p - line.data()) + 1);
+            }
+            return true;
+        }
+        const bool sync = line.starts_with("* sync "), gap = line.starts_with("* gap ");
+        if (!sync && !gap) return true;
+        const char* p   = line.data() + (sync ? 7 : 6);
+        const char* end = line.data() + line.size();
+        uint64_t epoch = 0, last = 0;
+        auto r = std::from_chars(p, end, epoch);
+        if (r.ec == std::errc{} && r.ptr < end) std::from_chars(r.ptr + 1, end, last);
+        const bool resuming = epoch_ != 0;
+        if (gap || epoch != epoch_) last_seq_ = 0; // o replay numerado refaz a posio
+        epoch_ = epoch;
+        return gap && resuming; // s a lacuna numa retomada  avisada a quem usa
+    }
+
+    // Conexo caiu (ou no completou): agenda reconexo ou encerra.
+    void lost() {
+        if (fd_ >= 0) { ::close(fd_); fd_ = -1; }
+        in_.clear();
+        if (inflating_) { ::inflateEnd(&zin_); inflating_ = false; }
+        if (down_left_) end_download(false);
+        if (up_fd_ >= 0) {
+            // O cabealho no pode sair de novo sem os bytes atrs dele
+            ::close(up_fd_);
+            up_fd_ = -1;
+            up_left_ = 0;
+            const bool started = out_off_ > up_at_;
+            out_.resize(up_at_);
+            if (started) { out_off_ = out_.size(); mid_line_ = false; }
+        }
+        // Uma linha enviada pela metade no  retomada: o servidor j
+        // descartou o pedao recebido, ento o resto seria lixo.
+        if (mid_line_) {
+            auto nl = out_.find('\n', out_off_);
+            out_off_ = (nl == std::string::npos) ? out_.size() : nl + 1;
+            mid_line_ = false;
+        }
+        compact();
+        if (finishing_ || !opt_.reconnect) { set_state(State::Closed); return; }
+        retry_at_ = clock::now() + backoff_;
+        backoff_  = std::min(backoff_ * 2, opt_.backoff_max);
+        set_state(State::Waiting);
+    }
+
+    void compact() {
+        const size_t erased = (out_off_ == out_.size() || out_off_ > out_.size() / 2) ? out_off_ : 0;
+        if (out_off_ == out_.size()) { out_.clear(); out_off_ = 0; }
+        else if (erased) { out_.erase(0, out_off_); out_off_ = 0; }
+        up_at_ = up_at_ > erased ? up_at_ - erased : 0;
+    }
+
+    void flush() {
+        while (pending() || up_left_) {
+            if (!pending()) {
+                // Anexo: do arquivo direto para o socket
+                ssize_t n = ::sendfile(fd_, up_fd_, &up_off_, static_cast<size_t>(std::min<uint64_t>(up_left_, 1u << 20)));
+                if (n > 0) {
+                    ++send_calls_;
+                    up_left_ -= static_cast<uint64_t>(n);
+                    if (!up_left_) { ::close(up_fd_); up_fd_ = -1; }
+                    continue;
+                }
+                if (n < 0 && errno == EINTR) continue;
+                if (n < 0 && (errno == EAGAIN || errno == EWOULDBLOCK)) break;
+                lost(); // erro, ou arquivo menor que o anunciado
+                return;
+            }
+            ssize_t n = ::send(fd_, out_.data() + out_off_, pending(), MSG_NOSIGNAL);
+            if (n > 0) {
+                ++send_calls_;
+                out_off_ += static_cast<size_t>(n);
+                mid_line_ = out_[out_off_ - 1] != '\n';
+                continue;
+            }
+            if (n < 0 && errno == EINTR) continue;
+            if (n < 0 && (errno == EAGAIN || errno == EWOULDBLOCK)) break;
+            lost();
+            return;
+        }
+        compact();
+        if (finishing_ && !pending() && !up_left_ && !wr_closed_) {
+            ::shutdown(fd_, SHUT_WR);
+            wr_closed_ = true;
+        }
+    }
+
+    void read_ready() {
+        char buf[64 * 1024];
+        for (;;) {
+            ssize_t n = ::recv(fd_, buf, sizeof(buf), MSG_DONTWAIT);
+            if (n > 0) {
+                const size_t old = in_.size();
+                bytes_wire_ += static_cast<uint64_t>(n);
+                if (!take(buf, static_cast<size_t>(n))) { lost(); return; }
+                if (down_left_) { if (!deliver()) return; }
+                else if (auto last = in_.rfind('\n'); last != std::string::npos && last >= old) {
+                    if (!deliver()) return;
+                }
+                if (static_cast<size_t>(n) < sizeof(buf)) return;
+                continue;
+            }
+            if (n < 0 && errno == EINTR) continue;
+            if (n < 0 && (errno == EAGAIN || errno == EWOULDBLOCK)) return;
+            lost(); // EOF ou erro
+            return;
+        }
+    }
+
+    // Entrega o que est completo em in_: bytes de anexo ao fd dele, linhas
+    // ao callback. false se a conexo caiu no meio.
+    bool deliver() {
+        while (!in_.empty()) {
+            if (down_left_) {
+                const size_t take = static_cast<size_t>(std::min<uint64_t>(down_left_, in_.size()));
+                if (down_fd_ >= 0 && down_ok_) down_ok_ = write_all(down_fd_, in_.data(), take);
+                in_.erase(0, take);
+                down_left_ -= take;
+                if (!down_left_) end_download(down_ok_);
+                continue;
+            }
+            auto last = in_.rfind('\n');
+            if (last == std::string::npos) break;
+            // O callback pode enviar (e at perder a conexo), ento as
+            // linhas completas saem de in_ antes de serem entregues.
+            std::string lines = in_.substr(0, last + 1);
+            in_.erase(0, last + 1);
+            size_t off = 0, pos;
+            while ((pos = lines.find('\n', off)) != std::string::npos) {
+                ++lines_received_;
+                std::string_view line = std::string_view(lines).substr(off, pos - off);
+                off = pos + 1;
+                // Resposta  negociao: s a primeira linha da conexo pode
+                // ligar a compresso; uma resposta atrasada segue em claro
+                const bool first = std::exchange(first_line_, false);
+                if (negotiating_ && line.starts_with("* compress ")) {
+                    negotiating_ = false;
+                    if (!first || line != "* compress deflate") continue; // recusada: segue em claro
+                    // O resto do lote e de in_ j  o fluxo comprimido
+                    std::string rest = lines.substr(off) + in_;
+                    in_.clear();
+                    bytes_text_ -= rest.size(); // contados em claro por engano
+                    inflating_ = compressed_ = ::inflateInit2(&zin_, -15) == Z_OK;
+                    if (!inflating_ || !take(rest.data(), rest.size())) { lost(); return false; }
+                    break;
+                }
+                if (start_download(line)) {
+                    // O resto do lote j  o anexo: volta para a frente de in_
+                    in_.insert(0, lines, off, std::string::npos);
+                    break;
+                }
+                if ((!opt_.resync || track(line)) && on_line_) on_line_(line);
+                if (state_ != State::Connected) return false;
+            }
+        }
+        return state_ == State::Connected;
+    }
+
+    // Bytes do socket para in_, descomprimidos se for o caso. false em dados
+    // comprimidos invlidos.
+    bool take(const char* p, size_t n) {
+        if (!inflating_) {
+            in_.append(p, n);
+            bytes_text_ += n;
+            return true;
+        }
+        zin_.next_in  = reinterpret_cast<Bytef*>(const_cast<char*>(p));
+        zin_.avail_in = static_cast<uInt>(n);
+        for (;;) {
+            const size_t old = in_.size();
+            const size_t room = std::max<size_t>(4 * n, 16 * 1024);
+            in_.resize(old + room);
+            zin_.next_out  = reinterpret_cast<Bytef*>(in_.data() + old);
+            zin_.avail_out = static_cast<uInt>(room);
+            const int rc = ::inflate(&zin_, Z_SYNC_FLUSH);
+            in_.resize(old + room - zin_.avail_out);
+            bytes_text_ += room - zin_.avail_out;
+            if (rc != Z_OK && rc != Z_BUF_ERROR) return false;
+            if (zin_.avail_out != 0) return zin_.avail_in == 0;
+        }
+    }
+
+    // "/file <id> <bytes> <nome>": os prximos <bytes> so o anexo
+    bool start_download(std::string_view line) {
+        if (!line.starts_with("/file ")) return false;
+        const char* p   = line.data() + 6;
+        const char* end = line.data() + line.size();
+        uint64_t id = 0, size = 0;
+        auto r = std::from_chars(p, end, id);
+        if (r.ec != std::errc{} || r.ptr == end || *r.ptr != ' ') return false;
+        r = std::from_chars(r.ptr + 1, end, size);
+        if (r.ec != std::errc{} || r.ptr == end || *r.ptr != ' ' || size == 0) return false;
+        const std::string_view name(r.ptr + 1, static_cast<size_t>(end - r.ptr - 1));
+        down_id_   = id;
+        down_left_ = size;
+        down_ok_   = true;
+        down_fd_   = on_file_ ? on_file_(id, size, name) : -1;
+        return true;
+    }
+
+    void end_download(bool ok) {
+        if (down_fd_ >= 0) { ::close(down_fd_); down_fd_ = -1; }
+        down_left_ = 0;
+        if (on_file_done_) on_file_done_(down_id_, ok);
+    }
+
+    static bool write_all(int fd, const char* p, size_t n) {
+        while (n) {
+            ssize_t k = ::write(fd, p, n);
+            if (k < 0 && errno == EINTR) continue;
+            if (k <= 0) return false;
+            p += k; n -= static_cast<size_t>(k);
+        }
+        return true;
+    }
+};
+
+} // namespace chatclient
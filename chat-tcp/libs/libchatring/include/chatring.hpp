@@ -0,0 +1,256 @@
+#pragma once
+#include <algorithm>
+#include <atomic>
+#include <bit>
+#include <cerrno>
+#include <climits>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <new>
+#include <string>
+#include <string_view>
+#include <fcntl.h>
+#include <linux/futex.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <sys/syscall.h>
+#include <time.h>
+#include <unistd.h>
+
+// Canal de publicao em memria compartilhada (header-only).
+//
+// O servidor escreve cada mensagem uma nica vez num anel (segmento POSIX
+// shm, ex.: /dev/shm/chat-5555) e qualquer nmero de consumidores locais l
+// o mesmo anel, cada um com o prprio cursor. O produtor nunca espera por
+// leitor nenhum: quem ficar uma volta inteira para trs percebe e recomea
+// da posio atual (Reader::next devolve Lapped). Acrescentar leitores no
+// custa nada ao produtor alm de, com algum dormindo, um FUTEX_WAKE.
+//
+// Layout: Header (3 linhas de cache) + anel de `capacity` bytes. Cada
+// registro  Record + payload, alinhado a 16 bytes; um registro nunca d a
+// volta no anel (o fim vira um registro de preenchimento).
+//
+// Protocolo (posies lgicas, crescentes):
+//   produtor: intent = fim novo; escreve; tail = fim novo
+//   leitor:   copia o registro em cur; rel intent; se intent - cur >
+//             capacity, o produtor pode ter sobrescrito o que foi copiado
+namespace chatring {
+
+inline constexpr uint32_t kMagic   = 0x31545243; // "CRT1"
+inline constexpr uint32_t kVersion = 1;
+inline constexpr size_t   kAlign   = 16;
+
+struct Header {
+    uint32_t magic;
+    uint32_t version;
+    uint64_t capacity;                             // bytes do anel (potncia de 2)
+    alignas(64) std::atomic<uint64_t> intent;      // fim do registro em escrita
+    alignas(64) std::atomic<uint64_t> tail;        // fim do ltimo registro publicado
+    alignas(64) std::atomic<uint32_t> notify;      // palavra do futex (muda a cada aviso)
+    std::atomic<uint32_t>             waiters;     // leitores dormindo no futex
+};
+static_assert(std::atomic<uint64_t>::is_always_lock_free && std::atomic<uint32_t>::is_always_lock_free,
+              "o anel  compartilhado entre processos: os atmicos no podem usar trava");
+
+struct Record {
+    uint32_t len;  // bytes de payload
+    uint32_t kind; // kMessage ou kPadding
+    uint64_t seq;  // nmero da mensagem no histrico do servidor
+};
+inline constexpr uint32_t kMessage = 0;
+inline constexpr uint32_t kPadding = 1;
+
+inline constexpr size_t record_size(size_t len) {
+    return (sizeof(Record) + len + kAlign - 1) & ~(kAlign - 1);
+}
+
+// Futex entre processos (sem FUTEX_PRIVATE_FLAG): o endereo  da memria compartilhada.
+inline void futex_wake_all(std::atomic<uint32_t>& w) {
+    ::syscall(SYS_futex, reinterpret_cast<uint32_t*>(&w), FUTEX_WAKE, INT_MAX, nullptr, nullptr, 0);
+}
+inline void futex_wait(std::atomic<uint32_t>& w, uint32_t expected, int timeout_ms) {
+    timespec ts{timeout_ms / 1000, (timeout_ms % 1000) * 1000000L};
+    ::syscall(SYS_futex, reinterpret_cast<uint32_t*>(&w), FUTEX_WAIT, expected,
+              timeout_ms >= 0 ? &ts : nullptr, nullptr, 0);
+}
+
+// --------- Produtor (um s: o broadcaster) ----------
+class Publisher {
+public:
+    Publisher() = default;
+    ~Publisher() { close(); }
+    Publisher(const Publisher&) = delete;
+    Publisher& operator=(const Publisher&) = delete;
+
+    // Cria (ou recria) o segmento `name` ("/chat-5555") com um anel de pelo
+    // menos `capacity` bytes.
+    bool create(const std::string& name, size_t capacity) {
+        close();
+        const size_t cap = std::bit_ceil(std::max<size_t>(capacity, 64 * 1024));
+        int fd = ::shm_open(name.c_str(), O_RDWR | O_CREAT | O_TRUNC, 0600);
+        if (fd < 0) return false;
+        const size_t total = sizeof(Header) + cap;
+        void* p = MAP_FAILED;
+        if (::ftruncate(fd, static_cast<off_t>(total)) == 0) {
+            p = ::mmap(nullptr, total, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+        }
+        ::close(fd);
+        if (p == MAP_FAILED) { ::shm_unlink(name.c_str()); return false; }
+
+        h_    = new (p) Header{};
+        data_ = static_cast<char*>(p) + sizeof(Header);
+        cap_  = cap;
+        size_ = total;
+        name_ = name;
+        h_->capacity = cap;
+        h_->version  = kVersion;
+        std::atomic_thread_fence(std::memory_order_release);
+        h_->magic    = kMagic; // por ltimo: leitores s aceitam o segmento pronto
+        return true;
+    }
+
+    // Publica um registro. false se o payload no cabe em meio anel.
+    bool publish(std::string_view payload, uint64_t seq) {
+        const size_t need = record_size(payload.size());
+        if (!h_ || need > cap_ / 2) return false;
+        const size_t off = static_cast<size_t>(pos_ & (cap_ - 1));
+        const size_t pad = (off + need > cap_) ? cap_ - off : 0;
+        const uint64_t end = pos_ + pad + need;
+
+        h_->intent.store(end, std::memory_order_relaxed);
+        std::atomic_thread_fence(std::memory_order_release);
+        size_t at = off;
+        if (pad) {
+            write_header(at, Record{static_cast<uint32_t>(pad - sizeof(Record)), kPadding, 0});
+            at = 0;
+        }
+        write_header(at, Record{static_cast<uint32_t>(payload.size()), kMessage, seq});
+        std::memcpy(data_ + at + sizeof(Record), payload.data(), payload.size());
+
+        // seq_cst com o fetch_add de Reader::wait: ou o leitor v o tail
+        // novo, ou este load v o leitor e o acorda
+        h_->tail.store(end, std::memory_order_seq_cst);
+        pos_ = end;
+        ++published_;
+        if (h_->waiters.load(std::memory_order_seq_cst) != 0) {
+            h_->notify.fetch_add(1, std::memory_order_release);
+            futex_wake_all(h_->notify);
+            ++wakeups_;
+        }
+        return true;
+    }
+
+    void close() {
+        if (!h_) return;
+        ::munmap(h_, size_);
+        ::shm_unlink(name_.c_str());
+        h_ = nullptr;
+    }
+
+    bool     ok()        const { return h_ != nullptr; }
+    size_t   capacity()  const { return cap_; }
+    uint64_t published() const { return published_; }
+    uint64_t wakeups()   const { return wakeups_; }
+
+private:
+    Header*     h_    = nullptr;
+    char*       data_ = nullptr;
+    size_t      cap_  = 0;
+    size_t      size_ = 0;
+    uint64_t    pos_  = 0;
+    uint64_t    published_ = 0, wakeups_ = 0;
+    std::string name_;
+
+    void write_header(size_t at, const Record& r) { std::memcpy(data_ + at, &r, sizeof(r)); }
+};
+
+// --------- Leitor (um por consumidor; sem escrita no anel) ----------
+class Reader {
+public:
+    enum class Status { Ok, Empty, Lapped };
+
+    Reader() = default;
+    ~Reader() { if (h_) ::munmap(h_, size_); }
+    Reader(const Reader&) = delete;
+    Reader& operator=(const Reader&) = delete;
+
+    // Abre o segmento e comea do que for publicado a partir de agora.
+    bool open(const std::string& name) {
+        int fd = ::shm_open(name.c_str(), O_RDWR, 0);
+        if (fd < 0) return false;
+        struct stat st{};
+        void* p = MAP_FAILED;
+        if (::fstat(fd, &st) == 0 && static_cast<size_t>(st.st_size) > sizeof(Header)) {
+            p = ::mmap(nullptr, static_cast<size_t>(st.st_size), PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+        }
+        ::close(fd);
+        if (p == MAP_FAILED) return false;
+        auto* h = static_cast<Header*>(p);
+        std::atomic_thread_fence(std::memory_order_acquire);
+        if (h->magic != kMagic || h->version != kVersion ||
+            sizeof(Header) + h->capacity != static_cast<size_t>(st.st_size)) {
+            ::munmap(p, static_cast<size_t>(st.st_size));
+            return false;
+        }
+        h_    = h;
+        data_ = static_cast<const char*>(p) + sizeof(Header);
+        cap_  = h->capacity;
+        size_ = static_cast<size_t>(st.st_size);
+        cur_  = h->tail.load(std::memory_order_acquire);
+        return true;
+    }
+
+    // Prximo registro em `out`/`seq`. Nunca espera: Empty se no h nada
+    // novo; Lapped se o produtor passou deste leitor (o cursor pula para o
+    // fim e `lost()` conta a volta).
+    Status next(std::string& out, uint64_t& seq) {
+        for (;;) {
+            const uint64_t tail = h_->tail.load(std::memory_order_acquire);
+            if (cur_ == tail) return Status::Empty;
+            if (tail - cur_ > cap_) return lap();
+
+            Record r;
+            const size_t off = static_cast<size_t>(cur_ & (cap_ - 1));
+            std::memcpy(&r, data_ + off, sizeof(r));
+            const bool sane = sizeof(Record) + r.len <= cap_ - off;
+            if (sane && r.kind == kMessage) out.assign(data_ + off + sizeof(Record), r.len);
+
+            std::atomic_thread_fence(std::memory_order_acquire);
+            if (!sane || h_->intent.load(std::memory_order_relaxed) - cur_ > cap_) return lap();
+            cur_ += record_size(r.len);
+            if (r.kind != kMessage) continue;
+            seq = r.seq;
+            return Status::Ok;
+        }
+    }
+
+    // Dorme at haver registro novo ou `timeout_ms` (-1 = sem prazo).
+    // true se h algo para ler.
+    bool wait(int timeout_ms) {
+        const uint32_t token = h_->notify.load(std::memory_order_acquire);
+        h_->waiters.fetch_add(1, std::memory_order_seq_cst);
+        if (h_->tail.load(std::memory_order_seq_cst) == cur_) futex_wait(h_->notify, token, timeout_ms);
+        h_->waiters.fetch_sub(1, std::memory_order_relaxed);
+        return h_->tail.load(std::memory_order_acquire) != cur_;
+    }
+
+    uint64_t lost()     const { return lost_; }
+    size_t   capacity() const { return cap_; }
+
+private:
+    Header*     h_    = nullptr;
+    const char* data_ = nullptr;
+    size_t      cap_  = 0;
+    size_t      size_ = 0;
+    uint64_t    cur_  = 0;
+    uint64_t    lost_ = 0;
+
+    Status lap() {
+        ++lost_;
+        cur_ = h_->tail.load(std::memory_order_acquire);
+        return Status::Lapped;
+    }
+};
+
+} // namespace chatring
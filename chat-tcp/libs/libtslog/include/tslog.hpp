@@ -1,4 +1,5 @@
 #pragma once
+#include <atomic>
 #include <mutex>
 #include <fstream>
 #include <iostream>
@@ -22,6 +23,16 @@ inline const char* level_name(Level lv) {
     }
 }
 
+// "debug", "info", "warn" ou "error" -> nvel; false se no reconhecer.
+inline bool parse_level(std::string_view s, Level& out) {
+    if      (s == "debug") out = Level::Debug;
+    else if (s == "info")  out = Level::Info;
+    else if (s == "warn")  out = Level::Warn;
+    else if (s == "error") out = Level::Error;
+    else return false;
+    return true;
+}
+
 inline std::string now_str() {
     using namespace std::chrono;
     auto now = system_clock::now();
@@ -33,9 +44,10 @@ inline std::string now_str() {
 
 class Logger {
 public:
-    Level       min_level = Level::Info;
-    bool        to_stdout = true;
-    std::string file_path = "logs/app.log";
+    // Nvel e sada padro podem mudar com outras threads registrando
+    std::atomic<Level> min_level{Level::Info};
+    std::atomic<bool>  to_stdout{true};
+    std::string        file_path = "logs/app.log"; // vazio -> sem arquivo
 
     Logger() { open_file(); }
     Logger(Level min, bool out, std::string path)
@@ -57,23 +69,54 @@ public:
     void warn (std::string_view s) { log(Level::Warn,  std::string(s)); }
     void error(std::string_view s) { log(Level::Error, std::string(s)); }
 
+    // --------- Ajustes em tempo de execuo ----------
+    void set_level(Level lv) { min_level.store(lv, std::memory_order_relaxed); }
+    Level level() const { return min_level.load(std::memory_order_relaxed); }
+
+    // Troca o arquivo de sada (vazio desliga); false se no conseguiu abrir,
+    // e nesse caso o arquivo atual continua em uso (errno diz o motivo).
+    // Reabrir o mesmo caminho serve para rotao externa do log.
+    bool set_file(std::string path) {
+        std::ofstream next;
+        if (!path.empty() && !open_stream(path, next)) return false;
+        std::lock_guard<std::mutex> lk(m_);
+        fout_ = std::move(next);
+        file_path = std::move(path);
+        return true;
+    }
+    std::string file() {
+        std::lock_guard<std::mutex> lk(m_);
+        return fout_.is_open() ? file_path : std::string();
+    }
+
+    void flush() {
+        std::lock_guard<std::mutex> lk(m_);
+        std::cout.flush();
+        if (fout_.is_open()) fout_.flush();
+    }
+
 private:
     std::mutex   m_;
     std::ofstream fout_;
 
     void open_file() {
+        if (!file_path.empty()) open_stream(file_path, fout_);
+    }
+
+    static bool open_stream(const std::string& path, std::ofstream& out) {
         try {
-            auto p = std::filesystem::path(file_path).parent_path();
+            auto p = std::filesystem::path(path).parent_path();
             if (!p.empty()) std::filesystem::create_directories(p);
         } catch (...) { /* fallback: apenas stdout */ }
-        fout_.open(file_path, std::ios::app);
+        out.open(path, std::ios::app);
+        return out.is_open();
     }
 
     void log(Level lv, const std::string& msg) {
-        if (lv < min_level) return;
+        if (lv < min_level.load(std::memory_order_relaxed)) return;
         std::lock_guard<std::mutex> lk(m_);
         const std::string line = now_str() + " [" + level_name(lv) + "] " + msg + "\n";
-        if (to_stdout) { std::cout << line; std::cout.flush(); }
+        if (to_stdout.load(std::memory_order_relaxed)) { std::cout << line; std::cout.flush(); }
         if (fout_.is_open()) { fout_ << line; fout_.flush(); }
     }
 
@@ -1,42 +1,212 @@
-#include <thread>
+#include <chrono>
+#include <csignal>
+#include <cstdio>
 #include <iostream>
 #include <string>
+#include <string_view>
+#include <vector>
+#include <cerrno>
+#include <fcntl.h>
+#include <poll.h>
+#include <sys/stat.h>
 #include <unistd.h>
-#include "common/net.hpp"
+#include <chatclient.hpp>
 #include "common/logging.hpp"
 
-int main(int argc, char** argv) {
-    std::string host = (argc > 1) ? argv[1] : "127.0.0.1";
-    uint16_t    port = (argc > 2) ? (uint16_t)std::stoi(argv[2]) : 5555;
+// /send <caminho>: manda o arquivo como anexo (o servidor anuncia "/get <id>")
+static void send_attachment(chatclient::Connection& conn, const std::string& path) {
+    if (conn.uploading()) { log::L().warn("J h um anexo sendo enviado"); return; }
+    const int fd = ::open(path.c_str(), O_RDONLY | O_CLOEXEC);
+    struct stat st{};
+    if (fd < 0 || ::fstat(fd, &st) < 0 || !S_ISREG(st.st_mode)) {
+        log::L().warn("No foi possvel abrir {} como arquivo", path);
+        if (fd >= 0) ::close(fd);
+        return;
+    }
+    const size_t slash = path.rfind('/');
+    const std::string name = slash == std::string::npos ? path : path.substr(slash + 1);
+    if (!conn.send_file(fd, static_cast<uint64_t>(st.st_size), name)) {
+        log::L().warn("Anexo {} no enfileirado (vazio ou conexo ocupada)", name);
+        ::close(fd);
+        return;
+    }
+    log::L().info("Enviando {} ({} bytes)", name, static_cast<uint64_t>(st.st_size));
+}
 
-    int fd = connect_to(host, port);
-    if (fd < 0) {
-        std::cerr << "Falha ao conectar em " << host << ":" << port << "\n";
-        return 1;
+// Anexo recebido (/get): salvo no diretrio atual, sem sobrescrever nada
+static int save_attachment(uint64_t id, uint64_t size, std::string_view name) {
+    std::string path(name);
+    if (path.empty() || path[0] == '.' || path.find('/') != std::string::npos) path = "anexo";
+    int fd = ::open(path.c_str(), O_WRONLY | O_CREAT | O_EXCL | O_CLOEXEC, 0644);
+    if (fd < 0 && errno == EEXIST) {
+        path = std::to_string(id) + "-" + path;
+        fd = ::open(path.c_str(), O_WRONLY | O_CREAT | O_EXCL | O_CLOEXEC, 0644);
     }
-    log::L().info("Conectado a {}:{}", host, port);
+    if (fd < 0) log::L().warn("Anexo {} descartado: no foi possvel criar {}", id, path);
+    else log::L().info("Recebendo anexo {} em {} ({} bytes)", id, path, size);
+    return fd;
+}
 
-    // Thread receptora
-    std::thread rx([&](){
-        char buf[1024];
-        while (true) {
-            ssize_t n = ::recv(fd, buf, sizeof(buf), 0);
-            if (n <= 0) break;
-            std::cout.write(buf, n);
-            std::cout.flush();
+// Modo interativo: stdin -> servidor linha a linha, recebidas -> stdout na hora.
+// "/send <caminho>" manda um arquivo como anexo.
+static int run_interactive(chatclient::Connection& conn, const std::string& where) {
+    bool was_connected = false;
+    conn.on_state([&](chatclient::State s) {
+        if (s == chatclient::State::Connected) {
+            log::L().info("Conectado a {}", where);
+            was_connected = true;
+        } else if (was_connected) {
+            log::L().warn("Conexo encerrada pelo servidor");
+            was_connected = false;
         }
-        log::L().warn("Conexo encerrada pelo servidor");
     });
+    conn.on_line([](std::string_view line) {
+        std::cout << line << '\n';
+        std::cout.flush();
+    });
+    conn.on_file(save_attachment, [](uint64_t id, bool ok) {
+        if (ok) log::L().info("Anexo {} salvo", id);
+        else log::L().warn("Anexo {} incompleto", id);
+    });
+
+    // Envio (stdin -> socket). Com um anexo saindo, as linhas seguintes
+    // esperam em `acc` (e stdin deixa de ser lido) at ele terminar.
+    bool stdin_open = true, finished = false;
+    std::string acc;
+    char buf[4096];
+    auto send_lines = [&] {
+        size_t off = 0, pos;
+        while (!conn.uploading() && (pos = acc.find('\n', off)) != std::string::npos) {
+            const std::string_view line = std::string_view(acc).substr(off, pos - off);
+            if (line.starts_with("/send ")) send_attachment(conn, std::string(line.substr(6)));
+            else conn.send_line(line);
+            off = pos + 1;
+        }
+        acc.erase(0, off);
+    };
+    for (;;) {
+        conn.tick();
+        if (conn.state() == chatclient::State::Closed) break;
+        send_lines();
+        if (!stdin_open && !finished && !conn.uploading()) { conn.finish(); finished = true; }
 
-    // Envio (stdin -> socket)
-    std::string line;
-    while (std::getline(std::cin, line)) {
-        line.push_back('\n');
-        if (send_all(fd, line.data(), line.size()) <= 0) break;
+        const bool want_input = stdin_open && !conn.uploading();
+        pollfd p[2] = {{conn.fd(), conn.events(), 0}, {want_input ? 0 : -1, POLLIN, 0}};
+        int n = ::poll(p, 2, conn.timeout_ms());
+        if (n < 0 && errno != EINTR) break;
+        if (n <= 0) continue;
+        if (p[0].revents) conn.handle(p[0].revents);
+        if (p[1].revents) {
+            ssize_t r = ::read(0, buf, sizeof(buf));
+            if (r <= 0) { stdin_open = false; continue; }
+            acc.append(buf, static_cast<size_t>(r));
+            send_lines();
+        }
     }
+    return 0;
+}
+
+// Modo pipe: despeja um arquivo (ou stdin) no servidor o mais rpido possvel,
+// em lotes, e grava o que chega num stdout bufferizado.
+static int run_pipe(chatclient::Connection& conn, int in_fd) {
+    using clock = std::chrono::steady_clock;
+    static char out_buf[1 << 20];
+    std::setvbuf(stdout, out_buf, _IOFBF, sizeof(out_buf));
+    log::L().to_stdout = false; // stdout  s dos dados
+
+    conn.on_line([](std::string_view line) {
+        std::fwrite(line.data(), 1, line.size(), stdout);
+        std::fputc('\n', stdout);
+    });
+
+    const size_t high_water = 1 << 20; // no l mais entrada com 1 MiB pendente
+    bool in_open = true;
+    char last = '\n';
+    std::vector<char> chunk(256 * 1024);
+    const auto t0 = clock::now();
+
+    for (;;) {
+        conn.tick();
+        if (conn.state() == chatclient::State::Closed) break;
 
-    ::shutdown(fd, SHUT_WR);
-    rx.join();
-    ::close(fd);
+        const bool want_input = in_open && conn.pending() < high_water;
+        pollfd p[2] = {{conn.fd(), conn.events(), 0}, {want_input ? in_fd : -1, POLLIN, 0}};
+        int n = ::poll(p, 2, conn.timeout_ms());
+        if (n < 0 && errno != EINTR) break;
+        if (n <= 0) continue;
+        if (p[0].revents) conn.handle(p[0].revents);
+        if (p[1].revents) {
+            ssize_t r = ::read(in_fd, chunk.data(), chunk.size());
+            if (r > 0) {
+                conn.send_raw(std::string_view(chunk.data(), static_cast<size_t>(r)));
+                last = chunk[r - 1];
+            } else {
+                if (last != '\n') conn.send_raw("\n");
+                in_open = false;
+                conn.finish();
+            }
+        }
+    }
+    std::fflush(stdout);
+
+    const double secs = std::chrono::duration<double>(clock::now() - t0).count();
+    std::cerr << "pipe: " << conn.lines_sent() << " linhas enviadas em " << conn.send_calls()
+              << " envios, " << conn.lines_received() << " recebidas, " << secs << "s\n";
+    if (conn.bytes_text()) {
+        std::cerr << "pipe: " << conn.bytes_text() << " bytes de texto em " << conn.bytes_wire() << " bytes recebidos"
+                  << (conn.compressed() ? " (comprimidos)" : "") << "\n";
+    }
     return 0;
 }
+
+int main(int argc, char** argv) {
+    // Uso: ./chat_client [host] [porta] [--unix caminho] [--pipe [arquivo]] [--compress]
+    std::vector<std::string> pos;
+    bool pipe_mode = false, compress = false;
+    std::string pipe_file, unix_path;
+    for (int i = 1; i < argc; ++i) {
+        std::string a = argv[i];
+        if (a == "--unix" && i + 1 < argc) {
+            unix_path = argv[++i];
+        } else if (a == "--compress") {
+            compress = true;
+        } else if (a == "--pipe") {
+            pipe_mode = true;
+            if (i + 1 < argc && argv[i + 1][0] != '-') pipe_file = argv[++i];
+        } else {
+            pos.push_back(a);
+        }
+    }
+    std::string host = (pos.size() > 0) ? pos[0] : "127.0.0.1";
+    uint16_t    port = (pos.size() > 1) ? (uint16_t)std::stoi(pos[1]) : 5555;
+
+    chatclient::Options opt;
+    opt.host = host;
+    opt.port = port;
+    opt.unix_path = unix_path;
+    opt.compress  = compress;
+    const std::string where = unix_path.empty() ? host + ":" + std::to_string(port) : unix_path;
+    std::signal(SIGPIPE, SIG_IGN); // anexos saem por sendfile, que no aceita MSG_NOSIGNAL
+
+    if (!pipe_mode) {
+        chatclient::Connection conn(opt);
+        return run_interactive(conn, where);
+    }
+
+    int in_fd = 0;
+    if (!pipe_file.empty() && (in_fd = ::open(pipe_file.c_str(), O_RDONLY | O_CLOEXEC)) < 0) {
+        std::cerr << "Falha ao abrir " << pipe_file << "\n";
+        return 1;
+    }
+    opt.reconnect = false; // replay de arquivo: uma queda encerra o envio
+    chatclient::Connection conn(opt);
+    bool ok = false;
+    conn.on_state([&](chatclient::State s) { if (s == chatclient::State::Connected) ok = true; });
+    int rc = run_pipe(conn, in_fd);
+    if (in_fd > 0) ::close(in_fd);
+    if (!ok) {
+        std::cerr << "Falha ao conectar em " << where << "\n";
+        return 1;
+    }
+    return rc;
+}
@@ -0,0 +1,213 @@
+#pragma once
+#include <cstdint>
+#include <cstring>
+#include <string>
+#include <string_view>
+#include <cerrno>
+#include <fcntl.h>
+#include <unistd.h>
+
+// Captura de trfego de entrada (chat_server --capture) e leitura para o
+// chat_replay. Formato binrio compacto, s anexado:
+//
+//   cabealho: "CHATCAP1" | u64 incio (s desde a epoch, little-endian)
+//   registro:  u8 tipo | varint s desde o registro anterior | varint sesso
+//              Connect:    + varint fd
+//              Line:       + varint tamanho + bytes (sem '\n')
+//              Disconnect: (nada)
+//              Payload:    + varint tamanho
+//
+// Payload segue a linha "/file <bytes> <nome>" de um anexo aceito: s o
+// tamanho do que o servidor leu, no os bytes (o chat_replay manda
+// enchimento do mesmo tamanho, para o fluxo da sesso no sair de fase).
+//
+// A sesso  um nmero crescente dado pelo servidor (fds so reaproveitados;
+// o fd vai no Connect s para referncia). Uma linha tpica custa ~5 bytes
+// alm do texto.
+namespace capture {
+
+inline constexpr char   kMagic[8]  = {'C', 'H', 'A', 'T', 'C', 'A', 'P', '1'};
+inline constexpr size_t kHeaderLen = 16;
+
+enum class Kind : uint8_t { Connect = 1, Line = 2, Disconnect = 3, Payload = 4 };
+
+struct Event {
+    Kind        kind    = Kind::Line;
+    int64_t     ts_us   = 0; // absoluto (s desde a epoch)
+    uint64_t    session = 0;
+    uint64_t    fd      = 0; // Connect
+    std::string text;        // Line
+    uint64_t    size    = 0; // Payload
+};
+
+inline void put_varint(std::string& out, uint64_t v) {
+    while (v >= 0x80) { out.push_back(static_cast<char>((v & 0x7f) | 0x80)); v >>= 7; }
+    out.push_back(static_cast<char>(v));
+}
+
+// --------- Escrita (thread do EventLoop) ----------
+// Acumula em memria e grava em blocos: um write a cada ~64 KiB.
+class Writer {
+public:
+    static constexpr size_t kFlushAt = 64 * 1024;
+
+    Writer() = default;
+    ~Writer() { close(); }
+    Writer(const Writer&) = delete;
+    Writer& operator=(const Writer&) = delete;
+
+    bool open(const std::string& path, int64_t now_us) {
+        fd_ = ::open(path.c_str(), O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC, 0644);
+        if (fd_ < 0) return false;
+        buf_.reserve(kFlushAt * 2);
+        buf_.append(kMagic, sizeof(kMagic));
+        for (int i = 0; i < 8; ++i) buf_.push_back(static_cast<char>(uint64_t(now_us) >> (8 * i)));
+        last_us_ = now_us;
+        return flush();
+    }
+    bool ok() const { return fd_ >= 0; }
+
+    void connect(uint64_t session, int fd, int64_t now_us) {
+        begin(Kind::Connect, session, now_us);
+        put_varint(buf_, static_cast<uint64_t>(fd));
+        maybe_flush();
+    }
+    void line(uint64_t session, std::string_view text, int64_t now_us) {
+        begin(Kind::Line, session, now_us);
+        put_varint(buf_, text.size());
+        buf_.append(text);
+        maybe_flush();
+    }
+    void disconnect(uint64_t session, int64_t now_us) {
+        begin(Kind::Disconnect, session, now_us);
+        maybe_flush();
+    }
+    void payload(uint64_t session, uint64_t size, int64_t now_us) {
+        begin(Kind::Payload, session, now_us);
+        put_varint(buf_, size);
+        maybe_flush();
+    }
+
+    bool flush() {
+        for (size_t off = 0; off < buf_.size();) {
+            ssize_t n = ::write(fd_, buf_.data() + off, buf_.size() - off);
+            if (n < 0 && errno == EINTR) continue;
+            if (n <= 0) { buf_.clear(); ++errors_; return false; }
+            off += static_cast<size_t>(n);
+        }
+        written_ += buf_.size();
+        buf_.clear();
+        return true;
+    }
+
+    void close() {
+        if (fd_ < 0) return;
+        flush();
+        ::close(fd_);
+        fd_ = -1;
+    }
+
+    uint64_t records() const { return records_; }
+    uint64_t bytes()   const { return written_ + buf_.size(); }
+    uint64_t errors()  const { return errors_; }
+
+private:
+    int         fd_ = -1;
+    std::string buf_;
+    int64_t     last_us_  = 0;
+    uint64_t    records_  = 0;
+    uint64_t    written_  = 0;
+    uint64_t    errors_   = 0;
+
+    void begin(Kind k, uint64_t session, int64_t now_us) {
+        buf_.push_back(static_cast<char>(k));
+        // Relgio de parede pode voltar: o delta nunca  negativo
+        put_varint(buf_, now_us > last_us_ ? uint64_t(now_us - last_us_) : 0);
+        if (now_us > last_us_) last_us_ = now_us;
+        put_varint(buf_, session);
+        ++records_;
+    }
+    void maybe_flush() { if (buf_.size() >= kFlushAt) flush(); }
+};
+
+// --------- Leitura (chat_replay) ----------
+class Reader {
+public:
+    Reader() = default;
+    ~Reader() { if (fd_ >= 0) ::close(fd_); }
+    Reader(const Reader&) = delete;
+    Reader& operator=(const Reader&) = delete;
+
+    bool open(const std::string& path) {
+        fd_ = ::open(path.c_str(), O_RDONLY | O_CLOEXEC);
+        if (fd_ < 0 || !fill(kHeaderLen) || std::memcmp(buf_.data(), kMagic, sizeof(kMagic)) != 0) return false;
+        uint64_t start = 0;
+        for (int i = 0; i < 8; ++i) start |= uint64_t(static_cast<uint8_t>(buf_[8 + i])) << (8 * i);
+        start_us_ = static_cast<int64_t>(start);
+        now_us_   = start_us_;
+        pos_      = kHeaderLen;
+        return true;
+    }
+
+    int64_t start_us() const { return start_us_; }
+
+    // Prximo evento; false no fim do arquivo (ou registro truncado).
+    bool next(Event& ev) {
+        uint64_t delta = 0, v = 0;
+        if (!fill(1)) return false;
+        const auto k = static_cast<Kind>(buf_[pos_++]);
+        if (!varint(delta) || !varint(ev.session)) return false;
+        now_us_ += static_cast<int64_t>(delta);
+        ev.kind  = k;
+        ev.ts_us = now_us_;
+        switch (k) {
+        case Kind::Connect:
+            if (!varint(ev.fd)) return false;
+            return true;
+        case Kind::Line:
+            if (!varint(v) || !fill(v)) return false;
+            ev.text.assign(buf_.data() + pos_, v);
+            pos_ += v;
+            return true;
+        case Kind::Disconnect:
+            return true;
+        case Kind::Payload:
+            return varint(ev.size);
+        }
+        return false; // tipo desconhecido: arquivo corrompido
+    }
+
+private:
+    int         fd_ = -1;
+    std::string buf_;
+    size_t      pos_ = 0;
+    int64_t     start_us_ = 0, now_us_ = 0;
+
+    // Garante `n` bytes a partir de pos_.
+    bool fill(size_t n) {
+        if (buf_.size() - pos_ >= n) return true;
+        buf_.erase(0, pos_);
+        pos_ = 0;
+        char tmp[64 * 1024];
+        while (buf_.size() < n) {
+            ssize_t r = ::read(fd_, tmp, sizeof(tmp));
+            if (r < 0 && errno == EINTR) continue;
+            if (r <= 0) return false;
+            buf_.append(tmp, static_cast<size_t>(r));
+        }
+        return true;
+    }
+
+    bool varint(uint64_t& out) {
+        out = 0;
+        for (int shift = 0; shift < 64; shift += 7) {
+            if (!fill(1)) return false;
+            const uint8_t b = static_cast<uint8_t>(buf_[pos_++]);
+            out |= uint64_t(b & 0x7f) << shift;
+            if (!(b & 0x80)) return true;
+        }
+        return false;
+    }
+};
+
+} // namespace capture
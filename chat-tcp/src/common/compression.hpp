@@ -0,0 +1,140 @@
+#pragma once
+#include <algorithm>
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <time.h>
+#include <zlib.h>
+
+// Compresso de fluxo da sada para clientes que a pedem com
+// "/compress deflate" (deflate cru, RFC 1951). O pedido sempre tem
+// resposta: "* compress deflate" como primeira linha da conexo, antes do
+// histrico, ou "* compress off". Cada sesso tem o seu
+// contexto: a janela de 32 KiB com o texto j enviado serve de dicionrio
+// para as prximas mensagens, ento apelidos e trechos repetidos viram
+// referncias curtas. Cada envio termina em Z_SYNC_FLUSH: os bytes at ali
+// decodificam por inteiro, sem esperar o prximo envio.
+//
+// O histrico de quem entra  comprimido uma vez por verso (pack), no
+// nvel mais alto, e o mesmo bloco vai para todos. A sesso comea com o fim desse texto como
+// dicionrio (Deflater::prime): os blocos dela continuam o fluxo do bloco
+// compartilhado, e o descompressor do cliente, que j tem esse texto na
+// janela, decodifica as referncias a ele.
+namespace compression {
+
+inline constexpr uint32_t kDeflate  = 1u << 1; // Connection::features
+inline constexpr int      kWindow   = 15;      // janela de 32 KiB
+inline constexpr int      kMemLevel = 5;       // tabela de hash menor: ~144 KiB por sesso
+inline constexpr size_t   kDictMax  = size_t(1) << kWindow;
+inline constexpr int      kPackLevel = Z_BEST_COMPRESSION; // bloco compartilhado: comprimido uma vez
+
+// Estado do deflate por sesso (frmula do zlib), para o oramento de memria
+inline constexpr size_t kStateBytes = (size_t(1) << (kWindow + 2)) + (size_t(1) << (kMemLevel + 9));
+
+struct Stats {
+    uint64_t plain  = 0; // bytes de texto que entraram
+    uint64_t packed = 0; // bytes comprimidos que saram
+    uint64_t cpu_ns = 0; // CPU gasta comprimindo
+};
+inline Stats& stats() { static Stats s; return s; }
+
+inline uint64_t thread_cpu_ns() {
+    timespec ts;
+    ::clock_gettime(CLOCK_THREAD_CPUTIME_ID, &ts);
+    return static_cast<uint64_t>(ts.tv_sec) * 1000000000 + static_cast<uint64_t>(ts.tv_nsec);
+}
+
+class Deflater {
+public:
+    // level: 1 (mais rpido) a 9 (menor)
+    explicit Deflater(int level) {
+        ok_ = ::deflateInit2(&z_, level, Z_DEFLATED, -kWindow, kMemLevel, Z_DEFAULT_STRATEGY) == Z_OK;
+    }
+    ~Deflater() { if (ok_) ::deflateEnd(&z_); }
+    Deflater(const Deflater&) = delete;
+    Deflater& operator=(const Deflater&) = delete;
+
+    bool ok() const { return ok_; }
+
+    // Antes do primeiro compress(): as mensagens seguintes podem referenciar
+    // o fim de `plain`, que o cliente j decodificou de um bloco compartilhado.
+    bool prime(std::string_view plain) {
+        if (!ok_ || plain.empty()) return ok_;
+        if (plain.size() > kDictMax) plain.remove_prefix(plain.size() - kDictMax);
+        return ::deflateSetDictionary(&z_, reinterpret_cast<const Bytef*>(plain.data()),
+                                      static_cast<uInt>(plain.size())) == Z_OK;
+    }
+
+    // Acrescenta a `out` a verso comprimida de `in`, terminada em sync flush.
+    bool compress(std::string_view in, std::string& out) {
+        if (!ok_) return false;
+        const uint64_t t0 = thread_cpu_ns();
+        const size_t before = out.size();
+        z_.next_in  = reinterpret_cast<Bytef*>(const_cast<char*>(in.data()));
+        z_.avail_in = static_cast<uInt>(in.size());
+        bool done = false;
+        while (!done) {
+            const size_t old  = out.size();
+            const size_t room = std::max<size_t>(256, in.size() / 2);
+            out.resize(old + room);
+            z_.next_out  = reinterpret_cast<Bytef*>(out.data() + old);
+            z_.avail_out = static_cast<uInt>(room);
+            const int rc = ::deflate(&z_, Z_SYNC_FLUSH);
+            // Sobrou espao: a entrada acabou e o flush saiu por inteiro
+            done = z_.avail_out != 0;
+            out.resize(old + room - z_.avail_out);
+            if (rc != Z_OK && rc != Z_BUF_ERROR) return false;
+        }
+        auto& s = stats();
+        s.plain  += in.size();
+        s.packed += out.size() - before;
+        s.cpu_ns += thread_cpu_ns() - t0;
+        return true;
+    }
+
+private:
+    z_stream z_{};
+    bool     ok_ = false;
+};
+
+// Bloco avulso (o histrico de quem entra): incio de um fluxo, terminado em
+// sync flush, para ser seguido pelos blocos de uma sesso preparada com
+// prime(plain). Vazio em erro.
+inline std::string pack(std::string_view plain, int level) {
+    std::string out;
+    Deflater z(level);
+    if (!z.compress(plain, out)) out.clear();
+    return out;
+}
+
+// Descompressor do fluxo (o cliente usa o seu, em libchatclient; este serve
+// s ferramentas que conferem a ida e volta)
+class Inflater {
+public:
+    Inflater() { ok_ = ::inflateInit2(&z_, -kWindow) == Z_OK; }
+    ~Inflater() { if (ok_) ::inflateEnd(&z_); }
+    Inflater(const Inflater&) = delete;
+    Inflater& operator=(const Inflater&) = delete;
+
+    // Acrescenta a `out` o texto de `in`. false em dados invlidos.
+    bool feed(std::string_view in, std::string& out) {
+        if (!ok_) return false;
+        z_.next_in  = reinterpret_cast<Bytef*>(const_cast<char*>(in.data()));
+        z_.avail_in = static_cast<uInt>(in.size());
+        for (;;) {
+            char buf[64 * 1024];
+            z_.next_out  = reinterpret_cast<Bytef*>(buf);
+            z_.avail_out = sizeof(buf);
+            const int rc = ::inflate(&z_, Z_SYNC_FLUSH);
+            out.append(buf, sizeof(buf) - z_.avail_out);
+            if (rc != Z_OK && rc != Z_BUF_ERROR) return false;
+            if (z_.avail_out != 0) return z_.avail_in == 0;
+        }
+    }
+
+private:
+    z_stream z_{};
+    bool     ok_ = false;
+};
+
+} // namespace compression
@@ -0,0 +1,121 @@
+#pragma once
+#include <coroutine>
+#include <exception>
+#include <optional>
+#include <utility>
+
+#include "common/pool.hpp"
+
+// Corrotinas do projeto (C++20).
+//  - Task<T>: preguiosa; s comea no co_await e, ao terminar, devolve o
+//    controle a quem aguardava (transferncia simtrica, sem recurso).
+//  - spawn(): dispara uma Task<> "solta", que libera o prprio frame ao fim.
+// Os frames vm do pool (common/pool.hpp), no do malloc.
+
+template<typename T = void> class Task;
+
+namespace coro_detail {
+
+struct FinalAwaiter {
+    bool await_ready() noexcept { return false; }
+    template<typename P>
+    std::coroutine_handle<> await_suspend(std::coroutine_handle<P> h) noexcept {
+        auto next = h.promise().continuation;
+        return next ? next : std::noop_coroutine();
+    }
+    void await_resume() noexcept {}
+};
+
+struct PooledFrame {
+    static void* operator new(size_t n) { return pool::allocate(n); }
+    static void  operator delete(void* p, size_t n) noexcept { pool::deallocate(p, n); }
+};
+
+struct PromiseBase : PooledFrame {
+    std::coroutine_handle<> continuation;
+    std::exception_ptr      error;
+
+    std::suspend_always initial_suspend() noexcept { return {}; }
+    FinalAwaiter        final_suspend() noexcept { return {}; }
+    void unhandled_exception() noexcept { error = std::current_exception(); }
+};
+
+template<typename T>
+struct Promise : PromiseBase {
+    std::optional<T> value;
+
+    Task<T> get_return_object() noexcept;
+    template<typename U>
+    void return_value(U&& v) { value.emplace(std::forward<U>(v)); }
+    T take() {
+        if (error) std::rethrow_exception(error);
+        return std::move(*value);
+    }
+};
+
+template<>
+struct Promise<void> : PromiseBase {
+    Task<void> get_return_object() noexcept;
+    void return_void() noexcept {}
+    void take() { if (error) std::rethrow_exception(error); }
+};
+
+} // namespace coro_detail
+
+template<typename T>
+class Task {
+public:
+    using promise_type = coro_detail::Promise<T>;
+    using handle_type  = std::coroutine_handle<promise_type>;
+
+    explicit Task(handle_type h) noexcept : h_(h) {}
+    Task(Task&& o) noexcept : h_(std::exchange(o.h_, {})) {}
+    Task& operator=(Task&& o) noexcept {
+        if (this != &o) { if (h_) h_.destroy(); h_ = std::exchange(o.h_, {}); }
+        return *this;
+    }
+    Task(const Task&) = delete;
+    Task& operator=(const Task&) = delete;
+    ~Task() { if (h_) h_.destroy(); }
+
+    struct Awaiter {
+        handle_type h;
+        bool await_ready() const noexcept { return !h || h.done(); }
+        std::coroutine_handle<> await_suspend(std::coroutine_handle<> caller) noexcept {
+            h.promise().continuation = caller;
+            return h;
+        }
+        T await_resume() { return h.promise().take(); }
+    };
+    Awaiter operator co_await() const noexcept { return Awaiter{h_}; }
+
+private:
+    handle_type h_;
+};
+
+namespace coro_detail {
+
+template<typename T>
+Task<T> Promise<T>::get_return_object() noexcept {
+    return Task<T>{std::coroutine_handle<Promise<T>>::from_promise(*this)};
+}
+inline Task<void> Promise<void>::get_return_object() noexcept {
+    return Task<void>{std::coroutine_handle<Promise<void>>::from_promise(*this)};
+}
+
+// Corrotina ansiosa que se autodestri: base de spawn().
+struct Detached {
+    struct promise_type : PooledFrame {
+        Detached get_return_object() noexcept { return {}; }
+        std::suspend_never initial_suspend() noexcept { return {}; }
+        std::suspend_never final_suspend() noexcept { return {}; }
+        void return_void() noexcept {}
+        void unhandled_exception() noexcept { std::terminate(); }
+    };
+};
+
+} // namespace coro_detail
+
+// Executa a tarefa imediatamente at a primeira suspenso; o restante roda
+// quando o loop de eventos a retomar.
+inline coro_detail::Detached spawn(Task<> t) { co_await t; }
@@ -0,0 +1,462 @@
+#pragma once
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <coroutine>
+#include <deque>
+#include <memory>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <vector>
+#include <cerrno>
+#include <unistd.h>
+#include <sys/epoll.h>
+#include <sys/eventfd.h>
+#include <sys/socket.h>
+#include <time.h>
+
+#include "common/coro.hpp"
+#include "common/net.hpp"
+#include "common/timer_wheel.hpp"
+
+// Loop de eventos (epoll edge-triggered) que retoma corrotinas quando seus
+// descritores ficam prontos. Cada fd tem no mximo um leitor e um escritor
+// aguardando. As operaes assncronas sempre tentam a syscall antes de
+// suspender, ento o modo edge-triggered no perde eventos.
+//
+// Nada  feito por polling: o epoll_wait dorme at um fd ficar pronto, o
+// prximo temporizador vencer (TimerWheel) ou outra thread chamar
+// request_stop() (eventfd). Ocioso e sem temporizadores, o loop no acorda.
+class EventLoop {
+public:
+    EventLoop()
+      : ep_(::epoll_create1(EPOLL_CLOEXEC)),
+        efd_(::eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC)),
+        timers_(clock_ms()) {
+        if (ep_ >= 0 && efd_ >= 0) {
+            epoll_event ev{};
+            ev.events  = EPOLLIN;
+            ev.data.fd = efd_;
+            if (::epoll_ctl(ep_, EPOLL_CTL_ADD, efd_, &ev) < 0) { ::close(efd_); efd_ = -1; }
+        }
+    }
+    ~EventLoop() {
+        if (efd_ >= 0) ::close(efd_);
+        if (ep_ >= 0) ::close(ep_);
+    }
+    EventLoop(const EventLoop&) = delete;
+    EventLoop& operator=(const EventLoop&) = delete;
+
+    bool ok() const { return ep_ >= 0 && efd_ >= 0; }
+    bool stopping() const { return stopping_; }
+
+    // Relgio monotnico em ms (base dos temporizadores).
+    static uint64_t clock_ms() {
+        timespec ts;
+        ::clock_gettime(CLOCK_MONOTONIC, &ts);
+        return static_cast<uint64_t>(ts.tv_sec) * 1000 + static_cast<uint64_t>(ts.tv_nsec) / 1000000;
+    }
+
+    TimerWheel& timers() { return timers_; }
+
+    // Pede o fim de run(); pode ser chamado de qualquer thread.
+    void request_stop() {
+        quit_.store(true);
+        const uint64_t one = 1;
+        [[maybe_unused]] ssize_t n = ::write(efd_, &one, sizeof(one));
+    }
+
+    // Registra um fd (j no bloqueante) para leitura e escrita.
+    bool watch(int fd) {
+        epoll_event ev{};
+        ev.events  = EPOLLIN | EPOLLOUT | EPOLLRDHUP | EPOLLET;
+        ev.data.fd = fd;
+        if (::epoll_ctl(ep_, EPOLL_CTL_ADD, fd, &ev) < 0) return false;
+        slot(fd) = {};
+        return true;
+    }
+
+    // Remove o fd e acorda quem estiver esperando por ele.
+    void forget(int fd) {
+        ::epoll_ctl(ep_, EPOLL_CTL_DEL, fd, nullptr);
+        if (fd >= 0 && static_cast<size_t>(fd) < waiters_.size()) {
+            wake(waiters_[fd].rd);
+            wake(waiters_[fd].wr);
+            wake(waiters_[fd].err);
+        }
+    }
+
+    // Retoma o leitor do fd sem que haja dados (ele volta a testar o socket).
+    // Usado para prazos: quem espera confere se o tempo acabou.
+    void wake_reader(int fd) {
+        if (fd >= 0 && static_cast<size_t>(fd) < waiters_.size()) wake(waiters_[fd].rd);
+    }
+
+    // Agenda a retomada de uma corrotina na prxima volta do loop.
+    void post(std::coroutine_handle<> h) { ready_.push_back(h); }
+
+    struct FdAwaiter {
+        EventLoop& loop;
+        int        fd;
+        bool       write;
+        bool await_ready() const noexcept { return loop.stopping_; }
+        void await_suspend(std::coroutine_handle<> h) {
+            auto& w = loop.slot(fd);
+            (write ? w.wr : w.rd) = h;
+        }
+        void await_resume() const noexcept {}
+    };
+    FdAwaiter readable(int fd) { return FdAwaiter{*this, fd, false}; }
+    FdAwaiter writable(int fd) { return FdAwaiter{*this, fd, true}; }
+
+    // Espera EPOLLERR no fd: algo novo na errqueue (concluses de
+    // MSG_ZEROCOPY) ou erro do socket. Leitor e escritor acordam tambm.
+    struct ErrAwaiter {
+        EventLoop& loop;
+        int        fd;
+        bool await_ready() const noexcept { return loop.stopping_; }
+        void await_suspend(std::coroutine_handle<> h) { loop.slot(fd).err = h; }
+        void await_resume() const noexcept {}
+    };
+    ErrAwaiter errored(int fd) { return ErrAwaiter{*this, fd}; }
+
+    // Cede a vez: retoma a corrotina depois de tudo o que j est agendado.
+    struct TickAwaiter {
+        EventLoop& loop;
+        bool await_ready() const noexcept { return false; }
+        void await_suspend(std::coroutine_handle<> h) { loop.post(h); }
+        void await_resume() const noexcept {}
+    };
+    TickAwaiter next_tick() { return TickAwaiter{*this}; }
+
+    // Cede a vez at a prxima volta do loop: eventos de I/O e temporizadores
+    // que chegarem at l passam antes (next_tick s reordena a rodada atual).
+    struct RoundAwaiter {
+        EventLoop& loop;
+        bool await_ready() const noexcept { return loop.stopping_; }
+        void await_suspend(std::coroutine_handle<> h) { loop.deferred_.push_back(h); }
+        void await_resume() const noexcept {}
+    };
+    RoundAwaiter next_round() { return RoundAwaiter{*this}; }
+
+    // Suspende por `d` (temporizador da roda; nenhum fd envolvido).
+    // Retorna antes no encerramento.
+    struct SleepAwaiter {
+        EventLoop&                loop;
+        std::chrono::milliseconds d;
+        Timer                     timer{};
+        bool await_ready() const noexcept { return loop.stopping_; }
+        void await_suspend(std::coroutine_handle<> h) {
+            timer.set_callback([this, h] { loop.post(h); });
+            loop.timers_.schedule(timer, static_cast<uint64_t>(std::max<int64_t>(d.count(), 0)));
+        }
+        void await_resume() const noexcept {}
+    };
+    SleepAwaiter sleep_for(std::chrono::milliseconds d) { return SleepAwaiter{*this, d}; }
+
+    // Despacha eventos e temporizadores at request_stop().
+    void run() {
+        epoll_event evs[64];
+        for (;;) {
+            timers_.advance(clock_ms());
+            drain();
+            if (quit_.load()) break;
+            // Com algum esperando a prxima volta, s espia os eventos
+            const int timeout = deferred_.empty() ? timers_.next_delay(clock_ms()) : 0;
+            int n = ::epoll_wait(ep_, evs, 64, timeout);
+            if (n < 0) {
+                if (errno == EINTR) continue;
+                break;
+            }
+            for (int i = 0; i < n; ++i) {
+                if (evs[i].data.fd == efd_) {
+                    uint64_t v;
+                    [[maybe_unused]] ssize_t r = ::read(efd_, &v, sizeof(v));
+                    continue;
+                }
+                auto& w = slot(evs[i].data.fd);
+                const uint32_t e = evs[i].events;
+                if (e & (EPOLLIN | EPOLLRDHUP | EPOLLHUP | EPOLLERR)) wake(w.rd);
+                if (e & (EPOLLOUT | EPOLLHUP | EPOLLERR))             wake(w.wr);
+                if (e & (EPOLLHUP | EPOLLERR))                        wake(w.err);
+            }
+            for (auto h : deferred_) post(h);
+            deferred_.clear();
+        }
+    }
+
+    // Encerramento: toda corrotina pendente em I/O ou em temporizador 
+    // acordada e, daqui em diante, as operaes assncronas falham sem
+    // suspender.
+    void stop() {
+        stopping_ = true;
+        for (auto& w : waiters_) { wake(w.rd); wake(w.wr); wake(w.err); }
+        for (auto h : deferred_) post(h);
+        deferred_.clear();
+        timers_.expire_all();
+        drain();
+    }
+
+    // Retoma tudo o que estiver agendado.
+    void drain() {
+        while (!ready_.empty()) {
+            batch_.swap(ready_);
+            for (auto h : batch_) h.resume();
+            batch_.clear();
+        }
+    }
+
+private:
+    struct Waiters {
+        std::coroutine_handle<> rd;
+        std::coroutine_handle<> wr;
+        std::coroutine_handle<> err; // errored()
+    };
+
+    int  ep_;
+    int  efd_;                  // eventfd: acorda o epoll_wait (request_stop)
+    bool stopping_ = false;
+    std::atomic_bool quit_{false};
+    TimerWheel       timers_;
+    std::vector<Waiters>                 waiters_; // indexado por fd
+    std::vector<std::coroutine_handle<>> ready_;
+    std::vector<std::coroutine_handle<>> batch_;
+    std::vector<std::coroutine_handle<>> deferred_; // next_round()
+
+    Waiters& slot(int fd) {
+        if (static_cast<size_t>(fd) >= waiters_.size()) waiters_.resize(fd + 1);
+        return waiters_[fd];
+    }
+    void wake(std::coroutine_handle<>& h) {
+        if (h) { post(h); h = {}; }
+    }
+};
+
+// --------- Conexo no bloqueante e operaes assncronas ----------
+
+// Envios com MSG_ZEROCOPY ainda no concludos pelo kernel (common/zerocopy.hpp):
+// cada um segura o buffer enviado at a notificao chegar pela errqueue.
+struct ZeroCopyState {
+    bool     enabled = false; // SO_ZEROCOPY aceito e ainda vale a pena
+    uint32_t next_id = 0;     // contador de envios do kernel neste socket
+    uint32_t checked = 0;     // concluses vistas (decide o recuo para cpia)
+    uint32_t copied  = 0;     // ... das quais o kernel acabou copiando
+    bool     reaping = false; // zerocopy::reaper esperando a errqueue
+    std::deque<std::pair<uint32_t, std::shared_ptr<const void>>> inflight;
+};
+
+struct Connection {
+    int         fd = -1;
+    uint64_t    id = 0;          // identidade dada pela aplicao (o nmero do fd se repete)
+    uint32_t    features = 0;    // capacidades negociadas pela aplicao (bits)
+    std::string in;              // bytes recebidos ainda no consumidos
+    std::string out;             // bytes aguardando espao no socket
+    bool        flushing = false; // h uma corrotina escoando `out`
+    bool        closed   = false;
+    size_t      line_max  = 0;     // linha mais longa aceita (0 = sem limite)
+    uint64_t    oversized = 0;     // linhas descartadas por passar do limite
+    bool        skipping  = false; // descartando o resto de uma linha longa
+    ZeroCopyState zc;
+    std::vector<std::coroutine_handle<>> writers; // esperam `flushing` cair (WriterAwaiter)
+};
+
+inline void close_connection(EventLoop& loop, Connection& c) {
+    if (c.closed) return;
+    c.closed = true;
+    loop.forget(c.fd);
+    ::close(c.fd);
+}
+
+// Tenta enviar sem bloquear. Retorna bytes enviados (0 se o socket est
+// cheio) ou -1 em erro.
+inline ssize_t send_some(int fd, const char* p, size_t len) {
+    for (;;) {
+        ssize_t n = ::send(fd, p, len, MSG_NOSIGNAL | MSG_DONTWAIT);
+        if (n >= 0) return n;
+        if (errno == EINTR) continue;
+        if (errno == EAGAIN || errno == EWOULDBLOCK) return 0;
+        return -1;
+    }
+}
+
+// Aceita a prxima conexo (j no bloqueante). Retorna -1 no encerramento.
+inline Task<int> async_accept(EventLoop& loop, int listen_fd) {
+    for (;;) {
+        if (loop.stopping()) co_return -1;
+        int fd = ::accept4(listen_fd, nullptr, nullptr, SOCK_NONBLOCK | SOCK_CLOEXEC);
+        if (fd >= 0) co_return fd;
+        int e = errno;
+        if (e == EINTR || e == ECONNABORTED) continue;
+        if (e == EBADF || e == EINVAL) co_return -1; // listen_fd fechado
+        // EAGAIN ou erro transitrio (ex.: EMFILE): espera nova atividade
+        co_await loop.readable(listen_fd);
+    }
+}
+
+// Conecta a host:porta sem bloquear. Retorna o fd j registrado no loop,
+// ou -1 em falha/encerramento.
+inline Task<int> async_connect(EventLoop& loop, std::string_view host, uint16_t port) {
+    sockaddr_in addr{};
+    if (loop.stopping() || !make_addr(host, port, addr)) co_return -1;
+    int fd = ::socket(AF_INET, SOCK_STREAM | SOCK_NONBLOCK | SOCK_CLOEXEC, 0);
+    if (fd < 0) co_return -1;
+    if (!loop.watch(fd)) { ::close(fd); co_return -1; }
+    if (::connect(fd, (sockaddr*)&addr, sizeof(addr)) < 0) {
+        if (errno != EINPROGRESS) { loop.forget(fd); ::close(fd); co_return -1; }
+        co_await loop.writable(fd);
+        int err = 0; socklen_t len = sizeof(err);
+        if (loop.stopping() || ::getsockopt(fd, SOL_SOCKET, SO_ERROR, &err, &len) < 0 || err != 0) {
+            loop.forget(fd); ::close(fd); co_return -1;
+        }
+    }
+    co_return fd;
+}
+
+// Suspende por `d`. Retorna antes no encerramento.
+inline Task<> async_sleep(EventLoop& loop, std::chrono::milliseconds d) {
+    co_await loop.sleep_for(d);
+}
+
+// Tira de c.in a prxima linha completa (sem o '\n'); `scanned` guarda at
+// onde j se procurou. Com c.line_max, uma linha mais longa  descartada
+// inteira, at o '\n' dela, e contada em c.oversized: o acumulado de quem
+// nunca manda '\n' no passa do limite.
+inline bool take_line(Connection& c, std::string& line, size_t& scanned) {
+    for (;;) {
+        const size_t pos = c.in.find('\n', scanned);
+        if (pos == std::string::npos) break;
+        const bool drop = c.skipping || (c.line_max && pos > c.line_max);
+        if (drop && !c.skipping) ++c.oversized;
+        if (!drop) line.assign(c.in, 0, pos);
+        c.in.erase(0, pos + 1);
+        c.skipping = false;
+        scanned = 0;
+        if (!drop) return true;
+    }
+    scanned = c.in.size();
+    if (c.line_max && c.in.size() > c.line_max) {
+        if (!c.skipping) ++c.oversized;
+        c.skipping = true;
+        c.in.clear();
+        scanned = 0;
+    }
+    return false;
+}
+
+// L a prxima linha (sem o '\n') para `line`, reaproveitando a capacidade
+// dele. false em EOF, erro ou encerramento.
+inline Task<bool> async_read_line(EventLoop& loop, Connection& c, std::string& line) {
+    size_t scanned = 0;
+    for (;;) {
+        if (take_line(c, line, scanned)) co_return true;
+        if (c.closed || loop.stopping()) co_return false;
+
+        const size_t old = c.in.size();
+        c.in.resize(old + 4096);
+        ssize_t n = ::recv(c.fd, c.in.data() + old, 4096, 0);
+        c.in.resize(old + (n > 0 ? static_cast<size_t>(n) : 0));
+        if (n > 0) continue;
+        if (n == 0) co_return false; // desconectou
+        if (errno == EINTR) continue;
+        if (errno != EAGAIN && errno != EWOULDBLOCK) co_return false;
+        co_await loop.readable(c.fd);
+    }
+}
+
+// Como async_read_line, mas desiste se nenhuma linha completa chegar em
+// `timeout`. Retorna 1 (linha lida), 0 (prazo esgotado) ou -1 (EOF/erro).
+inline Task<int> async_read_line(EventLoop& loop, Connection& c, std::string& line,
+                                 std::chrono::milliseconds timeout) {
+    bool expired = false;
+    Timer deadline([&] { expired = true; loop.wake_reader(c.fd); });
+    loop.timers().schedule(deadline, static_cast<uint64_t>(timeout.count()));
+    size_t scanned = 0;
+    for (;;) {
+        if (take_line(c, line, scanned)) co_return 1;
+        if (c.closed || loop.stopping()) co_return -1;
+
+        const size_t old = c.in.size();
+        c.in.resize(old + 4096);
+        ssize_t n = ::recv(c.fd, c.in.data() + old, 4096, 0);
+        c.in.resize(old + (n > 0 ? static_cast<size_t>(n) : 0));
+        if (n > 0) continue;
+        if (n < 0 && errno == EINTR) continue;
+        if (n == 0 || (errno != EAGAIN && errno != EWOULDBLOCK)) co_return -1;
+        if (expired) co_return 0;
+        co_await loop.readable(c.fd);
+    }
+}
+
+// Quem precisa da escrita s para si (splicing::send_file) espera aqui at
+// quem escoa `out` terminar; release_writer devolve a vez.
+struct WriterAwaiter {
+    Connection& c;
+    bool await_ready() const noexcept { return !c.flushing || c.closed; }
+    void await_suspend(std::coroutine_handle<> h) { c.writers.push_back(h); }
+    void await_resume() const noexcept {}
+};
+
+inline void release_writer(EventLoop& loop, Connection& c) {
+    c.flushing = false;
+    for (auto h : c.writers) loop.post(h);
+    c.writers.clear();
+}
+
+// Envia `data` por completo, suspendendo enquanto o socket estiver cheio.
+// Se outra corrotina j est escoando a conexo, apenas anexa os bytes ao
+// buffer de sada (a ordem  preservada) e retorna.
+inline Task<bool> async_send(EventLoop& loop, Connection& c, std::string_view data) {
+    if (c.closed) co_return false;
+    if (c.flushing) { c.out.append(data); co_return true; }
+
+    // Caminho rpido: nada pendente, envia direto do buffer de quem chamou
+    if (c.out.empty()) {
+        ssize_t n = send_some(c.fd, data.data(), data.size());
+        if (n < 0) co_return false;
+        if (static_cast<size_t>(n) == data.size()) co_return true;
+        data.remove_prefix(static_cast<size_t>(n));
+    }
+    c.out.append(data);
+
+    c.flushing = true;
+    bool ok = true;
+    while (!c.out.empty()) {
+        ssize_t n = send_some(c.fd, c.out.data(), c.out.size());
+        if (n < 0) { ok = false; break; }
+        c.out.erase(0, static_cast<size_t>(n));
+        if (c.out.empty()) break;
+        if (n == 0) {
+            co_await loop.writable(c.fd);
+            if (c.closed || loop.stopping()) { ok = false; break; }
+        }
+    }
+    release_writer(loop, c);
+    co_return ok;
+}
+
+namespace event_loop_detail {
+inline Task<> flush_owned(EventLoop& loop, std::shared_ptr<Connection> c, std::string_view data) {
+    // Resultado num local: "if (!co_await ...)" com a Task temporria faz o
+    // GCC 12 destruir o frame num ponto de suspenso invlido (ud2)
+    const bool ok = co_await async_send(loop, *c, data);
+    if (!ok) close_connection(loop, *c);
+}
+} // namespace event_loop_detail
+
+// Como async_send, mas nunca suspende quem chama: o que no couber no socket
+// fica com uma corrotina de escoamento dedicada. Retorna false se a conexo
+// j est fechada ou falhou de imediato.
+inline bool send_nowait(EventLoop& loop, const std::shared_ptr<Connection>& c, std::string_view data) {
+    if (c->closed) return false;
+    if (c->flushing) { c->out.append(data); return true; }
+    if (c->out.empty()) {
+        ssize_t n = send_some(c->fd, data.data(), data.size());
+        if (n < 0) return false;
+        if (static_cast<size_t>(n) == data.size()) return true;
+        data.remove_prefix(static_cast<size_t>(n));
+    }
+    // `data`  copiado para c->out antes da primeira suspenso
+    spawn(event_loop_detail::flush_owned(loop, c, data));
+    return true;
+}
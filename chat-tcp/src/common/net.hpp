@@ -2,11 +2,15 @@
 #include <string>
 #include <string_view>
 #include <cerrno>
+#include <cstddef>
 #include <cstring>
 #include <unistd.h>
+#include <fcntl.h>
 #include <sys/socket.h>
 #include <arpa/inet.h>
 #include <netinet/in.h>
+#include <sys/stat.h>
+#include <sys/un.h>
 
 inline int make_server_socket(uint16_t port, int backlog = 64) {
     int fd = ::socket(AF_INET, SOCK_STREAM, 0);
@@ -25,19 +29,81 @@ inline int make_server_socket(uint16_t port, int backlog = 64) {
     return fd;
 }
 
+inline bool make_addr(std::string_view host, uint16_t port, sockaddr_in& addr) {
+    addr = sockaddr_in{};
+    addr.sin_family = AF_INET;
+    addr.sin_port   = htons(port);
+    return ::inet_pton(AF_INET, std::string(host).c_str(), &addr.sin_addr) > 0;
+}
+
 inline int connect_to(std::string_view host, uint16_t port) {
     int fd = ::socket(AF_INET, SOCK_STREAM, 0);
     if (fd < 0) return -1;
 
     sockaddr_in addr{};
-    addr.sin_family = AF_INET;
-    addr.sin_port   = htons(port);
-    if (::inet_pton(AF_INET, std::string(host).c_str(), &addr.sin_addr) <= 0) { ::close(fd); return -1; }
+    if (!make_addr(host, port, addr)) { ::close(fd); return -1; }
 
     if (::connect(fd, (sockaddr*)&addr, sizeof(addr)) < 0) { ::close(fd); return -1; }
     return fd;
 }
 
+// --------- AF_UNIX (clientes no mesmo host) ----------
+// Mesmo protocolo de linhas, sem a pilha TCP: sem checksum, sem Nagle,
+// sem ACKs. Um socket antigo que sobrou no caminho  removido no bind, mas
+// s se for um socket e ningum responder nele (errno explica a recusa).
+inline bool make_unix_addr(std::string_view path, sockaddr_un& addr, socklen_t& len) {
+    addr = sockaddr_un{};
+    addr.sun_family = AF_UNIX;
+    if (path.empty() || path.size() >= sizeof(addr.sun_path)) return false;
+    std::memcpy(addr.sun_path, path.data(), path.size());
+    len = static_cast<socklen_t>(offsetof(sockaddr_un, sun_path) + path.size() + 1);
+    return true;
+}
+
+// Remove o que sobrou de um servidor que morreu sem apagar o socket.
+// false (sem tocar no caminho) se ali h outro tipo de arquivo (EEXIST) ou
+// um servidor vivo (EADDRINUSE).
+inline bool remove_stale_unix_socket(const std::string& path, const sockaddr_un& addr, socklen_t len) {
+    struct stat st;
+    if (::lstat(path.c_str(), &st) < 0) return errno == ENOENT;
+    if (!S_ISSOCK(st.st_mode)) { errno = EEXIST; return false; }
+    int probe = ::socket(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC | SOCK_NONBLOCK, 0);
+    if (probe < 0) return false;
+    const bool refused = ::connect(probe, (const sockaddr*)&addr, len) < 0 && errno == ECONNREFUSED;
+    ::close(probe);
+    if (!refused) { errno = EADDRINUSE; return false; }
+    return ::unlink(path.c_str()) == 0 || errno == ENOENT;
+}
+
+inline int make_unix_server_socket(const std::string& path, int backlog = 64) {
+    sockaddr_un addr;
+    socklen_t   len;
+    if (!make_unix_addr(path, addr, len)) { errno = ENAMETOOLONG; return -1; }
+    if (!remove_stale_unix_socket(path, addr, len)) return -1;
+    int fd = ::socket(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0);
+    if (fd < 0) return -1;
+
+    if (::bind(fd, (sockaddr*)&addr, len) < 0) { ::close(fd); return -1; }
+    if (::listen(fd, backlog) < 0) { ::close(fd); ::unlink(path.c_str()); return -1; }
+    return fd;
+}
+
+inline int connect_unix(std::string_view path) {
+    sockaddr_un addr;
+    socklen_t   len;
+    if (!make_unix_addr(path, addr, len)) return -1;
+    int fd = ::socket(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0);
+    if (fd < 0) return -1;
+
+    if (::connect(fd, (sockaddr*)&addr, len) < 0) { ::close(fd); return -1; }
+    return fd;
+}
+
+inline bool set_nonblocking(int fd) {
+    int fl = ::fcntl(fd, F_GETFL, 0);
+    return fl >= 0 && ::fcntl(fd, F_SETFL, fl | O_NONBLOCK) == 0;
+}
+
 inline ssize_t send_all(int fd, const void* buf, size_t len) {
     const char* p = static_cast<const char*>(buf);
     size_t left = len;
@@ -0,0 +1,117 @@
+#pragma once
+#include <array>
+#include <cstddef>
+#include <string>
+#include <string_view>
+#include <vector>
+#include <pthread.h>
+#include <sched.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+
+// Posicionamento de threads: cada papel (loop, io, ...) recebe um conjunto de
+// CPUs e a thread que assume o papel se fixa nele. Memria de trabalho deve
+// ser alocada (e tocada) depois de fixar: pela poltica first-touch do
+// kernel, as pginas ficam no n NUMA da CPU da thread.
+namespace placement {
+
+// Evita falso compartilhamento entre atmicos quentes de threads diferentes.
+inline constexpr size_t kCacheLine = 64;
+
+enum class Role { Loop, Io, Fanout, Count };
+
+inline const char* role_name(Role r) {
+    switch (r) {
+        case Role::Loop:   return "loop";
+        case Role::Io:     return "io";
+        case Role::Fanout: return "fanout";
+        default:           return "?";
+    }
+}
+
+// Conjunto de CPUs por papel (vazio = sem restrio).
+struct Plan {
+    std::array<std::vector<int>, static_cast<size_t>(Role::Count)> cpus;
+
+    const std::vector<int>& of(Role r) const { return cpus[static_cast<size_t>(r)]; }
+    bool empty() const {
+        for (auto& c : cpus) if (!c.empty()) return false;
+        return true;
+    }
+};
+
+// "0-3,6" -> {0,1,2,3,6}. false se malformado.
+inline bool parse_cpus(std::string_view s, std::vector<int>& out) {
+    out.clear();
+    while (!s.empty()) {
+        const size_t comma = s.find(',');
+        std::string_view item = s.substr(0, comma);
+        s = (comma == std::string_view::npos) ? std::string_view{} : s.substr(comma + 1);
+
+        const size_t dash = item.find('-');
+        try {
+            const int lo = std::stoi(std::string(item.substr(0, dash)));
+            const int hi = (dash == std::string_view::npos) ? lo : std::stoi(std::string(item.substr(dash + 1)));
+            if (lo < 0 || hi < lo || hi >= CPU_SETSIZE) return false;
+            for (int c = lo; c <= hi; ++c) out.push_back(c);
+        } catch (...) {
+            return false;
+        }
+    }
+    return !out.empty();
+}
+
+// "<papel>=<cpus>", ex.: "loop=2", "io=4-7" ou "fanout=3-5". "acceptor" e "broadcaster"
+// so aceitos como sinnimos de "loop": rodam na thread do EventLoop.
+inline bool parse_assignment(std::string_view s, Plan& plan) {
+    const size_t eq = s.find('=');
+    if (eq == std::string_view::npos) return false;
+    const std::string_view name = s.substr(0, eq);
+    Role role;
+    if (name == "loop" || name == "acceptor" || name == "broadcaster") role = Role::Loop;
+    else if (name == "io") role = Role::Io;
+    else if (name == "fanout") role = Role::Fanout;
+    else return false;
+    return parse_cpus(s.substr(eq + 1), plan.cpus[static_cast<size_t>(role)]);
+}
+
+// Fixa a thread atual em `cpus` e lhe d um nome (visto em top -H, perf).
+inline bool pin_current(const std::vector<int>& cpus, const char* name = nullptr) {
+    if (name) ::pthread_setname_np(::pthread_self(), name);
+    if (cpus.empty()) return true;
+    cpu_set_t set;
+    CPU_ZERO(&set);
+    for (int c : cpus) CPU_SET(c, &set);
+    return ::pthread_setaffinity_np(::pthread_self(), sizeof(set), &set) == 0;
+}
+
+// i-sima thread de um papel com vrias threads: uma CPU do conjunto cada.
+inline bool pin_worker(const Plan& plan, Role r, size_t i, const char* name = nullptr) {
+    const auto& cpus = plan.of(r);
+    if (cpus.empty()) return pin_current(cpus, name);
+    return pin_current({cpus[i % cpus.size()]}, name);
+}
+
+// N NUMA da CPU em que a thread est agora (0 sem NUMA).
+inline unsigned current_node() {
+    unsigned cpu = 0, node = 0;
+    if (::syscall(SYS_getcpu, &cpu, &node, nullptr) != 0) return 0;
+    return node;
+}
+
+inline std::string describe(const Plan& plan) {
+    std::string s;
+    for (size_t r = 0; r < plan.cpus.size(); ++r) {
+        if (plan.cpus[r].empty()) continue;
+        if (!s.empty()) s += ' ';
+        s += role_name(static_cast<Role>(r));
+        s += '=';
+        for (size_t i = 0; i < plan.cpus[r].size(); ++i) {
+            if (i) s += ',';
+            s += std::to_string(plan.cpus[r][i]);
+        }
+    }
+    return s.empty() ? "sem afinidade" : s;
+}
+
+} // namespace placement
@@ -0,0 +1,216 @@
+#pragma once
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <cstdlib>
+#include <mutex>
+#include <new>
+#include <string>
+#include <vector>
+
+#include "common/placement.hpp"
+
+// Alocador por classes de tamanho (slab) para buffers de mensagem, frames de
+// corrotina e registros de sesso. Cada thread tem um cache por classe; o
+// cache troca lotes com um depsito global, que obtm memria do sistema em
+// slabs de 64 KiB e nunca a devolve. Depois do aquecimento, o trfego em
+// regime no chama malloc: slab_mallocs para de crescer.
+//
+// H um depsito por n NUMA: o cache de uma thread  ligado ao n em que
+// ela roda na primeira alocao (fixe a thread antes, ver placement.hpp), e
+// o slab  preenchido por ela, o que pe as pginas no n local.
+namespace pool {
+
+inline constexpr size_t kMinClass   = 32;        // menor classe (bytes)
+inline constexpr size_t kNumClasses = 8;         // 32, 64, ..., 4096
+inline constexpr size_t kMaxClass   = kMinClass << (kNumClasses - 1);
+inline constexpr size_t kSlabBytes  = 64 * 1024;
+inline constexpr size_t kBatch      = 32;        // objetos por troca cache <-> depsito
+inline constexpr size_t kCacheMax   = 4 * kBatch; // objetos por classe no cache da thread
+inline constexpr size_t kMaxNodes   = 8;         // depsitos (ns NUMA)
+
+struct Stats {
+    uint64_t allocs        = 0; // pedidos atendidos pelas classes
+    uint64_t cache_hits    = 0; // ... sem sair do cache da thread
+    uint64_t slab_mallocs  = 0; // slabs pedidos ao sistema
+    uint64_t large_mallocs = 0; // pedidos acima de kMaxClass (vo direto ao malloc)
+};
+
+namespace detail {
+
+struct Node { Node* next; };
+
+inline size_t class_of(size_t n) {
+    size_t c = 0, sz = kMinClass;
+    while (sz < n) { sz <<= 1; ++c; }
+    return c;
+}
+inline size_t class_size(size_t c) { return kMinClass << c; }
+
+class Depot {
+public:
+    // Retira at kBatch objetos da classe; cria um slab se estiver vazia.
+    Node* take(size_t c, size_t& n) {
+        std::lock_guard<std::mutex> lk(m_);
+        if (!head_[c]) carve(c);
+        Node* first = head_[c];
+        Node* last  = first;
+        n = 1;
+        while (n < kBatch && last->next) { last = last->next; ++n; }
+        head_[c] = last->next;
+        last->next = nullptr;
+        return first;
+    }
+
+    void give(size_t c, Node* first, Node* last) {
+        std::lock_guard<std::mutex> lk(m_);
+        last->next = head_[c];
+        head_[c] = first;
+    }
+
+    // Linha de cache prpria: no disputa com o mutex e as listas acima
+    alignas(placement::kCacheLine) std::atomic<uint64_t> slab_mallocs{0};
+    std::atomic<uint64_t> large_mallocs{0};
+    std::atomic<uint64_t> retired_allocs{0}; // contadores de threads que j terminaram
+    std::atomic<uint64_t> retired_hits{0};
+
+private:
+    std::mutex m_;
+    Node*      head_[kNumClasses] = {};
+
+    void carve(size_t c) {
+        char* slab = static_cast<char*>(std::malloc(kSlabBytes));
+        if (!slab) throw std::bad_alloc();
+        slab_mallocs.fetch_add(1, std::memory_order_relaxed);
+        const size_t sz = class_size(c);
+        Node* prev = nullptr;
+        for (size_t off = kSlabBytes; off >= sz; off -= sz) {
+            auto* node = reinterpret_cast<Node*>(slab + off - sz);
+            node->next = prev;
+            prev = node;
+        }
+        head_[c] = prev;
+    }
+};
+
+inline Depot& depot(unsigned node) {
+    static Depot d[kMaxNodes];
+    return d[node % kMaxNodes];
+}
+
+struct ThreadCache;
+inline std::mutex& registry_mtx() { static std::mutex m; return m; }
+inline std::vector<ThreadCache*>& registry() { static std::vector<ThreadCache*> r; return r; }
+
+struct ThreadCache {
+    Depot&   home = depot(placement::current_node());
+    Node*    head[kNumClasses]  = {};
+    size_t   count[kNumClasses] = {};
+    // S a prpria thread escreve; stats() l de qualquer thread
+    std::atomic<uint64_t> allocs{0}, hits{0};
+
+    ThreadCache() {
+        std::lock_guard<std::mutex> lk(registry_mtx());
+        registry().push_back(this);
+    }
+    ~ThreadCache() {
+        for (size_t c = 0; c < kNumClasses; ++c) {
+            if (!head[c]) continue;
+            Node* last = head[c];
+            while (last->next) last = last->next;
+            home.give(c, head[c], last);
+        }
+        home.retired_allocs.fetch_add(allocs.load(std::memory_order_relaxed), std::memory_order_relaxed);
+        home.retired_hits.fetch_add(hits.load(std::memory_order_relaxed), std::memory_order_relaxed);
+        std::lock_guard<std::mutex> lk(registry_mtx());
+        auto& r = registry();
+        for (auto it = r.begin(); it != r.end(); ++it) if (*it == this) { r.erase(it); break; }
+    }
+
+    void* pop(size_t c) {
+        allocs.store(allocs.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+        if (head[c]) hits.store(hits.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+        else {
+            size_t n = 0;
+            head[c] = home.take(c, n);
+            count[c] = n;
+        }
+        Node* node = head[c];
+        head[c] = node->next;
+        --count[c];
+        return node;
+    }
+
+    void push(size_t c, void* p) {
+        auto* node = static_cast<Node*>(p);
+        node->next = head[c];
+        head[c] = node;
+        if (++count[c] <= kCacheMax) return;
+        // Cache cheio: devolve um lote ao depsito
+        Node* first = head[c];
+        Node* last  = first;
+        for (size_t i = 1; i < kBatch; ++i) last = last->next;
+        head[c] = last->next;
+        count[c] -= kBatch;
+        home.give(c, first, last);
+    }
+};
+
+inline ThreadCache& cache() { thread_local ThreadCache tc; return tc; }
+
+} // namespace detail
+
+inline void* allocate(size_t n) {
+    if (n > kMaxClass) {
+        detail::cache().home.large_mallocs.fetch_add(1, std::memory_order_relaxed);
+        if (void* p = std::malloc(n)) return p;
+        throw std::bad_alloc();
+    }
+    return detail::cache().pop(detail::class_of(n));
+}
+
+inline void deallocate(void* p, size_t n) noexcept {
+    if (!p) return;
+    if (n > kMaxClass) { std::free(p); return; }
+    detail::cache().push(detail::class_of(n), p);
+}
+
+inline Stats stats() {
+    Stats s;
+    for (unsigned n = 0; n < kMaxNodes; ++n) {
+        auto& d = detail::depot(n);
+        s.allocs        += d.retired_allocs.load(std::memory_order_relaxed);
+        s.cache_hits    += d.retired_hits.load(std::memory_order_relaxed);
+        s.slab_mallocs  += d.slab_mallocs.load(std::memory_order_relaxed);
+        s.large_mallocs += d.large_mallocs.load(std::memory_order_relaxed);
+    }
+    std::lock_guard<std::mutex> lk(detail::registry_mtx());
+    for (auto* tc : detail::registry()) {
+        s.allocs     += tc->allocs.load(std::memory_order_relaxed);
+        s.cache_hits += tc->hits.load(std::memory_order_relaxed);
+    }
+    return s;
+}
+
+inline std::string summary() {
+    auto s = stats();
+    return std::to_string(s.allocs) + " alocaes (" + std::to_string(s.cache_hits) +
+           " do cache da thread), " + std::to_string(s.slab_mallocs) + " slabs e " +
+           std::to_string(s.large_mallocs) + " blocos grandes via malloc";
+}
+
+// Alocador STL sobre o pool.
+template<typename T>
+struct Allocator {
+    using value_type = T;
+    Allocator() noexcept = default;
+    template<typename U> Allocator(const Allocator<U>&) noexcept {}
+    T* allocate(size_t n) { return static_cast<T*>(pool::allocate(n * sizeof(T))); }
+    void deallocate(T* p, size_t n) noexcept { pool::deallocate(p, n * sizeof(T)); }
+    template<typename U> bool operator==(const Allocator<U>&) const noexcept { return true; }
+};
+
+// Buffer de mensagem: std::string cujo armazenamento vem do pool.
+using Buffer = std::basic_string<char, std::char_traits<char>, Allocator<char>>;
+
+} // namespace pool
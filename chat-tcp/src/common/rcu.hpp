@@ -0,0 +1,139 @@
+#pragma once
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <cstdint>
+#include <cstdlib>
+#include <utility>
+#include <vector>
+
+#include "common/placement.hpp"
+
+// Reclamao por pocas (EBR) para estruturas de leitura predominante: o
+// escritor publica uma verso nova e imutvel com uma troca de ponteiro, e
+// a antiga s  liberada quando nenhum leitor que possa t-la visto ainda
+// est ativo. Leitores no usam trava nem contador compartilhado: cada
+// thread anuncia, num slot prprio, a poca em que entrou.
+//
+// Leitura:   { auto v = cell.read(); for (auto& x : *v) ... }
+// Escrita:   cell.publish(new T(...));   // um escritor por Cell
+namespace rcu {
+
+class Domain {
+public:
+    static constexpr size_t   kSlots = 64;      // threads leitoras simultneas
+    static constexpr uint64_t kIdle  = UINT64_MAX;
+
+    static Domain& global() { static Domain d; return d; }
+
+    // Entrada/sada de leitura (aninhvel na mesma thread).
+    void enter() {
+        Local& l = local();
+        if (l.depth++ == 0) {
+            // seq_cst: o anncio precede a leitura do ponteiro publicado
+            slots_[l.slot].epoch.store(epoch_.load(std::memory_order_seq_cst), std::memory_order_seq_cst);
+        }
+    }
+    void leave() {
+        Local& l = local();
+        if (--l.depth == 0) slots_[l.slot].epoch.store(kIdle, std::memory_order_release);
+    }
+
+    // Escritor: fecha a poca atual e devolve o nmero dela.
+    uint64_t retire_epoch() { return epoch_.fetch_add(1, std::memory_order_seq_cst); }
+
+    // Menor poca anunciada por um leitor ativo (kIdle se nenhum).
+    uint64_t oldest_reader() const {
+        uint64_t m = kIdle;
+        for (auto& s : slots_) m = std::min(m, s.epoch.load(std::memory_order_seq_cst));
+        return m;
+    }
+
+private:
+    struct alignas(placement::kCacheLine) Slot {
+        std::atomic<uint64_t> epoch{kIdle};
+        std::atomic<bool>     used{false};
+    };
+
+    // Slot exclusivo da thread, devolvido quando ela termina
+    struct Local {
+        Domain*  d;
+        size_t   slot;
+        uint32_t depth = 0;
+        ~Local() { d->slots_[slot].used.store(false, std::memory_order_release); }
+    };
+
+    alignas(placement::kCacheLine) std::atomic<uint64_t> epoch_{1};
+    std::array<Slot, kSlots> slots_;
+
+    size_t claim() {
+        for (size_t i = 0; i < kSlots; ++i) {
+            bool expected = false;
+            if (slots_[i].used.compare_exchange_strong(expected, true, std::memory_order_acq_rel)) return i;
+        }
+        std::abort(); // mais threads leitoras simultneas do que kSlots
+    }
+
+    Local& local() {
+        thread_local Local l{this, claim()};
+        return l;
+    }
+};
+
+template<typename T>
+class Cell {
+public:
+    explicit Cell(T* initial = new T()) : cur_(initial) {}
+    ~Cell() {
+        delete cur_.load(std::memory_order_relaxed);
+        for (auto& r : retired_) delete r.second;
+    }
+    Cell(const Cell&) = delete;
+    Cell& operator=(const Cell&) = delete;
+
+    class Guard {
+    public:
+        explicit Guard(const Cell& c) {
+            Domain::global().enter();
+            p_ = c.cur_.load(std::memory_order_seq_cst); // depois do anncio da poca
+        }
+        ~Guard() { Domain::global().leave(); }
+        Guard(const Guard&) = delete;
+        Guard& operator=(const Guard&) = delete;
+
+        const T& operator*()  const { return *p_; }
+        const T* operator->() const { return p_; }
+
+    private:
+        const T* p_;
+    };
+
+    // Verso atual, vlida enquanto o Guard existir.
+    Guard read() const { return Guard(*this); }
+
+    // Publica `fresh` (assume a posse) e libera o que ningum mais v.
+    void publish(T* fresh) {
+        T* old = cur_.exchange(fresh, std::memory_order_seq_cst);
+        retired_.emplace_back(Domain::global().retire_epoch(), old);
+        collect();
+    }
+
+    void collect() {
+        const uint64_t oldest = Domain::global().oldest_reader();
+        size_t kept = 0;
+        for (auto& r : retired_) {
+            // Leitor que entrou numa poca posterior j v a verso nova
+            if (r.first < oldest) delete r.second;
+            else retired_[kept++] = r;
+        }
+        retired_.resize(kept);
+    }
+
+    size_t retired() const { return retired_.size(); }
+
+private:
+    std::atomic<T*>                          cur_;
+    std::vector<std::pair<uint64_t, T*>>     retired_; // s o escritor mexe
+};
+
+} // namespace rcu
@@ -0,0 +1,171 @@
+#pragma once
+#include <algorithm>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <string>
+#include <string_view>
+#include <cerrno>
+#include <fcntl.h>
+#include <unistd.h>
+
+#include "common/coro.hpp"
+#include "common/event_loop.hpp"
+
+// Transferncia de payloads grandes sem passar por buffers do processo:
+// splice(2) move as pginas entre um descritor e um pipe dentro do kernel.
+// Recebimento: socket -> pipe -> arquivo; envio: arquivo -> pipe -> socket.
+// Cada transferncia usa um pipe (64 KiB no kernel) e nenhum buffer prprio,
+// seja qual for o tamanho do payload.
+namespace splicing {
+
+inline constexpr size_t kChunk = 64 * 1024; // capacidade padro de um pipe
+
+struct Stats {
+    uint64_t received = 0; // bytes gravados em arquivo
+    uint64_t sent     = 0; // bytes enviados de arquivo
+};
+inline Stats& stats() { static Stats s; return s; }
+
+// Pipe no bloqueante, fechado no destrutor
+class Pipe {
+public:
+    Pipe() {
+        int p[2];
+        if (::pipe2(p, O_NONBLOCK | O_CLOEXEC) == 0) { r_ = p[0]; w_ = p[1]; }
+    }
+    ~Pipe() {
+        if (r_ >= 0) ::close(r_);
+        if (w_ >= 0) ::close(w_);
+    }
+    Pipe(const Pipe&) = delete;
+    Pipe& operator=(const Pipe&) = delete;
+
+    bool ok() const { return r_ >= 0; }
+    int  r()  const { return r_; }
+    int  w()  const { return w_; }
+
+private:
+    int r_ = -1;
+    int w_ = -1;
+};
+
+// Grava `n` bytes do processo no arquivo a partir de `off`
+inline bool pwrite_all(int file, const char* p, size_t n, off_t off) {
+    while (n) {
+        const ssize_t k = ::pwrite(file, p, n, off);
+        if (k < 0 && errno == EINTR) continue;
+        if (k <= 0) return false;
+        p += k; n -= static_cast<size_t>(k); off += k;
+    }
+    return true;
+}
+
+// Esvazia `n` bytes do pipe no arquivo, avanando `off`. Arquivo regular:
+// a escrita no fica pela metade por falta de espao momentnea.
+inline bool drain_to_file(int pipe_r, int file, size_t n, loff_t& off) {
+    while (n) {
+        const ssize_t k = ::splice(pipe_r, nullptr, file, &off, n, SPLICE_F_MOVE);
+        if (k < 0 && errno == EINTR) continue;
+        if (k <= 0) return false;
+        n -= static_cast<size_t>(k);
+    }
+    return true;
+}
+
+// Recebe `n` bytes da conexo no arquivo, desde o incio dele. O que j foi
+// lido para c.in (junto com a linha que anunciou o payload)  gravado
+// primeiro; o resto segue socket -> pipe -> arquivo. `progress` roda a cada
+// bloco gravado (o chamador reagenda prazos de inatividade). Retorna os
+// bytes gravados: menos que `n` em EOF, erro ou encerramento.
+inline Task<size_t> recv_to_file(EventLoop& loop, Connection& c, int file, size_t n,
+                                 std::function<void()> progress = {}) {
+    const size_t early = std::min(n, c.in.size());
+    if (early && !pwrite_all(file, c.in.data(), early, 0)) co_return 0;
+    c.in.erase(0, early);
+    size_t done = early;
+    stats().received += early;
+
+    Pipe p;
+    if (!p.ok()) co_return done;
+    loff_t off = static_cast<loff_t>(done);
+    while (done < n && !c.closed && !loop.stopping()) {
+        const ssize_t k = ::splice(c.fd, nullptr, p.w(), nullptr, std::min(kChunk, n - done),
+                                   SPLICE_F_MOVE | SPLICE_F_NONBLOCK);
+        if (k > 0) {
+            if (!drain_to_file(p.r(), file, static_cast<size_t>(k), off)) break;
+            done += static_cast<size_t>(k);
+            stats().received += static_cast<uint64_t>(k);
+            if (progress) progress();
+            continue;
+        }
+        if (k == 0) break; // desconectou
+        if (errno == EINTR) continue;
+        if (errno != EAGAIN) break;
+        co_await loop.readable(c.fd);
+    }
+    co_return done;
+}
+
+// Envia `header` e depois os `n` primeiros bytes do arquivo, arquivo -> pipe
+// -> socket. Os bytes no podem se misturar com outras linhas, ento a
+// transferncia espera quem estiver escoando c.out e fica com a escrita at
+// o fim (ver WriterAwaiter); o que chegar para a conexo nesse meio-tempo
+// espera em c.out e sai logo depois. false se no foi at o fim: a conexo
+// ficou no meio de um payload e no serve mais.
+inline Task<bool> send_file(EventLoop& loop, std::shared_ptr<Connection> c, std::string header, int file, size_t n) {
+    while (c->flushing && !c->closed && !loop.stopping()) co_await WriterAwaiter{*c};
+    if (c->closed || loop.stopping()) co_return false;
+    c->flushing = true;
+
+    // Sobra de um envio que falhou fica na frente, como no async_send
+    std::string head = std::move(c->out);
+    c->out.clear();
+    head += header;
+    bool ok = true;
+    std::string_view rest = head;
+    while (ok && !rest.empty()) {
+        const ssize_t k = send_some(c->fd, rest.data(), rest.size());
+        if (k < 0) { ok = false; break; }
+        rest.remove_prefix(static_cast<size_t>(k));
+        if (k == 0) {
+            co_await loop.writable(c->fd);
+            ok = !c->closed && !loop.stopping();
+        }
+    }
+
+    Pipe p;
+    ok = ok && p.ok();
+    loff_t off = 0;
+    size_t held = 0, sent = 0; // bytes no pipe; bytes j no socket
+    while (ok && sent < n) {
+        if (!held) {
+            const ssize_t k = ::splice(file, &off, p.w(), nullptr, std::min(kChunk, n - sent),
+                                       SPLICE_F_MOVE | SPLICE_F_NONBLOCK);
+            if (k < 0 && errno == EINTR) continue;
+            if (k <= 0) { ok = false; break; } // arquivo menor que o anunciado
+            held = static_cast<size_t>(k);
+        }
+        const unsigned more = sent + held < n ? SPLICE_F_MORE : 0;
+        const ssize_t k = ::splice(p.r(), nullptr, c->fd, nullptr, held, SPLICE_F_MOVE | SPLICE_F_NONBLOCK | more);
+        if (k > 0) {
+            held -= static_cast<size_t>(k);
+            sent += static_cast<size_t>(k);
+            stats().sent += static_cast<uint64_t>(k);
+            continue;
+        }
+        if (k < 0 && errno == EINTR) continue;
+        if (k < 0 && errno == EAGAIN) {
+            co_await loop.writable(c->fd);
+            ok = !c->closed && !loop.stopping();
+            continue;
+        }
+        ok = false;
+    }
+
+    release_writer(loop, *c);
+    if (ok && !c->out.empty()) send_nowait(loop, c, {});
+    co_return ok;
+}
+
+} // namespace splicing
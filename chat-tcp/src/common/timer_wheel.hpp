@@ -0,0 +1,180 @@
+#pragma once
+#include <algorithm>
+#include <bit>
+#include <cstdint>
+#include <functional>
+
+// Roda de temporizadores hierrquica (4 nveis, resoluo de 1 ms, alcance
+// de ~18 h). Agendar, reagendar e cancelar so O(1); um temporizador de
+// nvel alto desce de nvel ("cascata") quando sua faixa de tempo chega.
+// next_delay() diz quanto o loop pode dormir: sem temporizadores, para
+// sempre; seno, at o prximo disparo ou cascata.
+class TimerWheel;
+
+class Timer {
+public:
+    explicit Timer(std::function<void()> fn = {}) : fn_(std::move(fn)) {}
+    ~Timer() { cancel(); }
+    Timer(const Timer&) = delete;
+    Timer& operator=(const Timer&) = delete;
+
+    void set_callback(std::function<void()> fn) { fn_ = std::move(fn); }
+    bool pending() const { return wheel_ != nullptr; }
+    inline void cancel();
+
+private:
+    friend class TimerWheel;
+    TimerWheel* wheel_   = nullptr;
+    Timer*      prev_    = nullptr;
+    Timer*      next_    = nullptr;
+    uint64_t    expires_ = 0;  // instante absoluto (ms)
+    uint32_t    gen_     = 0;  // gerao do agendamento (ver expire_all)
+    uint16_t    slot_    = 0;  // ndice em TimerWheel::slots_
+    std::function<void()> fn_;
+};
+
+class TimerWheel {
+public:
+    explicit TimerWheel(uint64_t now_ms) : now_(now_ms) {}
+    ~TimerWheel() { for (auto*& h : slots_) while (h) unlink(*h); }
+    TimerWheel(const TimerWheel&) = delete;
+    TimerWheel& operator=(const TimerWheel&) = delete;
+
+    // (Re)agenda `t` para daqui a `delay_ms` (mnimo 1 ms).
+    void schedule(Timer& t, uint64_t delay_ms) {
+        if (t.wheel_) unlink(t);
+        t.expires_ = now_ + std::clamp<uint64_t>(delay_ms, 1, kMaxDelay);
+        link(t);
+    }
+
+    // Avana o relgio at `now_ms`, disparando o que venceu.
+    void advance(uint64_t now_ms) {
+        while (now_ < now_ms) {
+            if (count_ == 0) { now_ = now_ms; return; }
+            ++now_;
+            const size_t i0 = now_ & (kL0 - 1);
+            if (i0 == 0) {
+                // Da faixa mais larga para a mais estreita: quem desce de
+                // nvel cai numa posio ainda no processada.
+                for (int lv = kLevels - 1; lv >= 1; --lv) {
+                    if ((now_ & ((uint64_t(1) << shift(lv)) - 1)) == 0) cascade(lv, index(lv, now_));
+                }
+            }
+            Timer*& head = slots_[i0];
+            while (head) {
+                Timer& t = *head;
+                unlink(t);
+                if (t.fn_) t.fn_(); // pode reagendar ou destruir `t`
+            }
+        }
+    }
+
+    // Milissegundos at o prximo disparo/cascata, a partir de `now_ms`
+    // (-1 se no h temporizadores).
+    int next_delay(uint64_t now_ms) const {
+        if (count_ == 0) return -1;
+        uint64_t at = UINT64_MAX;
+        // Nvel 0: distncia exata at a prxima posio ocupada
+        const size_t cur0 = now_ & (kL0 - 1);
+        for (size_t d = 1; d < kL0; ++d) {
+            const size_t i = (cur0 + d) & (kL0 - 1);
+            const uint64_t w = bits0_[i / 64];
+            if (w == 0) { d += 63 - (i % 64); continue; } // pula a palavra vazia
+            if (w >> (i % 64) & 1) { at = now_ + d; break; }
+        }
+        // Nveis altos: instante em que a prxima posio ocupada desce
+        for (int lv = 1; lv < kLevels; ++lv) {
+            if (!bits_[lv]) continue;
+            const uint64_t cur = index(lv, now_);
+            const uint64_t rot = std::rotr(bits_[lv], static_cast<int>((cur + 1) & 63));
+            const uint64_t dist = static_cast<uint64_t>(std::countr_zero(rot)) + 1;
+            at = std::min(at, ((now_ >> shift(lv)) + dist) << shift(lv));
+        }
+        if (at <= now_ms) return 0;
+        return static_cast<int>(std::min<uint64_t>(at - now_ms, INT32_MAX));
+    }
+
+    // Dispara agora tudo o que estava agendado (encerramento). O que os
+    // callbacks reagendarem fica para depois.
+    void expire_all() {
+        const uint32_t gen = gen_++;
+        for (auto*& head : slots_) {
+            for (Timer* t = head; t;) {
+                if (t->gen_ != gen) { t = t->next_; continue; }
+                unlink(*t);
+                if (t->fn_) t->fn_();
+                t = head; // o callback pode ter mexido nesta lista
+            }
+        }
+    }
+
+    size_t size() const { return count_; }
+
+private:
+    friend class Timer;
+    static constexpr int      kLevels   = 4;
+    static constexpr size_t   kL0       = 256;  // posies do nvel 0 (1 ms cada)
+    static constexpr size_t   kLn       = 64;   // posies dos nveis 1..3
+    static constexpr uint64_t kMaxDelay = (uint64_t(1) << 26) - 1;
+
+    Timer*   slots_[kL0 + (kLevels - 1) * kLn] = {};
+    uint64_t bits0_[kL0 / 64] = {};   // posies ocupadas no nvel 0
+    uint64_t bits_[kLevels]   = {};   // ... nos nveis 1..3 (bits_[0] no usado)
+    uint64_t now_;
+    size_t   count_ = 0;
+    uint32_t gen_   = 0;
+
+    static constexpr int shift(int lv) { return lv == 0 ? 0 : 8 + 6 * (lv - 1); }
+    static uint64_t index(int lv, uint64_t t) { return (t >> shift(lv)) & (lv == 0 ? kL0 - 1 : kLn - 1); }
+    static size_t base(int lv) { return lv == 0 ? 0 : kL0 + (lv - 1) * kLn; }
+
+    void link(Timer& t) {
+        const uint64_t delta = t.expires_ > now_ ? t.expires_ - now_ : 0;
+        int lv = 0;
+        while (lv + 1 < kLevels && delta >= (uint64_t(1) << shift(lv + 1))) ++lv;
+        const size_t i = index(lv, t.expires_);
+        t.slot_  = static_cast<uint16_t>(base(lv) + i);
+        t.wheel_ = this;
+        t.gen_   = gen_;
+        t.prev_  = nullptr;
+        t.next_  = slots_[t.slot_];
+        if (t.next_) t.next_->prev_ = &t;
+        slots_[t.slot_] = &t;
+        if (lv == 0) bits0_[i / 64] |= uint64_t(1) << (i % 64);
+        else         bits_[lv] |= uint64_t(1) << i;
+        ++count_;
+    }
+
+    void unlink(Timer& t) {
+        if (t.prev_) t.prev_->next_ = t.next_;
+        else         slots_[t.slot_] = t.next_;
+        if (t.next_) t.next_->prev_ = t.prev_;
+        if (!slots_[t.slot_]) {
+            if (t.slot_ < kL0) bits0_[t.slot_ / 64] &= ~(uint64_t(1) << (t.slot_ % 64));
+            else {
+                const size_t lv = 1 + (t.slot_ - kL0) / kLn, i = (t.slot_ - kL0) % kLn;
+                bits_[lv] &= ~(uint64_t(1) << i);
+            }
+        }
+        t.wheel_ = nullptr;
+        t.prev_ = t.next_ = nullptr;
+        --count_;
+    }
+
+    // Redistribui a posio i do nvel lv pelos nveis de baixo.
+    void cascade(int lv, uint64_t i) {
+        Timer* t = slots_[base(lv) + i];
+        slots_[base(lv) + i] = nullptr;
+        bits_[lv] &= ~(uint64_t(1) << i);
+        while (t) {
+            Timer* next = t->next_;
+            --count_;
+            link(*t);
+            t = next;
+        }
+    }
+};
+
+inline void Timer::cancel() {
+    if (wheel_) wheel_->unlink(*this);
+}
@@ -0,0 +1,180 @@
+#pragma once
+#include <algorithm>
+#include <atomic>
+#include <cstdint>
+#include <fstream>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+#include <time.h>
+
+#include "common/placement.hpp"
+
+// Rastreamento do ciclo de vida de mensagens, exportado no formato
+// trace_event do Chrome (chrome://tracing, ui.perfetto.dev).
+//
+// S 1 a cada N mensagens recebe um id (amostragem); mark() com id 0  um
+// teste e retorno. Cada thread grava num anel prprio (o mutex do anel s
+// disputa com dump()), e o anel mantm os eventos mais recentes.
+namespace trace {
+
+enum class Stage : uint8_t { Recv, Enqueue, Dequeue, FirstSend, LastSend, History, Count };
+
+// Nomes em ASCII: vo direto para o JSON.
+inline const char* stage_name(Stage s) {
+    switch (s) {
+        case Stage::Recv:      return "recv";
+        case Stage::Enqueue:   return "enfileirada";
+        case Stage::Dequeue:   return "desenfileirada";
+        case Stage::FirstSend: return "primeiro envio";
+        case Stage::LastSend:  return "ultimo envio";
+        case Stage::History:   return "historico";
+        default:               return "?";
+    }
+}
+
+inline constexpr size_t kRingEvents = 1 << 16; // por thread
+
+struct Event {
+    uint64_t id;
+    int64_t  ts_ns;
+    Stage    stage;
+};
+
+namespace detail {
+
+struct Ring {
+    std::mutex         m;
+    std::vector<Event> ev;
+    size_t             next = 0; // total gravado (posio = next % kRingEvents)
+    uint32_t           tid  = 0;
+};
+
+struct State {
+    std::atomic<bool>     enabled{false};
+    std::atomic<uint32_t> every{100};
+    alignas(placement::kCacheLine) std::atomic<uint64_t> next_id{1}; // escrito por todas as threads
+    alignas(placement::kCacheLine) std::mutex m;
+    std::vector<std::shared_ptr<Ring>> rings; // mantm anis de threads encerradas
+};
+inline State& state() { static State s; return s; }
+
+inline Ring& ring() {
+    thread_local std::shared_ptr<Ring> r = [] {
+        auto p = std::make_shared<Ring>();
+        p->ev.resize(kRingEvents);
+        auto& s = state();
+        std::lock_guard<std::mutex> lk(s.m);
+        p->tid = static_cast<uint32_t>(s.rings.size() + 1);
+        s.rings.push_back(p);
+        return p;
+    }();
+    return *r;
+}
+
+inline int64_t mono_ns() {
+    timespec ts;
+    ::clock_gettime(CLOCK_MONOTONIC, &ts);
+    return static_cast<int64_t>(ts.tv_sec) * 1000000000 + ts.tv_nsec;
+}
+
+inline void escape_into(std::string& out, const char* s) {
+    for (; *s; ++s) {
+        if (*s == '"' || *s == '\\') out.push_back('\\');
+        out.push_back(*s);
+    }
+}
+
+} // namespace detail
+
+// Liga o rastreamento amostrando 1 a cada `every` mensagens.
+inline void enable(uint32_t every) {
+    auto& s = detail::state();
+    s.every.store(every ? every : 1, std::memory_order_relaxed);
+    s.enabled.store(true, std::memory_order_release);
+}
+inline bool enabled() { return detail::state().enabled.load(std::memory_order_relaxed); }
+
+// Decide se a prxima mensagem desta thread  rastreada: id > 0, ou 0.
+inline uint64_t sample() {
+    auto& s = detail::state();
+    if (!s.enabled.load(std::memory_order_relaxed)) return 0;
+    thread_local uint32_t n = 0;
+    if (++n < s.every.load(std::memory_order_relaxed)) return 0;
+    n = 0;
+    return s.next_id.fetch_add(1, std::memory_order_relaxed);
+}
+
+inline void mark(uint64_t id, Stage stage) {
+    if (id == 0) return;
+    auto& r = detail::ring();
+    const int64_t ts = detail::mono_ns();
+    std::lock_guard<std::mutex> lk(r.m);
+    r.ev[r.next++ % kRingEvents] = Event{id, ts, stage};
+}
+
+// Grava os eventos em `path` (JSON trace_event). Cada mensagem vira um
+// evento assncrono com um trecho aninhado entre cada par de etapas.
+// Retorna o nmero de mensagens exportadas, ou -1 se o arquivo falhou.
+inline long dump(const std::string& path) {
+    struct Rec { Event e; uint32_t tid; };
+    std::vector<Rec> all;
+    {
+        auto& s = detail::state();
+        std::lock_guard<std::mutex> lk(s.m);
+        for (auto& r : s.rings) {
+            std::lock_guard<std::mutex> rl(r->m);
+            const size_t n = std::min(r->next, kRingEvents);
+            for (size_t i = r->next - n; i < r->next; ++i) all.push_back({r->ev[i % kRingEvents], r->tid});
+        }
+    }
+    std::sort(all.begin(), all.end(), [](const Rec& a, const Rec& b) {
+        return a.e.id != b.e.id ? a.e.id < b.e.id : a.e.ts_ns < b.e.ts_ns;
+    });
+
+    int64_t t0 = INT64_MAX;
+    for (auto& r : all) t0 = std::min(t0, r.e.ts_ns);
+    auto us = [&](int64_t ns) { return std::to_string((ns - t0) / 1000) + "." + std::to_string((ns - t0) / 100 % 10); };
+
+    std::string out = "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[\n";
+    bool first = true;
+    auto event = [&](char ph, const std::string& name, uint64_t id, int64_t ts, uint32_t tid) {
+        if (!first) out += ",\n";
+        first = false;
+        out += "{\"cat\":\"msg\",\"ph\":\"";
+        out.push_back(ph);
+        out += "\",\"name\":\"";
+        detail::escape_into(out, name.c_str());
+        out += "\",\"id\":" + std::to_string(id) + ",\"ts\":" + us(ts) +
+               ",\"pid\":1,\"tid\":" + std::to_string(tid) + "}";
+    };
+
+    long msgs = 0;
+    for (size_t i = 0; i < all.size();) {
+        size_t j = i;
+        while (j < all.size() && all[j].e.id == all[i].e.id) ++j;
+        if (j - i >= 2) { // mensagem com pelo menos um intervalo
+            const uint64_t id = all[i].e.id;
+            const std::string whole = "msg " + std::to_string(id);
+            event('b', whole, id, all[i].e.ts_ns, all[i].tid);
+            for (size_t k = i; k + 1 < j; ++k) {
+                const std::string name = std::string(stage_name(all[k].e.stage)) + " -> " +
+                                         stage_name(all[k + 1].e.stage);
+                event('b', name, id, all[k].e.ts_ns, all[k].tid);
+                event('e', name, id, all[k + 1].e.ts_ns, all[k + 1].tid);
+            }
+            event('e', whole, id, all[j - 1].e.ts_ns, all[j - 1].tid);
+            ++msgs;
+        }
+        i = j;
+    }
+    out += "\n]}\n";
+
+    std::ofstream f(path, std::ios::trunc);
+    if (!f) return -1;
+    f << out;
+    return f ? msgs : -1;
+}
+
+} // namespace trace
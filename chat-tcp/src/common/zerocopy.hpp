@@ -0,0 +1,139 @@
+#pragma once
+#include <cstdint>
+#include <cstring>
+#include <memory>
+#include <string>
+#include <string_view>
+#include <cerrno>
+#include <linux/errqueue.h>
+#include <netinet/in.h>
+#include <sys/socket.h>
+
+#include "common/event_loop.hpp"
+
+#ifndef SO_ZEROCOPY
+#define SO_ZEROCOPY 60
+#endif
+#ifndef MSG_ZEROCOPY
+#define MSG_ZEROCOPY 0x4000000
+#endif
+#ifndef SO_EE_ORIGIN_ZEROCOPY
+#define SO_EE_ORIGIN_ZEROCOPY 5
+#endif
+#ifndef SO_EE_CODE_ZEROCOPY_COPIED
+#define SO_EE_CODE_ZEROCOPY_COPIED 1
+#endif
+
+// Envio sem cpia (MSG_ZEROCOPY) para payloads grandes: o kernel referencia
+// as pginas do buffer em vez de copi-las, ento o buffer precisa ficar
+// intacto at a notificao de concluso chegar pela errqueue do socket.
+// Por isso o envio recebe um buffer compartilhado e imutvel; a conexo
+// guarda uma referncia por envio (Connection::zc) at a concluso, que o
+// reaper colhe quando o epoll avisa (EPOLLERR).
+//
+// Recuos para o envio com cpia: socket sem SO_ZEROCOPY (kernel antigo,
+// AF_UNIX), ENOBUFS (limite de optmem), buffer de sada j pendente, ou um
+// socket em que o kernel acaba copiando tudo mesmo (loopback, NIC sem
+// scatter-gather): a o zerocopy s custaria mais e  desligado.
+namespace zerocopy {
+
+struct Stats {
+    uint64_t sends     = 0; // envios com MSG_ZEROCOPY
+    uint64_t bytes     = 0; // bytes aceitos nesses envios
+    uint64_t completed = 0; // envios concludos pelo kernel
+    uint64_t copied    = 0; // ... que o kernel acabou copiando
+    uint64_t fallbacks = 0; // envios grandes que seguiram com cpia
+    uint64_t disabled  = 0; // sockets em que o zerocopy foi desligado
+};
+inline Stats& stats() { static Stats s; return s; }
+
+// Amostra de concluses antes de decidir se o socket copia tudo mesmo
+inline constexpr uint32_t kProbe = 32;
+
+inline bool enable(Connection& c) {
+    int one = 1;
+    c.zc.enabled = ::setsockopt(c.fd, SOL_SOCKET, SO_ZEROCOPY, &one, sizeof(one)) == 0;
+    return c.zc.enabled;
+}
+
+// L as notificaes de concluso pendentes e solta os buffers concludos.
+inline void reap(Connection& c) {
+    auto& zc = c.zc;
+    while (!zc.inflight.empty()) {
+        char control[128];
+        msghdr msg{};
+        msg.msg_control    = control;
+        msg.msg_controllen = sizeof(control);
+        if (::recvmsg(c.fd, &msg, MSG_ERRQUEUE | MSG_DONTWAIT) < 0) return; // EAGAIN: nada novo
+        for (cmsghdr* cm = CMSG_FIRSTHDR(&msg); cm; cm = CMSG_NXTHDR(&msg, cm)) {
+            const bool ip = (cm->cmsg_level == SOL_IP && cm->cmsg_type == IP_RECVERR) ||
+                            (cm->cmsg_level == SOL_IPV6 && cm->cmsg_type == IPV6_RECVERR);
+            if (!ip) continue;
+            sock_extended_err err;
+            std::memcpy(&err, CMSG_DATA(cm), sizeof(err));
+            if (err.ee_origin != SO_EE_ORIGIN_ZEROCOPY || err.ee_errno != 0) continue;
+
+            // Intervalo [ee_info, ee_data] de envios concludos (ids de 32 bits, com volta)
+            const uint32_t hi = err.ee_data;
+            const bool copied = err.ee_code & SO_EE_CODE_ZEROCOPY_COPIED;
+            while (!zc.inflight.empty() && static_cast<int32_t>(zc.inflight.front().first - hi) <= 0) {
+                zc.inflight.pop_front();
+                ++stats().completed;
+                ++zc.checked;
+                if (copied) { ++zc.copied; ++stats().copied; }
+            }
+        }
+        if (zc.enabled && zc.checked >= kProbe && zc.copied == zc.checked) {
+            zc.enabled = false;
+            ++stats().disabled;
+        }
+    }
+}
+
+// Solta os buffers assim que as concluses chegam (EPOLLERR na errqueue),
+// no s no prximo envio: quem para de receber payloads grandes no segura
+// os ltimos at fechar. Roda enquanto houver envio em voo na conexo.
+inline Task<> reaper(EventLoop& loop, std::shared_ptr<Connection> c) {
+    for (;;) {
+        reap(*c);
+        if (c->zc.inflight.empty() || c->closed || loop.stopping()) break;
+        co_await loop.errored(c->fd);
+    }
+    c->zc.reaping = false;
+}
+
+// Como send_nowait, mas envia `buf` sem cpia quando a conexo permite e o
+// buffer de sada est vazio. O que o kernel no aceitar segue pelo
+// caminho normal (copiado para c->out). `buf` fica vivo at a concluso.
+inline bool send_nowait(EventLoop& loop, const std::shared_ptr<Connection>& c,
+                        std::shared_ptr<const std::string> buf) {
+    if (c->closed) return false;
+    std::string_view data = *buf;
+    if (!c->zc.inflight.empty()) reap(*c);
+    if (!c->zc.enabled || c->flushing || !c->out.empty()) {
+        ++stats().fallbacks;
+        return ::send_nowait(loop, c, data);
+    }
+    ssize_t n;
+    do n = ::send(c->fd, data.data(), data.size(), MSG_ZEROCOPY | MSG_NOSIGNAL | MSG_DONTWAIT);
+    while (n < 0 && errno == EINTR);
+    if (n < 0) {
+        if (errno == EAGAIN || errno == EWOULDBLOCK || errno == ENOBUFS) {
+            ++stats().fallbacks;
+            return ::send_nowait(loop, c, data);
+        }
+        return false;
+    }
+    // Cada envio aceito consome um id, mesmo parcial
+    c->zc.inflight.emplace_back(c->zc.next_id++, std::move(buf));
+    if (!c->zc.reaping) {
+        c->zc.reaping = true;
+        spawn(reaper(loop, c));
+    }
+    ++stats().sends;
+    stats().bytes += static_cast<uint64_t>(n);
+    data.remove_prefix(static_cast<size_t>(n));
+    return data.empty() || ::send_nowait(loop, c, data);
+}
+
+} // namespace zerocopy
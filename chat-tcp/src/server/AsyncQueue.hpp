@@ -0,0 +1,228 @@
+#pragma once
+#include <algorithm>
+#include <array>
+#include <chrono>
+#include <coroutine>
+#include <cstdint>
+#include <deque>
+#include <optional>
+#include <vector>
+
+#include "common/event_loop.hpp"
+#include "server/Message.hpp"
+
+// Fila bounded para corrotinas do mesmo EventLoop: push suspende quando a
+// faixa est cheia e pop quando a fila toda est vazia (sem threads, sem
+// locks: produtores e consumidor rodam na thread do loop).
+//
+// Faixas de prioridade (Message::lane), cada uma com anel, capacidade e
+// produtores  espera prprios: uma faixa cheia no segura as outras. Faixas
+// com peso 0 so estritas e saem antes de qualquer outra (Control); as
+// demais dividem a sada na proporo dos pesos (round-robin ponderado
+// suave), ento o chat saturado no deixa os avisos do sistema sem vez e
+// vice-versa. Os itens ficam em anis pr-alocados: enfileirar no aloca.
+class AsyncQueue {
+public:
+    using Item = Message;
+
+    // Mtricas por faixa; espera = tempo entre entrar no anel e sair
+    struct LaneStats {
+        uint64_t pushed   = 0;
+        uint64_t popped   = 0;
+        uint64_t blocked  = 0; // push que achou a faixa cheia e esperou
+        uint64_t wait_sum_us = 0;
+        uint64_t wait_max_us = 0;
+    };
+
+    AsyncQueue(EventLoop& loop, const std::array<size_t, kLanes>& capacity,
+               const std::array<uint32_t, kLanes>& weight)
+      : loop_(loop) {
+        for (size_t l = 0; l < kLanes; ++l) {
+            lanes_[l].capacity = std::max<size_t>(capacity[l], 1);
+            lanes_[l].ring.resize(lanes_[l].capacity);
+            lanes_[l].weight = weight[l];
+        }
+    }
+
+    struct PushAwaiter {
+        AsyncQueue&             q;
+        Item                    msg;
+        std::coroutine_handle<> h;
+        bool                    ok = false;
+
+        bool await_ready() { return q.try_push(msg, ok); }
+        void await_suspend(std::coroutine_handle<> hh) {
+            h = hh;
+            auto& lane = q.lane(msg.lane);
+            ++lane.stats.blocked;
+            lane.pushers.push_back(this);
+        }
+        bool await_resume() const noexcept { return ok; }
+    };
+
+    struct PopAwaiter {
+        AsyncQueue&             q;
+        std::optional<Item>     msg;
+        std::coroutine_handle<> h;
+
+        bool await_ready() { return q.try_pop(msg); }
+        void await_suspend(std::coroutine_handle<> hh) { h = hh; q.poppers_.push_back(this); }
+        std::optional<Item> await_resume() { return std::move(msg); }
+    };
+
+    // Produo: co_await push(msg) -> false se a fila foi fechada.
+    // A faixa vem de msg.lane.
+    PushAwaiter push(Item msg) { return PushAwaiter{*this, std::move(msg), {}}; }
+
+    // Sem esperar: false se a faixa est cheia ou a fila fechada.
+    bool try_push(Item msg) {
+        bool ok = false;
+        return try_push(msg, ok) && ok;
+    }
+
+    // Consumo: co_await pop() -> std::nullopt quando fechada e vazia
+    PopAwaiter pop() { return PopAwaiter{*this, std::nullopt, {}}; }
+
+    // Encerramento: produtores pendentes falham; consumidores drenam o que
+    // restou e depois recebem std::nullopt.
+    void close() {
+        closed_ = true;
+        for (auto& lane : lanes_) {
+            for (auto* p : lane.pushers) { p->ok = false; loop_.post(p->h); }
+            lane.pushers.clear();
+        }
+        if (count_ == 0) {
+            for (auto* c : poppers_) loop_.post(c->h);
+            poppers_.clear();
+        }
+    }
+
+    // Nova capacidade da faixa, aplicada na hora e sem parar o fluxo. Ao
+    // crescer, produtores  espera entram j; ao encolher abaixo do que est
+    // na faixa, nada  descartado: s novos push esperam at ela escoar.
+    void resize(Lane l, size_t capacity) {
+        auto& lane = this->lane(l);
+        capacity = std::max<size_t>(capacity, 1);
+        std::vector<Slot> ring(std::max(capacity, lane.count));
+        for (size_t i = 0; i < lane.count; ++i) ring[i] = std::move(lane.ring[(lane.head + i) % lane.ring.size()]);
+        lane.ring.swap(ring);
+        lane.head     = 0;
+        lane.capacity = capacity;
+        while (lane.count < lane.capacity && !lane.pushers.empty()) admit_pusher(lane);
+    }
+
+    // Peso 0 = estrita (sai antes das ponderadas)
+    void set_weight(Lane l, uint32_t weight) { lane(l).weight = weight; lane(l).credit = 0; }
+
+    size_t   size()            const { return count_; }
+    size_t   bytes()           const { return bytes_; } // texto guardado nos anis
+    size_t   size(Lane l)      const { return lane(l).count; }
+    size_t   capacity(Lane l)  const { return lane(l).capacity; }
+    uint32_t weight(Lane l)    const { return lane(l).weight; }
+    const LaneStats& stats(Lane l) const { return lane(l).stats; }
+
+private:
+    struct Slot {
+        Item    item;
+        int64_t at_us = 0; // entrada no anel (relgio monotnico)
+    };
+
+    struct LaneState {
+        std::vector<Slot>        ring;
+        size_t                   capacity = 1;
+        size_t                   head  = 0;
+        size_t                   count = 0;
+        uint32_t                 weight = 1;
+        int64_t                  credit = 0; // round-robin ponderado suave
+        std::deque<PushAwaiter*> pushers;
+        LaneStats                stats;
+    };
+
+    EventLoop&                       loop_;
+    bool                             closed_ = false;
+    std::array<LaneState, kLanes>    lanes_;
+    size_t                           count_ = 0; // soma das faixas
+    size_t                           bytes_ = 0; // capacidade dos textos enfileirados
+    std::deque<PopAwaiter*>          poppers_;
+
+    LaneState&       lane(Lane l)       { return lanes_[static_cast<size_t>(l)]; }
+    const LaneState& lane(Lane l) const { return lanes_[static_cast<size_t>(l)]; }
+
+    static int64_t mono_us() {
+        using namespace std::chrono;
+        return duration_cast<microseconds>(steady_clock::now().time_since_epoch()).count();
+    }
+
+    void put(LaneState& lane, Item& msg) {
+        auto& slot = lane.ring[(lane.head + lane.count) % lane.ring.size()];
+        slot.item  = std::move(msg);
+        slot.at_us = mono_us();
+        bytes_ += slot.item.text.capacity();
+        ++lane.count;
+        ++count_;
+        ++lane.stats.pushed;
+    }
+
+    void admit_pusher(LaneState& lane) {
+        auto* p = lane.pushers.front(); lane.pushers.pop_front();
+        put(lane, p->msg);
+        p->ok = true;
+        loop_.post(p->h);
+    }
+
+    bool try_push(Item& msg, bool& ok) {
+        if (closed_) { ok = false; return true; }
+        auto& lane = this->lane(msg.lane);
+        if (!poppers_.empty()) { // entrega direta a um consumidor  espera
+            auto* c = poppers_.front(); poppers_.pop_front();
+            c->msg = std::move(msg);
+            loop_.post(c->h);
+            ++lane.stats.pushed;
+            ++lane.stats.popped;
+            ok = true;
+            return true;
+        }
+        if (lane.count < lane.capacity && lane.pushers.empty()) {
+            put(lane, msg);
+            ok = true;
+            return true;
+        }
+        return false;
+    }
+
+    // Prxima faixa a servir; s chamada com count_ > 0
+    LaneState& pick() {
+        for (auto& lane : lanes_)
+            if (lane.weight == 0 && lane.count > 0) return lane;
+        LaneState* best = nullptr;
+        int64_t total = 0;
+        for (auto& lane : lanes_) {
+            if (lane.weight == 0 || lane.count == 0) continue;
+            lane.credit += lane.weight;
+            total += lane.weight;
+            if (!best || lane.credit > best->credit) best = &lane;
+        }
+        best->credit -= total;
+        return *best;
+    }
+
+    bool try_pop(std::optional<Item>& out) {
+        if (count_ > 0) {
+            auto& lane = pick();
+            auto& slot = lane.ring[lane.head];
+            bytes_ -= slot.item.text.capacity();
+            out = std::move(slot.item);
+            const uint64_t waited = static_cast<uint64_t>(std::max<int64_t>(0, mono_us() - slot.at_us));
+            lane.stats.wait_sum_us += waited;
+            lane.stats.wait_max_us  = std::max(lane.stats.wait_max_us, waited);
+            ++lane.stats.popped;
+            lane.head = (lane.head + 1) % lane.ring.size();
+            --lane.count;
+            --count_;
+            // Vaga liberada: admite o prximo produtor da faixa
+            if (lane.count < lane.capacity && !lane.pushers.empty()) admit_pusher(lane);
+            return true;
+        }
+        return closed_;
+    }
+};
@@ -0,0 +1,107 @@
+#pragma once
+#include <cstdint>
+#include <deque>
+#include <memory>
+#include <string>
+#include <string_view>
+#include <cerrno>
+#include <fcntl.h>
+#include <stdlib.h>
+#include <unistd.h>
+
+// Anexos (/file e /get): o payload vai do socket do remetente para um
+// arquivo sem nome no spool e de l, sob demanda, para cada destinatrio no
+// ritmo dele, sempre por splice (ver common/splice.hpp). O contedo no passa
+// pela fila, pelo histrico, pelo anel nem pela federao; o processo guarda
+// s o descritor e os metadados de cada anexo.
+//
+// O spool guarda os anexos mais recentes at um total de bytes; o mais
+// antigo sai primeiro. Um envio em curso segura o seu arquivo (shared_ptr)
+// at terminar, mesmo que ele j tenha sado do spool.
+namespace attach {
+
+inline constexpr size_t kMaxName  = 128;
+inline constexpr size_t kMaxFiles = 64; // anexos guardados, qualquer que seja o tamanho
+
+struct File {
+    uint64_t    id = 0;
+    std::string from;
+    std::string name;
+    size_t      size = 0;
+    int         fd = -1;
+
+    File() = default;
+    File(const File&) = delete;
+    File& operator=(const File&) = delete;
+    ~File() { if (fd >= 0) ::close(fd); }
+};
+
+// Nome repassado aos destinatrios: 1-128 de [A-Za-z0-9._-], sem comear por
+// '.' (quem salva pode us-lo direto como nome de arquivo)
+inline bool valid_name(std::string_view n) {
+    if (n.empty() || n.size() > kMaxName || n[0] == '.') return false;
+    for (char ch : n) {
+        const bool ok = (ch >= 'a' && ch <= 'z') || (ch >= 'A' && ch <= 'Z') ||
+                        (ch >= '0' && ch <= '9') || ch == '.' || ch == '_' || ch == '-';
+        if (!ok) return false;
+    }
+    return true;
+}
+
+class Spool {
+public:
+    // dir: onde criar os arquivos; keep_bytes: soma mxima dos guardados
+    Spool(std::string dir, size_t keep_bytes) : dir_(std::move(dir)), keep_(keep_bytes) {}
+
+    // Arquivo novo no spool, j sem nome (some ao ser fechado). Sem
+    // O_TMPFILE no sistema de arquivos, cria e remove o nome na hora.
+    // -1 em erro (errno).
+    int create() const {
+        int fd = ::open(dir_.c_str(), O_TMPFILE | O_RDWR | O_CLOEXEC, 0600);
+        if (fd >= 0 || (errno != EOPNOTSUPP && errno != EISDIR && errno != EINVAL)) return fd;
+        std::string path = dir_ + "/chat-spool-XXXXXX";
+        fd = ::mkostemp(path.data(), O_CLOEXEC);
+        if (fd >= 0) ::unlink(path.c_str());
+        return fd;
+    }
+
+    // Guarda um anexo j gravado (o spool assume `fd`) e descarta os mais
+    // antigos acima dos limites.
+    std::shared_ptr<const File> add(std::string from, std::string name, size_t size, int fd) {
+        auto f = std::make_shared<File>();
+        f->id   = ++next_id_;
+        f->from = std::move(from);
+        f->name = std::move(name);
+        f->size = size;
+        f->fd   = fd;
+        files_.push_back(f);
+        bytes_ += size;
+        ++received;
+        while (files_.size() > 1 && (bytes_ > keep_ || files_.size() > kMaxFiles)) {
+            bytes_ -= files_.front()->size;
+            files_.pop_front();
+        }
+        return f;
+    }
+
+    std::shared_ptr<const File> find(uint64_t id) const {
+        for (auto& f : files_) if (f->id == id) return f;
+        return nullptr;
+    }
+
+    const std::string& dir() const { return dir_; }
+    size_t count() const { return files_.size(); }
+    size_t bytes() const { return bytes_; }
+
+    uint64_t received = 0; // anexos recebidos por completo
+    uint64_t sent     = 0; // envios completos a destinatrios
+
+private:
+    std::string dir_;
+    size_t      keep_;
+    uint64_t    next_id_ = 0;
+    size_t      bytes_   = 0;
+    std::deque<std::shared_ptr<const File>> files_;
+};
+
+} // namespace attach
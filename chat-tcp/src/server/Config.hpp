@@ -0,0 +1,212 @@
+#pragma once
+#include <cstdint>
+#include <iostream>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <utility>
+#include <vector>
+#include <tslog.hpp>
+
+#include "common/placement.hpp"
+
+// Opes de linha de comando do chat_server.
+struct ServerConfig {
+    uint16_t    port = 5555;
+    std::string unix_path; // tambm aceita clientes neste socket AF_UNIX (vazio -> no)
+
+    // Valores iniciais; ajustveis em execuo pelo socket de administrao
+    size_t      queue_cap     = 1024;             // fila de broadcast (faixa de chat)
+    size_t      queue_system  = 256;              // faixa de avisos do servidor
+    size_t      queue_control = 64;               // faixa de controle (kick, encerramento)
+    uint32_t    system_weight = 4;                // avisos por linha de chat, com as duas cheias
+    size_t      history_max   = 200;              // entradas do histrico
+    tslog::Level log_level    = tslog::Level::Debug;
+    std::string admin_path; // socket AF_UNIX de administrao (vazio -> sem)
+
+    // Federao (vrios processos formando um nico chat)
+    uint32_t node_id   = 0; // 0 -> usa a porta de clientes
+    uint16_t peer_port = 0; // 0 -> no aceita conexes de peers
+    std::vector<std::pair<std::string, uint16_t>> peers; // peers a discar
+
+    // Rastreamento de mensagens (trace_event do Chrome)
+    std::string trace_path;          // vazio -> desligado
+    uint32_t    trace_every = 100;   // amostra 1 a cada N mensagens
+
+    // Temporizadores (segundos; 0 desliga)
+    uint32_t idle_timeout_s = 0;  // desconecta clientes mudos
+    uint32_t heartbeat_s    = 10; // PING entre peers; mudo por 3x = enlace morto
+
+    // Limite de taxa por sesso (linhas/s; 0 desliga) e rajada permitida
+    uint32_t rate  = 0;
+    uint32_t burst = 0; // 0 -> igual a rate
+
+    // Threads de envio para o broadcast (0 = tudo na thread do loop)
+    uint32_t fanout_workers = 0;
+
+    // Envio sem cpia (MSG_ZEROCOPY) a partir deste tamanho em bytes (0 desliga)
+    uint32_t zerocopy_min = 0;
+
+    // Nvel do deflate para clientes que pedem "/compress deflate" (0 recusa).
+    // Cada broadcast  comprimido por sesso: o nvel 1 economiza mais bytes
+    // por ms de CPU (ver bench_compress)
+    int compress_level = 1;
+
+    // Publicao em memria compartilhada para consumidores locais
+    std::string shm_name;              // ex.: /chat-5555 (vazio -> desligado)
+    uint32_t    shm_kb = 4096;         // tamanho do anel
+
+    // Filtro de contedo: arquivo de padres (vazio -> sem filtro)
+    std::string filter_path;
+
+    // Oramento de memria (0 desliga cada limite; ver MemBudget.hpp)
+    size_t line_max       = 64 * 1024;         // linha mais longa aceita de um cliente
+    size_t client_out_max = 8u << 20;          // sada pendente por cliente
+    size_t mem_budget     = size_t(256) << 20; // entrada + fila + sada + histrico
+
+    // Anexos (/file, /get): maior payload aceito (0 desliga; desligados at
+    // --attach-max) e diretrio do spool; o spool guarda at 4x o maior payload
+    size_t      attach_max = 0;
+    std::string spool_dir  = "/tmp";
+
+    // Captura do trfego de entrada para o chat_replay (vazio -> desligada)
+    std::string capture_path;
+
+    // Afinidade de CPU por papel (--cpu loop=2)
+    placement::Plan cpus;
+};
+
+inline void print_usage(const char* prog) {
+    std::cerr << "Uso: " << prog << " [porta] [opes]\n"
+              << "  --unix <caminho>         aceita clientes locais tambm por socket UNIX\n"
+              << "  --queue <n>              capacidade da fila de broadcast (padro 1024)\n"
+              << "  --queue-system <n>       capacidade da faixa de avisos (padro 256)\n"
+              << "  --queue-control <n>      capacidade da faixa de controle (padro 64)\n"
+              << "  --system-weight <n>      avisos por linha de chat na sada da fila (padro 4)\n"
+              << "  --history <n>            entradas guardadas no histrico (padro 200)\n"
+              << "  --log-level <nvel>      debug, info, warn ou error (padro debug)\n"
+              << "  --admin <caminho>        socket UNIX de administrao (ver chat_admin)\n"
+              << "  --node <id>              identificador do n na federao\n"
+              << "  --peer-port <porta>      aceita conexes de outros servidores\n"
+              << "  --peer <host:porta>      conecta a outro servidor (repetvel)\n"
+              << "  --trace <arquivo.json>   rastreia mensagens (dump no SIGUSR1 e ao encerrar)\n"
+              << "  --trace-every <n>        amostra 1 a cada n mensagens (padro 100)\n"
+              << "  --idle-timeout <s>       desconecta clientes sem enviar nada por s segundos\n"
+              << "  --heartbeat <s>          intervalo de PING entre peers (padro 10, 0 desliga)\n"
+              << "  --rate <linhas/s>        limite de linhas por segundo de cada cliente (0 desliga)\n"
+              << "  --burst <n>              rajada acima do limite (padro: igual a --rate)\n"
+              << "  --fanout-workers <n>     reparte o envio dos broadcasts entre n threads\n"
+              << "  --zerocopy <bytes>       MSG_ZEROCOPY para envios a partir desse tamanho (ex.: 16384)\n"
+              << "  --compress <0-9>         nvel da compresso pedida pelos clientes (padro 1, 0 recusa)\n"
+              << "  --shm <nome>             publica as mensagens num anel em memria compartilhada\n"
+              << "  --shm-size <KiB>         tamanho do anel (padro 4096)\n"
+              << "  --filter <arquivo>       termos mascarados/bloqueados (recarga: SIGHUP ou admin)\n"
+              << "  --capture <arquivo>      grava conexes e linhas recebidas (ver chat_replay)\n"
+              << "  --line-max <bytes>       linha mais longa aceita; acima, descartada (padro 65536)\n"
+              << "  --client-out-max <KiB>   sada pendente por cliente antes de derrub-lo (padro 8192)\n"
+              << "  --mem-budget <MiB>       oramento de memria: pausa leituras e corta lentos (padro 256)\n"
+              << "  --attach-max <MiB>       liga anexos (/file) at esse tamanho (padro 0: desligados)\n"
+              << "  --spool <dir>            diretrio dos anexos, sem nome no disco (padro /tmp)\n"
+              << "  --cpu <papel>=<cpus>     fixa um papel em CPUs (loop=2, fanout=3-5)\n"
+              << "Ex.: " << prog << " 5555 --peer-port 6555 --peer 127.0.0.1:6556\n";
+}
+
+// Retorna false se os argumentos forem invlidos.
+inline bool parse_args(int argc, char** argv, ServerConfig& cfg) {
+    auto port_of = [](std::string_view s) {
+        int v = std::stoi(std::string(s));
+        if (v <= 0 || v > 65535) throw std::out_of_range("porta");
+        return static_cast<uint16_t>(v);
+    };
+    try {
+        bool have_port = false;
+        for (int i = 1; i < argc; ++i) {
+            std::string_view a = argv[i];
+            auto value = [&]() -> std::string_view {
+                if (i + 1 >= argc) throw std::invalid_argument("faltou valor");
+                return argv[++i];
+            };
+            if (a == "--unix") {
+                cfg.unix_path = std::string(value());
+            } else if (a == "--queue") {
+                cfg.queue_cap = std::stoul(std::string(value()));
+                if (cfg.queue_cap == 0) return false;
+            } else if (a == "--queue-system") {
+                cfg.queue_system = std::stoul(std::string(value()));
+                if (cfg.queue_system == 0) return false;
+            } else if (a == "--queue-control") {
+                cfg.queue_control = std::stoul(std::string(value()));
+                if (cfg.queue_control == 0) return false;
+            } else if (a == "--system-weight") {
+                cfg.system_weight = static_cast<uint32_t>(std::stoul(std::string(value())));
+                if (cfg.system_weight == 0) return false;
+            } else if (a == "--history") {
+                cfg.history_max = std::stoul(std::string(value()));
+            } else if (a == "--log-level") {
+                if (!tslog::parse_level(value(), cfg.log_level)) return false;
+            } else if (a == "--admin") {
+                cfg.admin_path = std::string(value());
+            } else if (a == "--node") {
+                cfg.node_id = static_cast<uint32_t>(std::stoul(std::string(value())));
+            } else if (a == "--peer-port") {
+                cfg.peer_port = port_of(value());
+            } else if (a == "--peer") {
+                auto v = value();
+                auto colon = v.rfind(':');
+                if (colon == std::string_view::npos) return false;
+                cfg.peers.emplace_back(std::string(v.substr(0, colon)), port_of(v.substr(colon + 1)));
+            } else if (a == "--trace") {
+                cfg.trace_path = std::string(value());
+            } else if (a == "--trace-every") {
+                cfg.trace_every = static_cast<uint32_t>(std::stoul(std::string(value())));
+                if (cfg.trace_every == 0) return false;
+            } else if (a == "--idle-timeout") {
+                cfg.idle_timeout_s = static_cast<uint32_t>(std::stoul(std::string(value())));
+            } else if (a == "--heartbeat") {
+                cfg.heartbeat_s = static_cast<uint32_t>(std::stoul(std::string(value())));
+            } else if (a == "--rate") {
+                cfg.rate = static_cast<uint32_t>(std::stoul(std::string(value())));
+            } else if (a == "--burst") {
+                cfg.burst = static_cast<uint32_t>(std::stoul(std::string(value())));
+            } else if (a == "--fanout-workers") {
+                cfg.fanout_workers = static_cast<uint32_t>(std::stoul(std::string(value())));
+            } else if (a == "--zerocopy") {
+                cfg.zerocopy_min = static_cast<uint32_t>(std::stoul(std::string(value())));
+            } else if (a == "--compress") {
+                cfg.compress_level = std::stoi(std::string(value()));
+                if (cfg.compress_level < 0 || cfg.compress_level > 9) return false;
+            } else if (a == "--shm") {
+                cfg.shm_name = std::string(value());
+                if (!cfg.shm_name.starts_with("/")) cfg.shm_name.insert(0, "/");
+            } else if (a == "--shm-size") {
+                cfg.shm_kb = static_cast<uint32_t>(std::stoul(std::string(value())));
+            } else if (a == "--filter") {
+                cfg.filter_path = std::string(value());
+            } else if (a == "--capture") {
+                cfg.capture_path = std::string(value());
+            } else if (a == "--line-max") {
+                cfg.line_max = std::stoul(std::string(value()));
+            } else if (a == "--client-out-max") {
+                cfg.client_out_max = std::stoul(std::string(value())) << 10;
+            } else if (a == "--mem-budget") {
+                cfg.mem_budget = std::stoul(std::string(value())) << 20;
+            } else if (a == "--attach-max") {
+                cfg.attach_max = std::stoul(std::string(value())) << 20;
+            } else if (a == "--spool") {
+                cfg.spool_dir = std::string(value());
+            } else if (a == "--cpu") {
+                if (!placement::parse_assignment(value(), cfg.cpus)) return false;
+            } else if (!have_port && !a.starts_with("--")) {
+                cfg.port  = port_of(a);
+                have_port = true;
+            } else {
+                return false;
+            }
+        }
+    } catch (const std::exception&) {
+        return false;
+    }
+    if (cfg.node_id == 0) cfg.node_id = cfg.port;
+    if (cfg.burst == 0) cfg.burst = cfg.rate;
+    return true;
+}
@@ -0,0 +1,392 @@
+#pragma once
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <vector>
+#include <cerrno>
+#include <unistd.h>
+#include <sys/epoll.h>
+#include <sys/eventfd.h>
+#include <sys/socket.h>
+
+#include "common/placement.hpp"
+
+// Fanout paralelo (--fanout-workers N): os clientes so repartidos por fd
+// entre N threads de envio, e cada uma guarda os fds da sua partio num
+// vetor contguo. O broadcaster publica cada mensagem uma vez (um buffer
+// compartilhado e imutvel) na fila de cada worker, e cada worker a envia
+// para a sua partio, em paralelo com os outros.
+//
+// Com o pool ativo, o worker  o nico que escreve nos sockets da sua
+// partio: respostas, DMs e o replay do histrico tambm passam pela fila
+// dele (unicast), na ordem em que a thread do EventLoop os emitiu. Como
+// essa ordem  a ordem de publicao, cada destinatrio recebe as
+// mensagens de cada remetente na ordem original. Tambm  o worker quem
+// fecha o fd, depois de tir-lo da partio, para que um fd reaproveitado
+// nunca receba bytes da conexo anterior. Um fd fechado com sada pendente
+// (o aviso de um kick, o do encerramento) ainda a escoa, por at kDrainMs.
+//
+// Todas as chamadas pblicas (menos stats) so da thread do EventLoop.
+class FanoutPool {
+public:
+    using Bytes = std::shared_ptr<const std::string>;
+
+    struct Stats {
+        uint64_t broadcasts = 0; // mensagens publicadas (por worker)
+        uint64_t sends      = 0; // envios a clientes
+        uint64_t backlogged = 0; // envios que deixaram bytes pendentes
+        uint64_t failures   = 0; // clientes derrubados por erro de envio
+        uint64_t slow       = 0; // clientes derrubados por passar do limite de sada pendente
+        uint64_t pending    = 0; // bytes pendentes agora (todas as parties)
+    };
+
+    FanoutPool(size_t workers, const placement::Plan& plan) {
+        for (size_t i = 0; i < workers; ++i) {
+            auto w = std::make_unique<Worker>();
+            w->ep  = ::epoll_create1(EPOLL_CLOEXEC);
+            w->efd = ::eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+            epoll_event ev{};
+            ev.events  = EPOLLIN;
+            ev.data.fd = w->efd;
+            ::epoll_ctl(w->ep, EPOLL_CTL_ADD, w->efd, &ev);
+            workers_.push_back(std::move(w));
+        }
+        for (size_t i = 0; i < workers; ++i) {
+            workers_[i]->th = std::thread([this, i, plan] {
+                placement::pin_worker(plan, placement::Role::Fanout, i, "chat-fanout");
+                run(*workers_[i]);
+            });
+        }
+    }
+    ~FanoutPool() { stop(); }
+    FanoutPool(const FanoutPool&) = delete;
+    FanoutPool& operator=(const FanoutPool&) = delete;
+
+    size_t workers() const { return workers_.size(); }
+
+    // O fd passa a receber broadcasts (`tagged`: a verso numerada).
+    void add(int fd, bool tagged) { post(owner(fd), Item{Kind::Add, fd, tagged, {}, {}}); }
+
+    // O fd passa a receber a verso numerada dos broadcasts.
+    void tag(int fd) { post(owner(fd), Item{Kind::Tag, fd, true, {}, {}}); }
+
+    // Para de enviar para o fd e o fecha (na thread dona).
+    void close(int fd) { post(owner(fd), Item{Kind::Close, fd, false, {}, {}}); }
+
+    void unicast(int fd, Bytes b) { post(owner(fd), Item{Kind::Unicast, fd, false, std::move(b), {}}); }
+
+    // `plain` nulo: s as sesses numeradas recebem.
+    void broadcast(const Bytes& plain, const Bytes& tagged) {
+        for (auto& w : workers_) post(*w, Item{Kind::Broadcast, -1, false, plain, tagged});
+    }
+
+    // Envia o que j foi publicado, escoa o que ficou pendente (at
+    // kDrainMs), fecha os fds restantes e junta as threads.
+    void stop() {
+        for (auto& w : workers_) {
+            if (!w->th.joinable()) continue;
+            post(*w, Item{Kind::Stop, -1, false, {}, {}});
+            w->th.join();
+            ::close(w->efd);
+            ::close(w->ep);
+        }
+    }
+
+    Stats stats() const {
+        Stats s;
+        for (auto& w : workers_) {
+            s.broadcasts += w->broadcasts.load(std::memory_order_relaxed);
+            s.sends      += w->sends.load(std::memory_order_relaxed);
+            s.backlogged += w->backlogged.load(std::memory_order_relaxed);
+            s.failures   += w->failures.load(std::memory_order_relaxed);
+            s.slow       += w->slow.load(std::memory_order_relaxed);
+            s.pending    += w->pending_bytes.load(std::memory_order_relaxed);
+        }
+        return s;
+    }
+
+    // Sada pendente mxima por cliente (0 = sem limite): acima dela, o
+    // worker derruba o cliente lento no prximo envio ou escoamento.
+    void set_out_cap(size_t bytes) { out_cap_.store(bytes, std::memory_order_relaxed); }
+
+private:
+    static constexpr int kDrainMs = 2000; // prazo para escoar o pendente de quem fecha
+    static constexpr int kSweepMs = 100;  // varredura dos que fecham (s se houver)
+
+    enum class Kind : uint8_t { Add, Tag, Close, Unicast, Broadcast, Stop };
+    struct Item {
+        Kind  kind;
+        int   fd;
+        bool  tagged;
+        Bytes a; // unicast / broadcast simples
+        Bytes b; // broadcast numerado
+    };
+
+    // Partio: vetor denso de alvos (iterado a cada broadcast) e,  parte,
+    // os bytes pendentes de quem no absorveu tudo.
+    struct Target {
+        int      fd;
+        uint32_t flags;        // kTagged | kDead | kClosing
+        uint64_t close_by = 0; // kClosing: fecha nesse instante (ms), escoado ou no
+    };
+    static constexpr uint32_t kTagged  = 1u << 0;
+    static constexpr uint32_t kDead    = 1u << 1;
+    static constexpr uint32_t kClosing = 1u << 2; // Close com pendente: s escoa
+
+    struct alignas(placement::kCacheLine) Worker {
+        std::mutex        m;
+        std::vector<Item> q;    // protegido por m
+        int               ep  = -1;
+        int               efd = -1;
+        std::thread       th;
+
+        // S a thread do worker mexe daqui para baixo
+        std::vector<Target>      targets;
+        std::vector<std::string> pending; // paralelo a targets
+        std::vector<int32_t>     pos;     // fd -> ndice em targets (-1 = fora)
+        size_t                   closing    = 0; // alvos com kClosing
+        uint64_t                 next_sweep = 0;
+
+        alignas(placement::kCacheLine) std::atomic<uint64_t> broadcasts{0};
+        std::atomic<uint64_t> sends{0}, backlogged{0}, failures{0}, slow{0};
+        std::atomic<uint64_t> pending_bytes{0}; // soma de pending (s o worker escreve)
+    };
+    std::vector<std::unique_ptr<Worker>> workers_;
+    std::atomic<size_t>                  out_cap_{0};
+
+    Worker& owner(int fd) { return *workers_[static_cast<size_t>(fd) % workers_.size()]; }
+
+    static uint64_t now_ms() {
+        using namespace std::chrono;
+        return static_cast<uint64_t>(duration_cast<milliseconds>(steady_clock::now().time_since_epoch()).count());
+    }
+
+    static void post(Worker& w, Item&& it) {
+        bool was_empty;
+        {
+            std::lock_guard<std::mutex> lk(w.m);
+            was_empty = w.q.empty();
+            w.q.push_back(std::move(it));
+        }
+        if (was_empty) { // o worker esvazia a fila inteira a cada aviso
+            const uint64_t one = 1;
+            [[maybe_unused]] ssize_t r = ::write(w.efd, &one, sizeof(one));
+        }
+    }
+
+    void run(Worker& w) {
+        std::vector<Item> batch;
+        epoll_event evs[64];
+        for (;;) {
+            const int n = ::epoll_wait(w.ep, evs, 64, w.closing ? kSweepMs : -1);
+            if (n < 0 && errno != EINTR) break;
+            for (int i = 0; i < n; ++i) {
+                if (evs[i].data.fd == w.efd) {
+                    uint64_t v;
+                    [[maybe_unused]] ssize_t r = ::read(w.efd, &v, sizeof(v));
+                } else {
+                    flush(w, evs[i].data.fd);
+                }
+            }
+            {
+                std::lock_guard<std::mutex> lk(w.m);
+                batch.swap(w.q);
+            }
+            bool stop = false;
+            for (auto& it : batch) stop |= apply(w, it);
+            batch.clear();
+            if (stop) break;
+            if (w.closing && now_ms() >= w.next_sweep) sweep(w);
+        }
+        drain(w);
+        for (auto& t : w.targets) ::close(t.fd);
+        w.targets.clear();
+    }
+
+    // Encerramento: s escoa os pendentes (nada novo chega depois do Stop),
+    // at esvaziar ou o prazo acabar.
+    void drain(Worker& w) {
+        using namespace std::chrono;
+        const auto deadline = steady_clock::now() + milliseconds(kDrainMs);
+        epoll_event evs[64];
+        for (;;) {
+            bool left = false;
+            for (size_t i = 0; i < w.targets.size() && !left; ++i) {
+                left = !w.pending[i].empty() && !(w.targets[i].flags & kDead);
+            }
+            const auto ms = duration_cast<milliseconds>(deadline - steady_clock::now()).count();
+            if (!left || ms <= 0) return;
+            const int n = ::epoll_wait(w.ep, evs, 64, static_cast<int>(ms));
+            if (n < 0 && errno != EINTR) return;
+            for (int i = 0; i < n; ++i) {
+                if (evs[i].data.fd != w.efd) flush(w, evs[i].data.fd);
+            }
+        }
+    }
+
+    // true = Stop
+    bool apply(Worker& w, Item& it) {
+        switch (it.kind) {
+        case Kind::Add: {
+            const int fd = it.fd;
+            if (static_cast<size_t>(fd) >= w.pos.size()) w.pos.resize(fd + 1, -1);
+            w.pos[fd] = static_cast<int32_t>(w.targets.size());
+            w.targets.push_back(Target{fd, it.tagged ? kTagged : 0});
+            w.pending.emplace_back();
+            epoll_event ev{};
+            ev.events  = EPOLLOUT | EPOLLET;
+            ev.data.fd = fd;
+            ::epoll_ctl(w.ep, EPOLL_CTL_ADD, fd, &ev);
+            return false;
+        }
+        case Kind::Tag:
+            if (const int32_t i = index(w, it.fd); i >= 0) w.targets[i].flags |= kTagged;
+            return false;
+        case Kind::Close: {
+            const int32_t i = index(w, it.fd);
+            if (i < 0) { ::close(it.fd); return false; }
+            Target& t = w.targets[i];
+            // Ainda com sada pendente: s escoa (nada novo entra) e fecha
+            // ao esvaziar ou no prazo. O fd segue aberto, ento o nmero no
+            //  reaproveitado antes disso.
+            if (!w.pending[i].empty() && !(t.flags & (kDead | kClosing))) {
+                t.flags |= kClosing;
+                t.close_by = now_ms() + kDrainMs;
+                if (w.closing++ == 0) w.next_sweep = now_ms() + kSweepMs;
+                return false;
+            }
+            if (!(t.flags & kClosing)) remove(w, static_cast<size_t>(i));
+            return false;
+        }
+        case Kind::Unicast:
+            // Fora da partio (j fechado): descarta; o fd pode ser de outra conexo
+            if (const int32_t i = index(w, it.fd); i >= 0) send_to(w, static_cast<size_t>(i), *it.a);
+            return false;
+        case Kind::Broadcast:
+            w.broadcasts.fetch_add(1, std::memory_order_relaxed);
+            for (size_t i = 0; i < w.targets.size(); ++i) {
+                const Bytes& m = (w.targets[i].flags & kTagged) && it.b ? it.b : it.a;
+                if (m) send_to(w, i, *m);
+            }
+            return false;
+        case Kind::Stop:
+            return true;
+        }
+        return false;
+    }
+
+    // Tira o alvo da partio e fecha o fd.
+    void remove(Worker& w, size_t i) {
+        const int fd = w.targets[i].fd;
+        if (w.targets[i].flags & kClosing) --w.closing;
+        ::epoll_ctl(w.ep, EPOLL_CTL_DEL, fd, nullptr);
+        w.pos[fd] = -1;
+        const size_t last = w.targets.size() - 1;
+        settle(w, w.pending[i], 0);
+        if (i != last) {
+            w.targets[i] = w.targets[last];
+            w.pending[i].swap(w.pending[last]);
+            w.pos[w.targets[i].fd] = static_cast<int32_t>(i);
+        }
+        w.targets.pop_back();
+        w.pending.pop_back();
+        ::close(fd);
+    }
+
+    // Fecha os que estavam escoando e passaram do prazo (ou morreram).
+    void sweep(Worker& w) {
+        const uint64_t now = now_ms();
+        for (size_t i = 0; i < w.targets.size();) {
+            const Target& t = w.targets[i];
+            if ((t.flags & kClosing) && (now >= t.close_by || (t.flags & kDead))) remove(w, i);
+            else ++i;
+        }
+        w.next_sweep = now + kSweepMs;
+    }
+
+    static int32_t index(const Worker& w, int fd) {
+        return (fd >= 0 && static_cast<size_t>(fd) < w.pos.size()) ? w.pos[fd] : -1;
+    }
+
+    static ssize_t send_some(int fd, const char* p, size_t len) {
+        for (;;) {
+            ssize_t n = ::send(fd, p, len, MSG_NOSIGNAL | MSG_DONTWAIT);
+            if (n >= 0) return n;
+            if (errno == EINTR) continue;
+            if (errno == EAGAIN || errno == EWOULDBLOCK) return 0;
+            return -1;
+        }
+    }
+
+    // Envia ou, se houver fila, anexa: a ordem por destinatrio  a de chegada.
+    void send_to(Worker& w, size_t i, std::string_view data) {
+        Target& t = w.targets[i];
+        if (t.flags & (kDead | kClosing)) return;
+        std::string& pend = w.pending[i];
+        w.sends.fetch_add(1, std::memory_order_relaxed);
+        if (!pend.empty()) {
+            pend.append(data);
+            w.pending_bytes.fetch_add(data.size(), std::memory_order_relaxed);
+            check_cap(w, t);
+            return;
+        }
+        const ssize_t n = send_some(t.fd, data.data(), data.size());
+        if (n < 0) { fail(w, t); return; }
+        if (static_cast<size_t>(n) < data.size()) {
+            pend.append(data.substr(static_cast<size_t>(n)));
+            w.pending_bytes.fetch_add(pend.size(), std::memory_order_relaxed);
+            w.backlogged.fetch_add(1, std::memory_order_relaxed);
+            check_cap(w, t);
+        }
+    }
+
+    // Cliente lento: pendente acima do limite derruba como um erro de envio,
+    // mas conta s em `slow`
+    void check_cap(Worker& w, Target& t) {
+        const size_t cap = out_cap_.load(std::memory_order_relaxed);
+        if (cap == 0 || w.pending[static_cast<size_t>(&t - w.targets.data())].size() <= cap) return;
+        w.slow.fetch_add(1, std::memory_order_relaxed);
+        kill(w, t);
+    }
+
+    // Ajusta o total pendente do worker para o novo tamanho de `pend`
+    static void settle(Worker& w, std::string& pend, size_t keep) {
+        w.pending_bytes.fetch_sub(pend.size() - keep, std::memory_order_relaxed);
+    }
+
+    // Socket voltou a aceitar dados: escoa o pendente.
+    void flush(Worker& w, int fd) {
+        const int32_t i = index(w, fd);
+        if (i < 0) return;
+        Target& t = w.targets[i];
+        std::string& pend = w.pending[i];
+        if (pend.empty() || (t.flags & kDead)) return;
+        const ssize_t n = send_some(fd, pend.data(), pend.size());
+        if (n < 0) { fail(w, t); return; }
+        settle(w, pend, pend.size() - static_cast<size_t>(n));
+        pend.erase(0, static_cast<size_t>(n));
+        if (pend.empty() && (t.flags & kClosing)) { remove(w, static_cast<size_t>(i)); return; }
+        check_cap(w, t); // o limite pode ter cado (presso de memria)
+    }
+
+    // Erro de envio: a sesso (na thread do loop) v EOF, encerra e manda Close.
+    static void fail(Worker& w, Target& t) {
+        w.failures.fetch_add(1, std::memory_order_relaxed);
+        kill(w, t);
+    }
+
+    // Para de enviar ao alvo, solta o pendente e derruba a conexo.
+    static void kill(Worker& w, Target& t) {
+        t.flags |= kDead;
+        std::string& pend = w.pending[static_cast<size_t>(&t - w.targets.data())];
+        settle(w, pend, 0);
+        pend.clear();
+        pend.shrink_to_fit();
+        ::shutdown(t.fd, SHUT_RDWR);
+    }
+};
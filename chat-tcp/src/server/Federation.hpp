@@ -0,0 +1,135 @@
+#pragma once
+#include <algorithm>
+#include <charconv>
+#include <cstdint>
+#include <deque>
+#include <limits>
+#include <memory>
+#include <string>
+#include <string_view>
+#include <unordered_set>
+#include <vector>
+
+#include "common/event_loop.hpp"
+#include "common/pool.hpp"
+#include "server/Message.hpp"
+
+// Federao: servidores trocam mensagens por enlaces TCP prprios (porta de
+// peers), em linhas de texto:
+//   HELLO <node>                             primeira linha de cada lado
+//   H <origin> <epoch> <seq> <ts_us> <texto> entrada do histrico (merge, sem fanout)
+//   M <origin> <epoch> <seq> <ts_us> <texto> mensagem ao vivo (fanout + repasse)
+// Cada mensagem  identificada por (origin, epoch, seq); duplicatas so
+// descartadas, ento a malha pode ter ciclos e o repasse  feito por inundao.
+// A epoch muda a cada incio do n: seq recomea do zero aps um reincio e,
+// sem ela, os peers tomariam as mensagens novas por duplicatas das antigas.
+
+struct PeerLink {
+    std::shared_ptr<Connection> conn;
+    std::string name;                 // host:porta ou "entrada fd=N"
+    uint32_t    node = 0;             // id anunciado no HELLO
+    std::string batch;                // frames aguardando o prximo envio
+    bool        flush_pending = false;
+    uint64_t    frames = 0;           // frames enviados
+    uint64_t    sends  = 0;           // envios (lotes) realizados
+};
+
+// Maior campo numrico de um frame: dgitos, sinal e o espao que o segue.
+template <typename T>
+inline constexpr size_t kFieldMax = std::numeric_limits<T>::digits10 + 1 + 1 + 1;
+
+inline void append_frame(std::string& out, char kind, const Message& m) {
+    constexpr size_t kHeadMax = 2 + kFieldMax<decltype(Message::origin)> + kFieldMax<decltype(Message::epoch)> +
+                                kFieldMax<decltype(Message::seq)> + kFieldMax<decltype(Message::ts_us)>;
+    char head[kHeadMax];
+    char* p = head;
+    *p++ = kind;
+    *p++ = ' ';
+    // head cabe o pior caso; ainda assim, cada nmero termina antes do
+    // ltimo byte, e o espao nunca passa do fim (to_chars devolve o limite
+    // dado se falhar)
+    auto field = [&](auto v) {
+        p = std::to_chars(p, head + sizeof(head) - 1, v).ptr;
+        *p++ = ' ';
+    };
+    field(m.origin);
+    field(m.epoch);
+    field(m.seq);
+    field(m.ts_us);
+    out.append(head, p);
+    out.append(m.text.data(), m.text.size()); // j termina em '\n'
+}
+
+// Decodifica uma linha H/M (sem o '\n'). Retorna false se malformada.
+inline bool parse_frame(std::string_view line, char& kind, Message& m) {
+    if (line.size() < 2 || (line[0] != 'H' && line[0] != 'M') || line[1] != ' ') return false;
+    kind = line[0];
+    line.remove_prefix(2);
+    auto field = [&](auto& v) {
+        auto sp = line.find(' ');
+        if (sp == std::string_view::npos) return false;
+        auto [p, ec] = std::from_chars(line.data(), line.data() + sp, v);
+        if (ec != std::errc{} || p != line.data() + sp) return false;
+        line.remove_prefix(sp + 1);
+        return true;
+    };
+    if (!field(m.origin) || !field(m.epoch) || !field(m.seq) || !field(m.ts_us)) return false;
+    m.text.assign(line);
+    m.text += '\n';
+    return true;
+}
+
+// Conjunto limitado dos ids (origin, epoch, seq) vistos recentemente.
+class DedupCache {
+public:
+    explicit DedupCache(size_t capacity = 8192) : capacity_(capacity) {}
+
+    // true se o id  novo (e passa a ser lembrado)
+    bool insert(uint32_t origin, uint64_t epoch, uint64_t seq) {
+        Key k{origin, epoch, seq};
+        if (!set_.insert(k).second) return false;
+        order_.push_back(k);
+        if (order_.size() > capacity_) { set_.erase(order_.front()); order_.pop_front(); }
+        return true;
+    }
+
+private:
+    struct Key {
+        uint32_t origin;
+        uint64_t epoch;
+        uint64_t seq;
+        bool operator==(const Key&) const = default;
+    };
+    struct KeyHash {
+        size_t operator()(const Key& k) const noexcept {
+            return std::hash<uint64_t>{}((k.seq * 0x9E3779B97F4A7C15ull ^ k.epoch) * 0x9E3779B97F4A7C15ull ^ k.origin);
+        }
+    };
+    // Ns e blocos vm do pool: inserir/expirar ids no chama malloc
+    size_t capacity_;
+    std::unordered_set<Key, KeyHash, std::equal_to<Key>, pool::Allocator<Key>> set_;
+    std::deque<Key, pool::Allocator<Key>> order_;
+};
+
+// Latncia de entrega entre ns (relgio de parede da origem -> chegada).
+class LatencyStats {
+public:
+    void add(int64_t us) { samples_.push_back(std::max<int64_t>(us, 0)); }
+    size_t count() const { return samples_.size(); }
+
+    // "n=.. p50=..us p99=..us max=..us" e zera as amostras
+    std::string take_summary() {
+        if (samples_.empty()) return "n=0";
+        std::sort(samples_.begin(), samples_.end());
+        auto pct = [&](double p) { return samples_[static_cast<size_t>(p * (samples_.size() - 1))]; };
+        std::string s = "n=" + std::to_string(samples_.size()) +
+                        " p50=" + std::to_string(pct(0.50)) + "us" +
+                        " p99=" + std::to_string(pct(0.99)) + "us" +
+                        " max=" + std::to_string(samples_.back()) + "us";
+        samples_.clear();
+        return s;
+    }
+
+private:
+    std::vector<int64_t> samples_;
+};
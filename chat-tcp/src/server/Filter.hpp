@@ -0,0 +1,273 @@
+#pragma once
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <cstring>
+#include <fstream>
+#include <functional>
+#include <mutex>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <utility>
+#include <vector>
+
+#include "common/rcu.hpp"
+
+// Filtro de contedo entre o enquadramento da linha e a fila de broadcast.
+//
+// Pipeline: etapas aplicadas em ordem a cada linha recebida; cada uma pode
+// deixar passar, alterar a linha ou bloque-la. TermFilter  a etapa de
+// termos proibidos: um autmato de Aho-Corasick compilado para um DFA
+// completo, com os bytes agrupados em classes de equivalncia (s os bytes
+// que aparecem em algum padro tm classe prpria). A varredura  uma
+// consulta de tabela por byte, quantos padres houver: milhares de termos
+// custam uma passada sobre a mensagem.
+namespace filter {
+
+enum class Verdict : uint8_t { Pass, Masked, Block };
+
+// --------- Autmato de mltiplos padres ----------
+// Padres sem diferena de maisculas/minsculas (ASCII). Ao por padro:
+// Mask troca o trecho por '*'; Block descarta a mensagem inteira.
+class Matcher {
+public:
+    enum class Action : uint8_t { Mask, Block };
+    struct Pattern {
+        std::string text;
+        Action      action = Action::Mask;
+    };
+
+    Matcher() { cls_.fill(0); table_.assign(2, 0); }
+
+    explicit Matcher(const std::vector<Pattern>& pats) : patterns_(pats.size()) {
+        // Classes: 0 = byte ausente dos padres; letras juntam as duas caixas
+        cls_.fill(0);
+        for (auto& p : pats) {
+            for (unsigned char ch : p.text) {
+                const unsigned char lo = lower(ch);
+                if (cls_[lo] == 0) cls_[lo] = static_cast<uint8_t>(++ncls_); // no mximo 230
+            }
+        }
+        for (int ch = 'A'; ch <= 'Z'; ++ch) cls_[ch] = cls_[ch - 'A' + 'a'];
+        ++ncls_; // conta a classe 0
+
+        // Trie direto na tabela final (-1 = sem aresta ainda)
+        delta_.assign(ncls_, -1);
+        out_.assign(1, 0);
+        for (auto& p : pats) {
+            if (p.text.empty()) continue;
+            int32_t s = 0;
+            for (unsigned char ch : p.text) {
+                int32_t& next = delta_[size_t(s) * ncls_ + cls_[ch]];
+                if (next < 0) {
+                    next = static_cast<int32_t>(out_.size());
+                    out_.push_back(0);
+                    delta_.resize(delta_.size() + ncls_, -1);
+                }
+                s = delta_[size_t(s) * ncls_ + cls_[ch]];
+            }
+            uint32_t& o = out_[s];
+            if (p.action == Action::Block) o |= kBlock;
+            else o = std::max(o & kLenMask, static_cast<uint32_t>(p.text.size())) | (o & kBlock);
+        }
+
+        // BFS: falhas resolvidas na prpria tabela (DFA completo) e sadas
+        // herdadas do sufixo mais longo que tambm  padro
+        std::vector<int32_t> fail(out_.size(), 0), queue;
+        queue.reserve(out_.size());
+        for (size_t c = 0; c < ncls_; ++c) {
+            int32_t& t = delta_[c];
+            if (t < 0) t = 0;
+            else queue.push_back(t);
+        }
+        for (size_t qi = 0; qi < queue.size(); ++qi) {
+            const int32_t u = queue[qi];
+            const uint32_t fo = out_[fail[u]];
+            out_[u] = std::max(out_[u] & kLenMask, fo & kLenMask) | ((out_[u] | fo) & kBlock);
+            for (size_t c = 0; c < ncls_; ++c) {
+                int32_t& t = delta_[size_t(u) * ncls_ + c];
+                const int32_t via_fail = delta_[size_t(fail[u]) * ncls_ + c];
+                if (t < 0) { t = via_fail; continue; }
+                fail[t] = via_fail;
+                queue.push_back(t);
+            }
+        }
+
+        // Tabela final: uma linha por estado com as transies j como
+        // deslocamento da linha de destino e, na ltima coluna, a sada
+        const size_t stride = ncls_ + 1;
+        table_.assign(out_.size() * stride, 0);
+        for (size_t st = 0; st < out_.size(); ++st) {
+            for (size_t c = 0; c < ncls_; ++c) table_[st * stride + c] = uint32_t(delta_[st * ncls_ + c]) * stride;
+            table_[st * stride + ncls_] = out_[st];
+        }
+        states_ = out_.size();
+        delta_  = {};
+        out_    = {};
+    }
+
+    // Uma passada: mascara os trechos casados; Block no primeiro padro de
+    // bloqueio (a linha  descartada, o que j foi mascarado no importa).
+    Verdict apply(std::string& s) const {
+        if (patterns_ == 0) return Verdict::Pass;
+        char* p = s.data();
+        const size_t n = s.size();
+        const uint32_t* t = table_.data();
+        const uint8_t* cls = cls_.data();
+        const size_t out_col = ncls_;
+        bool masked = false;
+        uint32_t row = 0;
+        for (size_t i = 0; i < n; ++i) {
+            row = t[row + cls[static_cast<unsigned char>(p[i])]];
+            if (const uint32_t o = t[row + out_col]) [[unlikely]] {
+                if (o & kBlock) return Verdict::Block;
+                const size_t len = o & kLenMask;
+                std::memset(p + i + 1 - len, '*', len);
+                masked = true;
+            }
+        }
+        return masked ? Verdict::Masked : Verdict::Pass;
+    }
+
+    size_t patterns() const { return patterns_; }
+    size_t states()   const { return states_; }
+    size_t classes()  const { return ncls_; }
+
+private:
+    static constexpr uint32_t kBlock   = 1u << 31;
+    static constexpr uint32_t kLenMask = kBlock - 1;
+
+    std::array<uint8_t, 256> cls_;   // byte -> classe
+    size_t                   ncls_ = 1;
+    std::vector<uint32_t>    table_; // linhas de ncls_ + 1: transies e sada
+    size_t                   states_ = 1;
+    size_t                   patterns_ = 0;
+
+    // S durante a construo
+    std::vector<int32_t>     delta_; // estado * ncls_ + classe -> estado
+    std::vector<uint32_t>    out_;   // maior padro Mask que termina aqui | kBlock
+
+    static unsigned char lower(unsigned char ch) { return (ch >= 'A' && ch <= 'Z') ? ch - 'A' + 'a' : ch; }
+};
+
+// Arquivo de padres: um por linha; "!" no incio bloqueia em vez de
+// mascarar; "#" comenta. false se no abriu.
+inline bool load_patterns(const std::string& path, std::vector<Matcher::Pattern>& out) {
+    static constexpr size_t kMaxPattern = 256;
+    std::ifstream in(path);
+    if (!in) return false;
+    std::string line;
+    while (std::getline(in, line)) {
+        while (!line.empty() && (line.back() == '\r' || line.back() == ' ')) line.pop_back();
+        if (line.empty() || line[0] == '#') continue;
+        Matcher::Pattern p;
+        if (line[0] == '!') { p.action = Matcher::Action::Block; line.erase(0, 1); }
+        if (line.empty() || line.size() > kMaxPattern) continue;
+        p.text = std::move(line);
+        out.push_back(std::move(p));
+    }
+    return true;
+}
+
+// --------- Etapa de termos, recarregvel sem pausa ----------
+// A thread do loop l o autmato atual por RCU; uma recarga compila o novo
+// numa thread  parte e o publica com uma troca de ponteiro. Linhas em
+// curso terminam com o autmato antigo, as seguintes j usam o novo.
+class TermFilter {
+public:
+    TermFilter() = default;
+    ~TermFilter() { if (builder_.joinable()) builder_.join(); }
+    TermFilter(const TermFilter&) = delete;
+    TermFilter& operator=(const TermFilter&) = delete;
+
+    Verdict apply(std::string& line) const { return cell_.read()->apply(line); }
+
+    // Carga sncrona (na partida). false se o arquivo no abriu.
+    bool load(const std::string& path) {
+        std::vector<Matcher::Pattern> pats;
+        if (!load_patterns(path, pats)) return false;
+        cell_.publish(new Matcher(pats));
+        return true;
+    }
+
+    // Recarga em segundo plano; false se j h uma em andamento.
+    bool reload(std::string path) {
+        if (building_.exchange(true)) return false;
+        if (builder_.joinable()) builder_.join();
+        builder_ = std::thread([this, path = std::move(path)] {
+            std::vector<Matcher::Pattern> pats;
+            const auto t0 = std::chrono::steady_clock::now();
+            std::string status;
+            if (!load_patterns(path, pats)) {
+                status = "erro: no foi possvel ler " + path;
+            } else {
+                auto* m = new Matcher(pats);
+                const auto ms = std::chrono::duration_cast<std::chrono::milliseconds>(
+                    std::chrono::steady_clock::now() - t0).count();
+                status = "ok " + std::to_string(m->patterns()) + " padres, " + std::to_string(m->states()) +
+                         " estados, " + std::to_string(m->classes()) + " classes, compilado em " +
+                         std::to_string(ms) + " ms";
+                cell_.publish(m);
+            }
+            {
+                std::lock_guard<std::mutex> lk(m_);
+                status_ = std::move(status);
+            }
+            building_.store(false, std::memory_order_release);
+        });
+        return true;
+    }
+
+    bool reloading() const { return building_.load(std::memory_order_acquire); }
+
+    // Resultado da ltima recarga.
+    std::string status() const {
+        std::lock_guard<std::mutex> lk(m_);
+        return status_;
+    }
+
+    size_t patterns() const { return cell_.read()->patterns(); }
+
+private:
+    rcu::Cell<Matcher> cell_;    // escritor: load() ou a thread de recarga, nunca juntos
+    std::atomic<bool>  building_{false};
+    std::thread        builder_;
+    mutable std::mutex m_;
+    std::string        status_;
+};
+
+// --------- Pipeline ----------
+// Etapas plugveis, aplicadas em ordem; a primeira que bloqueia encerra.
+class Pipeline {
+public:
+    using Stage = std::function<Verdict(std::string&)>;
+
+    void add(std::string name, Stage stage) { stages_.push_back({std::move(name), std::move(stage)}); }
+    bool empty() const { return stages_.empty(); }
+
+    // `blocked_by` recebe o nome da etapa que bloqueou.
+    Verdict run(std::string& line, std::string_view* blocked_by = nullptr) {
+        Verdict v = Verdict::Pass;
+        for (auto& s : stages_) {
+            const Verdict r = s.fn(line);
+            if (r == Verdict::Block) {
+                if (blocked_by) *blocked_by = s.name;
+                return r;
+            }
+            if (r == Verdict::Masked) v = r;
+        }
+        return v;
+    }
+
+private:
+    struct Named {
+        std::string name;
+        Stage       fn;
+    };
+    std::vector<Named> stages_;
+};
+
+} // namespace filter
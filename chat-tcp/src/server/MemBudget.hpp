@@ -0,0 +1,150 @@
+#pragma once
+#include <algorithm>
+#include <cstdint>
+#include <cstdio>
+#include <string>
+#include <unistd.h>
+
+// Oramento de memria do servidor: bytes por sesso e no total, somando
+// buffers de entrada, fila de broadcast, buffers de sada e histrico.
+//
+// Por sesso, os limites valem sempre:
+//  - linha acima de line_max  descartada inteira, e o cliente  avisado
+//    (Connection::line_max, ver async_read_line);
+//  - sada pendente acima de out_cap() derruba o cliente lento.
+//
+// No total, o governador mede o uso (assess) e sobe de nvel conforme a
+// presso, nesta ordem de corte:
+//  - Throttle (>= 80% do oramento): as sesses param de ler; o que os
+//    clientes mandam fica no kernel e o TCP os segura.
+//  - Shed (>= 95%, ou o uso no caiu em kEscalateMs de pausa): o limite
+//    de sada por cliente cai para 1/8 e quem estiver acima dele 
+//    derrubado. A pausa sozinha no libera a sada de quem no l.
+// O nvel s volta abaixo de uma marca menor (histerese), para no oscilar
+// a cada medida. O histrico tem teto prprio (1/4 do oramento).
+namespace membudget {
+
+enum class Level : uint8_t { Normal, Throttle, Shed };
+
+inline const char* level_name(Level l) {
+    switch (l) {
+        case Level::Normal:   return "normal";
+        case Level::Throttle: return "pausa";
+        default:              return "corte";
+    }
+}
+
+// Bytes em uso por categoria, medidos pelo governador
+struct Usage {
+    size_t input   = 0; // acumulado de linhas ainda sem '\n'
+    size_t queue   = 0; // mensagens na fila de broadcast
+    size_t output  = 0; // sada pendente de clientes lentos
+    size_t history = 0; // histrico e suas verses concatenada e comprimida
+    size_t codec   = 0; // estado dos compressores das sesses
+    size_t total() const { return input + queue + output + history + codec; }
+};
+
+class Budget {
+public:
+    static constexpr size_t   kShedFloor  = 64 * 1024; // limite de sada mnimo no corte
+    static constexpr uint64_t kEscalateMs = 1000;      // pausa sem queda de uso -> corte
+
+    // Zeros desligam: line_max (linha), client_out_max (sada por cliente),
+    // total_max (oramento global e o governador)
+    Budget(size_t line_max, size_t client_out_max, size_t total_max)
+      : line_max_(line_max), client_out_max_(client_out_max), total_max_(total_max) {}
+
+    // Reavalia o nvel com o uso atual. true se mudou.
+    bool assess(const Usage& u, uint64_t now_ms) {
+        last_ = u;
+        peak_ = std::max(peak_, u.total());
+        if (total_max_ == 0) return false;
+        const size_t t = u.total();
+        Level next = level_;
+        switch (level_) {
+            case Level::Normal:
+                if (t >= pct(95))      next = Level::Shed;
+                else if (t >= pct(80)) next = Level::Throttle;
+                break;
+            case Level::Throttle:
+                if (t >= pct(95))     next = Level::Shed;
+                else if (t < pct(70)) next = Level::Normal;
+                else if (now_ms - since_ms_ >= kEscalateMs) {
+                    // Uso caindo: a pausa est surtindo efeito, nova janela
+                    // a partir desta medida; parado ou subindo: corte
+                    if (t < mark_) { mark_ = t; since_ms_ = now_ms; }
+                    else next = Level::Shed;
+                }
+                break;
+            case Level::Shed:
+                if (t < pct(70))      next = Level::Normal;
+                else if (t < pct(85)) next = Level::Throttle;
+                break;
+        }
+        if (next == level_) return false;
+        level_    = next;
+        since_ms_ = now_ms;
+        mark_     = t;
+        ++transitions_;
+        return true;
+    }
+
+    Level level()    const { return level_; }
+    bool  throttle() const { return level_ != Level::Normal; }
+
+    size_t line_max()  const { return line_max_; }
+    size_t total_max() const { return total_max_; }
+
+    // Sada pendente mxima por cliente no nvel atual (0 = sem limite)
+    size_t out_cap() const {
+        if (level_ != Level::Shed) return client_out_max_;
+        const size_t base = client_out_max_ ? client_out_max_ : total_max_;
+        return std::max(kShedFloor, base / 8);
+    }
+
+    // Teto de bytes do histrico (0 = s o de entradas)
+    size_t history_cap() const { return total_max_ / 4; }
+
+    const Usage& last() const { return last_; }
+    size_t       peak() const { return peak_; }
+
+    // Contadores de corte
+    uint64_t oversized = 0; // linhas longas demais descartadas
+    uint64_t paused    = 0; // esperas de sesses por presso de memria
+    uint64_t slow      = 0; // clientes lentos derrubados
+    uint64_t transitions() const { return transitions_; }
+
+private:
+    size_t   line_max_;
+    size_t   client_out_max_;
+    size_t   total_max_;
+    Level    level_ = Level::Normal;
+    uint64_t since_ms_ = 0; // entrada no nvel atual (ou incio da janela da pausa)
+    size_t   mark_ = 0;     // uso medido em since_ms_
+    Usage    last_;
+    size_t   peak_ = 0;
+    uint64_t transitions_ = 0;
+
+    size_t pct(size_t p) const { return total_max_ / 100 * p; }
+};
+
+// Memria residente do processo (bytes; 0 se /proc no estiver disponvel)
+inline size_t rss_bytes() {
+    FILE* f = std::fopen("/proc/self/statm", "r");
+    if (!f) return 0;
+    unsigned long size = 0, resident = 0;
+    const int n = std::fscanf(f, "%lu %lu", &size, &resident);
+    std::fclose(f);
+    return n == 2 ? resident * static_cast<size_t>(::sysconf(_SC_PAGESIZE)) : 0;
+}
+
+// "1.5 MiB"
+inline std::string human(size_t bytes) {
+    char buf[32];
+    if (bytes < 1024)                   std::snprintf(buf, sizeof(buf), "%zu B", bytes);
+    else if (bytes < (size_t(1) << 20)) std::snprintf(buf, sizeof(buf), "%.1f KiB", bytes / 1024.0);
+    else                                std::snprintf(buf, sizeof(buf), "%.1f MiB", bytes / 1048576.0);
+    return buf;
+}
+
+} // namespace membudget
@@ -0,0 +1,40 @@
+#pragma once
+#include <chrono>
+#include <cstdint>
+#include <string>
+
+#include "common/pool.hpp"
+
+// Faixa de prioridade na fila de broadcast (ver AsyncQueue.hpp): controle
+// passa  frente de tudo; avisos do sistema e chat dividem o resto por peso.
+enum class Lane : uint8_t { Control, System, Chat };
+inline constexpr size_t kLanes = 3;
+
+// O que o broadcaster faz com o item
+enum class Kind : uint8_t {
+    Chat,     // linha de cliente: clientes, peers, anel e histrico
+    Notice,   // aviso do servidor ("* ..."): s clientes locais
+    Kick,     // derruba a sesso target_id (em target_fd) com o aviso em text
+    Shutdown, // aviso de encerramento, depois para o loop
+};
+
+// Mensagem de chat j enquadrada (text termina em '\n').
+struct Message {
+    uint32_t     origin   = 0; // n que recebeu a linha do cliente
+    uint64_t     epoch    = 0; // incio do n de origem (s); muda a cada reincio
+    uint64_t     seq      = 0; // sequncia no n de origem
+    int64_t      ts_us    = 0; // entrada no n de origem (s desde a epoch)
+    pool::Buffer text;
+    uint64_t     trace    = 0; // id de rastreamento (0 = no amostrada); s local
+    uint64_t     hist_seq = 0; // nmero no histrico deste n (retomada); s local
+    int          src_fd   = -1; // sesso que publicou (partilha da fila); s local
+    Kind         kind     = Kind::Chat; // s local
+    Lane         lane     = Lane::Chat; // s local
+    int          target_fd = -1;        // Kick; s local
+    uint64_t     target_id = 0;         // Kick: Connection::id, o fd pode ter outra dona; s local
+};
+
+inline int64_t now_us() {
+    using namespace std::chrono;
+    return duration_cast<microseconds>(system_clock::now().time_since_epoch()).count();
+}
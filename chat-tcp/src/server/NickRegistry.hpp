@@ -0,0 +1,199 @@
+#pragma once
+#include <atomic>
+#include <cstdint>
+#include <cstring>
+#include <memory>
+#include <string>
+#include <string_view>
+#include <vector>
+
+// Registro de apelidos: tabela hash de endereamento aberto (sondagem linear)
+// apelido -> fd, com ndice reverso fd -> (apelido, dono).
+//
+// O dono  a identidade da conexo (Connection::id): o nmero do fd se repete
+// assim que o anterior  fechado, e a sesso antiga s libera o apelido ao
+// terminar. Leituras e remoes no ndice reverso conferem o dono, ento uma
+// conexo nova num fd reaproveitado no herda o apelido da anterior (e a
+// anterior no apaga o da nova).
+//
+// Um nico escritor (a thread do loop) altera a tabela; leitores de outras
+// threads usam lookup(), que no trava: cada alterao fica entre dois
+// incrementos de seq_ (seqlock) e o leitor repete a busca se seq_ mudou.
+// Chaves e valores so palavras atmicas, ento a leitura concorrente nunca
+//  uma corrida de dados. Uma tabela substituda (ao crescer) s  liberada
+// quando no h leitor em curso, para ningum tocar memria devolvida.
+class NickRegistry {
+public:
+    static constexpr size_t kMaxNick = 32;
+
+    NickRegistry() { tables_.push_back(std::make_unique<Table>(64)); table_.store(tables_.back().get()); }
+
+    static bool valid(std::string_view nick) {
+        if (nick.empty() || nick.size() > kMaxNick) return false;
+        for (char ch : nick) {
+            bool ok = (ch >= 'a' && ch <= 'z') || (ch >= 'A' && ch <= 'Z') ||
+                      (ch >= '0' && ch <= '9') || ch == '_' || ch == '-';
+            if (!ok) return false;
+        }
+        return true;
+    }
+
+    // Leitura sem trava (qualquer thread). -1 se no existe.
+    int lookup(std::string_view nick) const {
+        if (!valid(nick)) return -1;
+        const Key k = make_key(nick);
+        readers_.fetch_add(1);
+        for (;;) {
+            const uint64_t s0 = seq_.load(std::memory_order_acquire);
+            if (s0 & 1) continue; // escrita em andamento
+            const int fd = find_fd(*table_.load(), k);
+            std::atomic_thread_fence(std::memory_order_acquire);
+            if (seq_.load(std::memory_order_relaxed) == s0) { readers_.fetch_sub(1); return fd; }
+        }
+    }
+
+    // --------- Escrita (s a thread do loop) ----------
+
+    // Associa `nick`  conexo `owner` no fd (trocando o apelido anterior
+    // dela; o de uma conexo antiga no mesmo fd  descartado).
+    // false se o apelido j pertence a outra sesso.
+    bool set(int fd, uint64_t owner, std::string_view nick) {
+        if (!valid(nick) || fd < 0) return false;
+        const Key k = make_key(nick);
+        const int holder = find_fd(*table_.load(std::memory_order_relaxed), k);
+        if (holder == fd && owner_of(fd) == owner) return true;
+        if (holder >= 0 && holder != fd) return false;
+
+        begin_write();
+        erase_fd(fd);
+        if ((used_ + 1) * 2 > table_.load(std::memory_order_relaxed)->slots.size()) grow();
+        insert(k, fd);
+        if (static_cast<size_t>(fd) >= by_fd_.size()) by_fd_.resize(fd + 1);
+        by_fd_[fd].nick.assign(nick);
+        by_fd_[fd].owner = owner;
+        end_write();
+        return true;
+    }
+
+    // Libera o apelido do fd se ainda  da conexo `owner`.
+    void erase(int fd, uint64_t owner) {
+        if (nick_of(fd, owner).empty()) return;
+        begin_write();
+        erase_fd(fd);
+        end_write();
+    }
+
+    // Apelido da conexo `owner` no fd ("" se no tem).
+    std::string_view nick_of(int fd, uint64_t owner) const {
+        if (owner == 0 || owner_of(fd) != owner) return {};
+        return by_fd_[fd].nick;
+    }
+
+    // Conexo dona do apelido registrado no fd (0 se no h).
+    uint64_t owner_of(int fd) const {
+        if (fd < 0 || static_cast<size_t>(fd) >= by_fd_.size() || by_fd_[fd].nick.empty()) return 0;
+        return by_fd_[fd].owner;
+    }
+
+    size_t size() const { return live_; }
+
+private:
+    static constexpr int32_t kEmpty = -1;
+    static constexpr int32_t kTomb  = -2;
+
+    struct Key { uint64_t w[4]; };
+
+    struct Slot {
+        std::atomic<uint64_t> w[4]{}; // apelido completado com zeros
+        std::atomic<int32_t>  fd{kEmpty};
+    };
+    struct Entry {
+        std::string nick;
+        uint64_t    owner = 0;
+    };
+    struct Table {
+        explicit Table(size_t n) : slots(n) {}
+        std::vector<Slot> slots; // tamanho potncia de 2
+    };
+
+    std::atomic<uint64_t>               seq_{0};
+    std::atomic<Table*>                 table_{nullptr};
+    mutable std::atomic<uint32_t>       readers_{0};
+    std::vector<std::unique_ptr<Table>> tables_;  // atual + antigas
+    std::vector<Entry>                  by_fd_;   // fd -> apelido e dono
+    size_t used_ = 0;                             // vivos + tombstones
+    size_t live_ = 0;
+
+    static Key make_key(std::string_view nick) {
+        Key k{};
+        std::memcpy(k.w, nick.data(), nick.size());
+        return k;
+    }
+    static uint64_t hash(const Key& k) {
+        uint64_t h = 0xcbf29ce484222325ull; // FNV-1a por palavra + mistura final
+        for (uint64_t w : k.w) { h ^= w; h *= 0x100000001b3ull; }
+        h ^= h >> 33; h *= 0xff51afd7ed558ccdull; h ^= h >> 33;
+        return h;
+    }
+    static bool same(const Slot& s, const Key& k) {
+        for (int i = 0; i < 4; ++i)
+            if (s.w[i].load(std::memory_order_relaxed) != k.w[i]) return false;
+        return true;
+    }
+
+    static int find_fd(const Table& t, const Key& k) {
+        const size_t mask = t.slots.size() - 1;
+        for (size_t i = hash(k) & mask, n = 0; n < t.slots.size(); i = (i + 1) & mask, ++n) {
+            const int32_t fd = t.slots[i].fd.load(std::memory_order_relaxed);
+            if (fd == kEmpty) return -1;
+            if (fd >= 0 && same(t.slots[i], k)) return fd;
+        }
+        return -1;
+    }
+
+    void begin_write() { seq_.fetch_add(1, std::memory_order_acq_rel); }
+    void end_write()   { seq_.fetch_add(1, std::memory_order_release); }
+
+    void insert(const Key& k, int fd) {
+        Table& t = *table_.load(std::memory_order_relaxed);
+        const size_t mask = t.slots.size() - 1;
+        size_t i = hash(k) & mask;
+        while (t.slots[i].fd.load(std::memory_order_relaxed) >= 0) i = (i + 1) & mask;
+        if (t.slots[i].fd.load(std::memory_order_relaxed) == kEmpty) ++used_;
+        for (int j = 0; j < 4; ++j) t.slots[i].w[j].store(k.w[j], std::memory_order_relaxed);
+        t.slots[i].fd.store(fd, std::memory_order_relaxed);
+        ++live_;
+    }
+
+    void erase_fd(int fd) {
+        if (owner_of(fd) == 0) return;
+        Table& t = *table_.load(std::memory_order_relaxed);
+        const Key k = make_key(by_fd_[fd].nick);
+        const size_t mask = t.slots.size() - 1;
+        for (size_t i = hash(k) & mask;; i = (i + 1) & mask) {
+            const int32_t f = t.slots[i].fd.load(std::memory_order_relaxed);
+            if (f == kEmpty) break;
+            if (f == fd && same(t.slots[i], k)) { t.slots[i].fd.store(kTomb, std::memory_order_relaxed); --live_; break; }
+        }
+        by_fd_[fd] = Entry{};
+    }
+
+    // Dobra a tabela (ou s limpa tombstones) e migra os vivos.
+    void grow() {
+        Table& old = *table_.load(std::memory_order_relaxed);
+        const size_t n = (live_ + 1) * 4 > old.slots.size() ? old.slots.size() * 2 : old.slots.size();
+        tables_.push_back(std::make_unique<Table>(n));
+        table_.store(tables_.back().get());
+        used_ = 0;
+        live_ = 0;
+        for (auto& s : old.slots) {
+            const int32_t fd = s.fd.load(std::memory_order_relaxed);
+            if (fd < 0) continue;
+            Key k;
+            for (int j = 0; j < 4; ++j) k.w[j] = s.w[j].load(std::memory_order_relaxed);
+            insert(k, fd);
+        }
+        // Leitor que entrar depois j v a tabela nova
+        if (readers_.load() == 0) tables_.erase(tables_.begin(), tables_.end() - 1);
+    }
+};
@@ -0,0 +1,77 @@
+#pragma once
+#include <algorithm>
+#include <cstdint>
+#include <vector>
+
+// Controle de ingesto por sesso, aplicado logo depois do enquadramento
+// (antes de a linha entrar na fila de broadcast).
+//
+//  - TokenBucket: cada sesso ganha `rate` linhas/s e acumula at `burst`.
+//    Sem ficha, a sesso para de ler at a prxima chegar; o socket enche
+//    e o TCP segura o cliente, sem afetar os outros.
+//  - FairShare: com a fila acima da metade, cada remetente pode ter no
+//    mximo capacidade / remetentes ativos mensagens nela; o excedente 
+//    descartado. Um nico fd no consegue ocupar a fila inteira.
+namespace ratelimit {
+
+class TokenBucket {
+public:
+    TokenBucket(double rate, double burst, uint64_t now_ms)
+      : rate_(rate / 1000.0), burst_(std::max(burst, 1.0)), tokens_(burst_), last_(now_ms) {}
+
+    // Consome uma ficha: 0 se havia, seno os ms at a prxima (sem consumir).
+    [[nodiscard]] uint64_t take(uint64_t now_ms) {
+        tokens_ = std::min(burst_, tokens_ + static_cast<double>(now_ms - last_) * rate_);
+        last_   = now_ms;
+        if (tokens_ >= 1.0) { tokens_ -= 1.0; return 0; }
+        return static_cast<uint64_t>((1.0 - tokens_) / rate_) + 1;
+    }
+
+private:
+    double   rate_;   // fichas por ms
+    double   burst_;
+    double   tokens_;
+    uint64_t last_;
+};
+
+class FairShare {
+public:
+    static constexpr size_t kMinShare = 8; // cota mnima, mesmo com muitos remetentes
+
+    explicit FairShare(size_t capacity) : capacity_(capacity) {}
+
+    // A linha de `fd` pode entrar na fila (com `queued` itens agora)?
+    bool admit(int fd, size_t queued) const {
+        if (queued < capacity_ / 2) return true;
+        const uint32_t mine   = inflight(fd);
+        const size_t   others = active_ - (mine > 0 ? 1 : 0);
+        return mine < std::max(kMinShare, capacity_ / (others + 1));
+    }
+
+    // Contabilidade: enfileirada por `fd` / retirada pelo broadcaster.
+    void acquire(int fd) {
+        if (fd < 0) return;
+        if (static_cast<size_t>(fd) >= inflight_.size()) inflight_.resize(fd + 1, 0);
+        if (inflight_[fd]++ == 0) ++active_;
+    }
+    void release(int fd) {
+        if (fd < 0 || static_cast<size_t>(fd) >= inflight_.size() || inflight_[fd] == 0) return;
+        if (--inflight_[fd] == 0) --active_;
+    }
+
+    // Acompanha a capacidade da fila quando ela muda em execuo.
+    void resize(size_t capacity) { capacity_ = capacity; }
+
+    size_t active() const { return active_; }
+
+private:
+    size_t                capacity_;
+    size_t                active_ = 0;  // fds com mensagens na fila
+    std::vector<uint32_t> inflight_;    // fd -> mensagens na fila
+
+    uint32_t inflight(int fd) const {
+        return (fd >= 0 && static_cast<size_t>(fd) < inflight_.size()) ? inflight_[fd] : 0;
+    }
+};
+
+} // namespace ratelimit
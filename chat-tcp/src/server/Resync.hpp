@@ -0,0 +1,60 @@
+#pragma once
+#include <charconv>
+#include <cstdint>
+#include <string>
+#include <string_view>
+
+#include "server/Message.hpp"
+
+// Retomada incremental do histrico.
+//
+// Cada entrada do histrico deste n recebe um nmero monotnico (hist_seq).
+// Um cliente que quer retomar manda como primeira linha
+//     /since <poca> <ltimo hist_seq visto>
+// e recebe um cabealho seguido das linhas numeradas:
+//     * sync <poca> <ltimo>   -> s as entradas que faltavam
+//     * gap <poca> <ltimo>    -> lacuna grande demais (ou outra poca):
+//                                  o histrico inteiro
+// Dali em diante as mensagens chegam como "#<hist_seq> <texto>".
+// A poca muda a cada incio do servidor; nmeros de outra poca no valem.
+//
+// Os nmeros seguem a ordem de chegada a este n. Uma entrada mesclada do
+// histrico de um peer entra na posio do seu instante, mas com o prximo
+// nmero, e  enviada na hora s sesses numeradas. O replay sai na ordem
+// do histrico, ento os nmeros podem vir fora de ordem: o cliente retoma
+// a partir do maior que viu (no do ltimo), sem perder nem repetir linhas.
+namespace resync {
+
+inline constexpr uint32_t kSeqTags = 1u << 0; // Connection::features
+
+// "/since <poca> <seq>" -> true e os valores.
+inline bool parse_since(std::string_view line, uint64_t& epoch, uint64_t& since) {
+    if (!line.starts_with("/since ")) return false;
+    const char* p   = line.data() + 7;
+    const char* end = line.data() + line.size();
+    auto r1 = std::from_chars(p, end, epoch);
+    if (r1.ec != std::errc{} || r1.ptr == end || *r1.ptr != ' ') return false;
+    auto r2 = std::from_chars(r1.ptr + 1, end, since);
+    return r2.ec == std::errc{} && r2.ptr == end;
+}
+
+// Acrescenta "#<hist_seq> <texto>" (o texto j termina em '\n').
+template<typename Str>
+inline void append_tagged(Str& out, const Message& m) {
+    char num[24];
+    auto r = std::to_chars(num, num + sizeof(num), m.hist_seq);
+    out.push_back('#');
+    out.append(num, static_cast<size_t>(r.ptr - num));
+    out.push_back(' ');
+    out.append(m.text.data(), m.text.size());
+}
+
+inline void append_header(std::string& out, bool gap, uint64_t epoch, uint64_t last) {
+    out += gap ? "* gap " : "* sync ";
+    out += std::to_string(epoch);
+    out += ' ';
+    out += std::to_string(last);
+    out += '\n';
+}
+
+} // namespace resync
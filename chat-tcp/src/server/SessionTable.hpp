@@ -0,0 +1,134 @@
+#pragma once
+#include <array>
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+#include "common/event_loop.hpp"
+#include "common/rcu.hpp"
+
+// Sesses ativas com ndice por fd: insero, busca e remoo O(1)
+// (remoo troca com o ltimo) no lado do escritor, a thread do EventLoop.
+//
+// Leitores (broadcast, /who) percorrem uma verso imutvel, sem trava:
+// view() devolve um guard RCU sobre a verso publicada. Cada entrada ou
+// sada publica a verso nova na hora, ento a leitura nunca monta nada.
+// As sesses ficam em blocos de kChunk compartilhados entre verses: uma
+// alterao copia s o bloco que mudou (copy-on-write) e a lista de
+// ponteiros para os blocos, N / kChunk, em vez do conjunto inteiro.
+class SessionTable {
+public:
+    using Ptr = std::shared_ptr<Connection>;
+    static constexpr size_t kChunk = 64;
+
+private:
+    struct Chunk {
+        std::array<Ptr, kChunk> at;
+    };
+
+public:
+    // Verso imutvel: percorrida com for (const auto& c : *view).
+    class View {
+    public:
+        class iterator {
+        public:
+            iterator(const View* v, size_t i) : v_(v), i_(i) {}
+            const Ptr& operator*() const { return v_->chunks_[i_ / kChunk]->at[i_ % kChunk]; }
+            iterator& operator++() { ++i_; return *this; }
+            bool operator!=(const iterator& o) const { return i_ != o.i_; }
+
+        private:
+            const View* v_;
+            size_t      i_;
+        };
+
+        iterator begin() const { return {this, 0}; }
+        iterator end()   const { return {this, size_}; }
+        size_t size() const { return size_; }
+
+    private:
+        friend class SessionTable;
+        std::vector<std::shared_ptr<const Chunk>> chunks_;
+        size_t                                    size_ = 0;
+    };
+
+    void add(Ptr c) {
+        const int fd = c->fd;
+        if (static_cast<size_t>(fd) >= pos_.size()) pos_.resize(fd + 1, -1);
+        // fd reaproveitado: a entrada antiga j foi fechada e sai agora
+        if (pos_[fd] >= 0) remove_at(static_cast<size_t>(pos_[fd]));
+        if (size_ % kChunk == 0) chunks_.push_back(std::make_shared<Chunk>());
+        pos_[fd] = static_cast<int32_t>(size_);
+        slot(size_++) = std::move(c);
+        publish();
+    }
+
+    Ptr find(int fd) const {
+        if (fd < 0 || static_cast<size_t>(fd) >= pos_.size() || pos_[fd] < 0) return nullptr;
+        return get(static_cast<size_t>(pos_[fd]));
+    }
+
+    // Remove pela identidade: o fd pode j ter sido reaproveitado.
+    void remove(const Ptr& c) {
+        const int fd = c->fd;
+        if (fd < 0 || static_cast<size_t>(fd) >= pos_.size() || pos_[fd] < 0) return;
+        const size_t i = static_cast<size_t>(pos_[fd]);
+        if (get(i) != c) return;
+        remove_at(i);
+        publish();
+    }
+
+    // Verso imutvel atual. S a thread do EventLoop chama: aproveita para
+    // soltar verses antigas que um leitor segurava na ltima publicao
+    // (elas seguram conexes j fechadas).
+    rcu::Cell<View>::Guard view() {
+        if (cell_.retired()) cell_.collect();
+        return cell_.read();
+    }
+
+    size_t size() const { return size_; }
+
+    void clear() {
+        for (size_t i = 0; i < size_; ++i) pos_[get(i)->fd] = -1;
+        chunks_.clear();
+        size_ = 0;
+        publish();
+    }
+
+private:
+    std::vector<std::shared_ptr<Chunk>> chunks_;
+    size_t                              size_ = 0;
+    std::vector<int32_t>                pos_; // fd -> posio (-1 = livre)
+    rcu::Cell<View>                     cell_;
+
+    const Ptr& get(size_t i) const { return chunks_[i / kChunk]->at[i % kChunk]; }
+
+    // Posio para escrita: o bloco ainda visto por uma verso publicada 
+    // copiado antes (s o escritor cria e solta verses, ento use_count 
+    // estvel aqui).
+    Ptr& slot(size_t i) {
+        auto& ch = chunks_[i / kChunk];
+        if (ch.use_count() > 1) ch = std::make_shared<Chunk>(*ch);
+        return ch->at[i % kChunk];
+    }
+
+    // Remove a i-sima sesso; a ltima passa a ocupar a posio i.
+    void remove_at(size_t i) {
+        const size_t last = size_ - 1;
+        pos_[get(i)->fd] = -1;
+        if (i != last) {
+            Ptr moved = get(last);
+            pos_[moved->fd] = static_cast<int32_t>(i);
+            slot(i) = std::move(moved);
+        }
+        slot(last).reset();
+        if (--size_ % kChunk == 0) chunks_.pop_back();
+    }
+
+    void publish() {
+        auto* v = new View;
+        v->chunks_.assign(chunks_.begin(), chunks_.end());
+        v->size_ = size_;
+        cell_.publish(v);
+    }
+};
@@ -1,190 +1,1525 @@
 #include <vector>
-#include <thread>
-#include <mutex>
+#include <memory>
 #include <atomic>
 #include <string>
+#include <unordered_map>
+#include <algorithm>
+#include <charconv>
+#include <chrono>
+#include <cstdlib>
 #include <csignal>
+#include <cstring>
 #include <iostream>
+#include <fcntl.h>
 #include <unistd.h>
+#include <sys/signalfd.h>
 #include <cerrno>
+#include <chatring.hpp>
 
 #include "common/net.hpp"
 #include "common/logging.hpp"
-#include "server/ThreadSafeQueue.hpp"
-
-struct Client { int fd; };
-
-// --------- Controle de execuo (SIGINT) ----------
-static std::atomic_bool running{true};
-static void sigint_handler(int) { running.store(false); }
+#include "common/capture.hpp"
+#include "common/compression.hpp"
+#include "common/coro.hpp"
+#include "common/event_loop.hpp"
+#include "common/placement.hpp"
+#include "common/pool.hpp"
+#include "common/splice.hpp"
+#include "common/trace.hpp"
+#include "common/zerocopy.hpp"
+#include "server/AsyncQueue.hpp"
+#include "server/Attachments.hpp"
+#include "server/Config.hpp"
+#include "server/Fanout.hpp"
+#include "server/Federation.hpp"
+#include "server/Filter.hpp"
+#include "server/MemBudget.hpp"
+#include "server/Message.hpp"
+#include "server/NickRegistry.hpp"
+#include "server/RateLimit.hpp"
+#include "server/Resync.hpp"
+#include "server/SessionTable.hpp"
 
 // Remove '\r' do fim da linha
 static void trim_cr(std::string& s) {
     while (!s.empty() && s.back() == '\r') s.pop_back();
 }
 
-int main(int argc, char** argv) {
-    std::signal(SIGINT, sigint_handler);
+// --------- Estado do servidor ----------
+// Todas as corrotinas rodam na thread do EventLoop, ento nada aqui precisa
+// de mutex: a excluso mtua vem de s existir um fluxo de execuo.
+struct Server {
+    ServerConfig cfg;
+    EventLoop    loop;
 
-    // Uso: ./chat_server [porta]
-    if (argc > 2) {
-        std::cerr << "Uso: " << argv[0] << " [porta]\nEx.: " << argv[0] << " 5555\n";
-        return 2;
+    // Fila bounded para mensagens a serem broadcastadas, em faixas: controle
+    // (estrita), avisos do servidor e chat (--queue*, --system-weight, admin)
+    AsyncQueue queue{loop, {cfg.queue_control, cfg.queue_system, cfg.queue_cap}, {0, cfg.system_weight, 1}};
+
+    // Ingesto: partilha justa da faixa de chat entre remetentes e contadores
+    // de linhas atrasadas (limite de taxa) e descartadas (acima da partilha)
+    ratelimit::FairShare share{queue.capacity(Lane::Chat)};
+    uint64_t throttled = 0;
+    uint64_t dropped   = 0;
+
+    // Sesses ativas, indexadas por fd
+    SessionTable clients;
+
+    // Fanout paralelo (--fanout-workers): com ele, s os workers escrevem
+    // nos sockets de clientes (ver Fanout.hpp)
+    std::unique_ptr<FanoutPool> fanout;
+
+    // Anel em memria compartilhada para consumidores locais (--shm)
+    chatring::Publisher ring;
+
+    // Apelidos (/nick) para mensagens diretas
+    NickRegistry nicks;
+
+    // Filtro entre o enquadramento e a fila (--filter); recarga por SIGHUP
+    // ou pelo admin, sem pausa (ver Filter.hpp)
+    filter::Pipeline   pipeline;
+    filter::TermFilter terms;
+    bool               terms_on = false; // etapa de termos j no pipeline
+    uint64_t           masked   = 0;
+    uint64_t           blocked  = 0;
+
+    // Captura de entrada (--capture): sesses numeradas, fds se repetem.
+    // O nmero tambm  a identidade da conexo (Connection::id)
+    capture::Writer capture;
+    uint64_t        sessions = 0;
+
+    // Histrico simples (ordenado pelo instante de entrada na origem).
+    // A capacidade  reservada de antemo: entrar no histrico s move buffers.
+    std::vector<Message> history;
+    size_t history_max   = cfg.history_max; // --history, admin
+    size_t history_bytes = 0;               // capacidade dos textos guardados
+
+    // Oramento de memria (--line-max, --client-out-max, --mem-budget);
+    // o governador s roda enquanto h clientes
+    membudget::Budget mem{cfg.line_max, cfg.client_out_max, cfg.mem_budget};
+    bool              mem_watch = false;
+
+    // Anexos (/file, /get): spool de arquivos sem nome e envios em curso
+    attach::Spool spool{cfg.spool_dir, cfg.attach_max * 4};
+    size_t        streams = 0;
+
+    explicit Server(const ServerConfig& c) : cfg(c) { history.reserve(history_max + 1); }
+
+    // Histrico inteiro j concatenado, compartilhado pelos replays at a
+    // prxima mudana (nulo = desatualizado). Imutvel: pode ir por zerocopy.
+    std::shared_ptr<const std::string> snapshot;
+
+    // Compresso por sesso ("/compress deflate", ver compression.hpp): o
+    // contexto de cada conexo e o snapshot acima comprimido uma vez
+    std::unordered_map<const Connection*, std::unique_ptr<compression::Deflater>> deflaters;
+    std::shared_ptr<const std::string> packed;
+    std::string zbuf; // sada comprimida, reaproveitada a cada envio
+
+    // Retomada incremental (ver Resync.hpp); a epoch tambm distingue os
+    // reincios deste n nos ids de federao (ver Federation.hpp)
+    const uint64_t epoch = static_cast<uint64_t>(now_us());
+    uint64_t hist_seq    = 0; // ltimo nmero dado a uma entrada do histrico
+    uint64_t evicted_seq = 0; // maior nmero j descartado do histrico
+    size_t   seq_clients = 0; // sesses que recebem linhas numeradas
+
+    // Federao
+    uint64_t next_seq = 0;
+    std::vector<std::shared_ptr<PeerLink>> peers;
+    DedupCache   seen;
+    LatencyStats peer_latency;
+};
+
+// --------- Federao: envio em lote para os peers ----------
+// Os frames acumulam em link->batch e saem num nico envio quando o loop
+// termina a rodada atual de corrotinas prontas.
+static Task<> flush_peer(Server& srv, std::shared_ptr<PeerLink> link) {
+    co_await srv.loop.next_tick();
+    link->flush_pending = false;
+    if (link->batch.empty()) co_return;
+    ++link->sends;
+    // send_nowait copia o que o socket no aceitar; batch mantm a capacidade
+    if (!send_nowait(srv.loop, link->conn, link->batch)) close_connection(srv.loop, *link->conn);
+    link->batch.clear();
+}
+
+static void schedule_flush(Server& srv, const std::shared_ptr<PeerLink>& link) {
+    if (!link->flush_pending) {
+        link->flush_pending = true;
+        spawn(flush_peer(srv, link));
     }
-    uint16_t port = (argc > 1) ? static_cast<uint16_t>(std::stoi(argv[1])) : 5555;
+}
 
-    int listen_fd = make_server_socket(port);
-    if (listen_fd < 0) {
-        std::cerr << "Erro ao abrir porta " << port << "\n";
-        return 1;
+static void queue_frame(Server& srv, const std::shared_ptr<PeerLink>& link, char kind, const Message& m) {
+    append_frame(link->batch, kind, m);
+    ++link->frames;
+    schedule_flush(srv, link);
+}
+
+static void report_peer_latency(Server& srv) {
+    if (srv.peer_latency.count() == 0) return;
+    log::L().info("Federao: latncia entre ns {}", srv.peer_latency.take_summary());
+}
+
+// --------- Sada para clientes: direta ou pelo worker dono do fd ----------
+// Sesso com compresso: os bytes passam pelo contexto dela antes do envio.
+static bool send_packed(Server& srv, const std::shared_ptr<Connection>& c, std::string_view bytes) {
+    if (c->closed) return false;
+    auto it = srv.deflaters.find(c.get());
+    srv.zbuf.clear();
+    if (it == srv.deflaters.end() || !it->second->compress(bytes, srv.zbuf)) return false;
+    return send_nowait(srv.loop, c, srv.zbuf);
+}
+
+static bool send_to(Server& srv, const std::shared_ptr<Connection>& c, std::string_view bytes) {
+    if (c->features & compression::kDeflate) return send_packed(srv, c, bytes);
+    if (!srv.fanout) return send_nowait(srv.loop, c, bytes);
+    if (c->closed) return false;
+    srv.fanout->unicast(c->fd, std::make_shared<const std::string>(bytes));
+    return true;
+}
+
+// Fecha a conexo de um cliente. Com fanout, o worker fecha o fd depois de
+// tir-lo da partio (nada sai para um fd j reaproveitado).
+static void drop(Server& srv, Connection& c) {
+    if (!srv.fanout) { close_connection(srv.loop, c); return; }
+    if (c.closed) return;
+    c.closed = true;
+    srv.loop.forget(c.fd);
+    srv.fanout->close(c.fd);
+}
+
+// Descarta as entradas mais antigas alm do limite de entradas ou de bytes
+// (parte do oramento de memria).
+static void trim_history(Server& srv) {
+    auto& h = srv.history;
+    srv.snapshot.reset();
+    srv.packed.reset();
+    const size_t byte_cap = srv.mem.history_cap();
+    auto cut = h.begin();
+    size_t keep = h.size();
+    while (keep > srv.history_max || (byte_cap && srv.history_bytes > byte_cap && keep > 0)) {
+        srv.evicted_seq = std::max(srv.evicted_seq, cut->hist_seq);
+        srv.history_bytes -= cut->text.capacity();
+        ++cut;
+        --keep;
     }
-    log::L().info("Servidor ouvindo na porta {}", port);
-    std::cout << "Servidor rodando (Ctrl+C para encerrar)\n";
+    h.erase(h.begin(), cut);
+}
+
+// --------- Oramento de memria ----------
+// Derruba um consumidor lento e devolve j a sada pendente dele.
+static void drop_slow(Server& srv, const std::shared_ptr<Connection>& c) {
+    log::L().warn("Removendo cliente lento fd={} ({} pendentes)", c->fd, membudget::human(c->out.size()));
+    ++srv.mem.slow;
+    close_connection(srv.loop, *c);
+    c->out.clear();
+    c->out.shrink_to_fit();
+    srv.clients.remove(c);
+}
+
+// Uso atual por categoria. Com fanout, a sada pendente fica nos workers.
+static membudget::Usage memory_usage(Server& srv) {
+    membudget::Usage u;
+    auto clients = srv.clients.view();
+    for (const auto& c : *clients) {
+        u.input += c->in.capacity();
+        if (!srv.fanout) u.output += c->out.capacity();
+    }
+    if (srv.fanout) u.output = srv.fanout->stats().pending;
+    u.queue   = srv.queue.bytes();
+    u.history = srv.history_bytes + (srv.snapshot ? srv.snapshot->capacity() : 0) +
+                (srv.packed ? srv.packed->capacity() : 0);
+    u.codec   = srv.deflaters.size() * compression::kStateBytes;
+    return u;
+}
+
+// "total 12.0 MiB/256.0 MiB (normal): entrada ..., fila ..., ..."
+static std::string describe_memory(const Server& srv) {
+    const auto& u = srv.mem.last();
+    return "total " + membudget::human(u.total()) + "/" +
+           (srv.mem.total_max() ? membudget::human(srv.mem.total_max()) : std::string("sem limite")) + " (" +
+           membudget::level_name(srv.mem.level()) + "): entrada " + membudget::human(u.input) + ", fila " +
+           membudget::human(u.queue) + ", sada " + membudget::human(u.output) + ", histrico " +
+           membudget::human(u.history) + ", compresso " + membudget::human(u.codec) + "; pico " +
+           membudget::human(srv.mem.peak()) + ", rss " + membudget::human(membudget::rss_bytes()) + "; " +
+           std::to_string(srv.mem.oversized) +
+           " linhas longas descartadas, " + std::to_string(srv.mem.paused) + " pausas de leitura, " +
+           std::to_string(srv.mem.slow + (srv.fanout ? srv.fanout->stats().slow : 0)) +
+           " clientes lentos derrubados";
+}
+
+// Mede o uso, muda o nvel e aplica o corte do nvel.
+static void govern_memory(Server& srv) {
+    if (srv.mem.assess(memory_usage(srv), EventLoop::clock_ms())) {
+        log::L().warn("Memria: nvel {} ({})", membudget::level_name(srv.mem.level()), describe_memory(srv));
+        if (srv.fanout) srv.fanout->set_out_cap(srv.mem.out_cap()); // os workers cortam no prximo envio
+    }
+    if (srv.fanout || srv.mem.level() != membudget::Level::Shed) return;
+    const size_t cap = srv.mem.out_cap();
+    auto clients = srv.clients.view();
+    for (const auto& c : *clients)
+        if (!c->closed && c->out.size() > cap) drop_slow(srv, c);
+}
+
+// Governador: mede a cada kMemTick enquanto houver clientes (ocioso, no
+// acorda o loop). As sesses o iniciam ao entrar.
+static constexpr auto kMemTick = std::chrono::milliseconds(50);
+
+static Task<> memory_governor(Server& srv) {
+    srv.mem_watch = true;
+    while (srv.clients.size() > 0 && !srv.loop.stopping()) {
+        govern_memory(srv);
+        co_await srv.loop.sleep_for(kMemTick);
+    }
+    govern_memory(srv);
+    srv.mem_watch = false;
+}
+
+// Entrega uma mensagem: clientes locais, peers (exceto `from` e o prprio
+// n de origem) e, por fim, o histrico, que assume o buffer.
+static void deliver(Server& srv, Message&& msg, const PeerLink* from) {
+    // Envia a TODOS os clientes conectados. send_nowait no suspende:
+    // o que um cliente lento no absorver fica no buffer de sada dele.
+    msg.hist_seq = ++srv.hist_seq;
+
+    // Verso numerada, montada uma vez, para as sesses que a pediram
+    pool::Buffer tagged;
+    if (srv.seq_clients > 0) {
+        tagged.reserve(msg.text.size() + 22);
+        resync::append_tagged(tagged, msg);
+    }
+
+    bool sent = false;
+    if (srv.fanout) {
+        // Publicada uma vez; cada worker envia para a sua partio
+        auto plain = std::make_shared<const std::string>(msg.text.data(), msg.text.size());
+        std::shared_ptr<const std::string> numbered;
+        if (srv.seq_clients > 0) numbered = std::make_shared<const std::string>(tagged.data(), tagged.size());
+        srv.fanout->broadcast(plain, numbered);
+        sent = srv.clients.size() > 0;
+        if (sent) trace::mark(msg.trace, trace::Stage::FirstSend); // entregue aos workers
+    }
+
+    // Payload grande com --zerocopy: uma cpia compartilhada e imutvel, que
+    // o kernel l at concluir cada envio (msg.text segue para o histrico)
+    std::shared_ptr<const std::string> zc_plain, zc_tagged;
+    if (!srv.fanout && srv.cfg.zerocopy_min && msg.text.size() >= srv.cfg.zerocopy_min) {
+        zc_plain = std::make_shared<const std::string>(msg.text.data(), msg.text.size());
+        if (srv.seq_clients > 0) zc_tagged = std::make_shared<const std::string>(tagged.data(), tagged.size());
+    }
+
+    // Verso imutvel do conjunto: quem sai durante o lao no o perturba
+    auto clients = srv.clients.view();
+    for (const auto& c : *clients) {
+        if (srv.fanout) break;
+        if (c->closed) continue;
+        const bool tags = c->features & resync::kSeqTags;
+        const bool ok = (c->features & compression::kDeflate) ? send_packed(srv, c, tags ? tagged : msg.text)
+                      : zc_plain ? zerocopy::send_nowait(srv.loop, c, tags ? zc_tagged : zc_plain)
+                                 : send_nowait(srv.loop, c, tags ? tagged : msg.text);
+        if (!ok) {
+            log::L().warn("Removendo cliente fd={} (send falhou)", c->fd);
+            close_connection(srv.loop, *c);
+            srv.clients.remove(c);
+            continue;
+        }
+        if (const size_t cap = srv.mem.out_cap(); cap && c->out.size() > cap) {
+            drop_slow(srv, c); // a sada de um consumidor lento no cresce sem limite
+            continue;
+        }
+        if (!sent) {
+            trace::mark(msg.trace, trace::Stage::FirstSend);
+            sent = true;
+        }
+    }
+    if (sent && !srv.fanout) trace::mark(msg.trace, trace::Stage::LastSend);
+
+    // Consumidores locais: uma cpia no anel, qualquer que seja o nmero deles
+    if (srv.ring.ok()) srv.ring.publish(std::string_view(msg.text.data(), msg.text.size()), msg.hist_seq);
+
+    for (auto& link : srv.peers) {
+        if (link.get() == from || link->node == msg.origin || link->conn->closed) continue;
+        queue_frame(srv, link, 'M', msg);
+    }
+
+    // Grava no histrico
+    const uint64_t trace_id = msg.trace;
+    srv.history_bytes += msg.text.capacity();
+    srv.history.push_back(std::move(msg));
+    trim_history(srv);
+    trace::mark(trace_id, trace::Stage::History);
+}
+
+// Insere uma entrada vinda do histrico de um peer, na ordem temporal.
+// O nmero dela  o prximo deste n (ordem de chegada, no de tempo), ento
+// as sesses numeradas a recebem j: sem isso, o ltimo nmero que viram
+// passaria do dela e um "/since" posterior a pularia. As demais s a veem
+// no prximo histrico completo.
+static void merge_history(Server& srv, Message msg) {
+    auto& h = srv.history;
+    auto pos = std::upper_bound(h.begin(), h.end(), msg.ts_us,
+                                [](int64_t ts, const Message& m) { return ts < m.ts_us; });
+    msg.hist_seq = ++srv.hist_seq;
+    if (srv.seq_clients > 0) {
+        pool::Buffer tagged;
+        tagged.reserve(msg.text.size() + 22);
+        resync::append_tagged(tagged, msg);
+        if (srv.fanout) {
+            srv.fanout->broadcast(nullptr, std::make_shared<const std::string>(tagged.data(), tagged.size()));
+        } else {
+            auto clients = srv.clients.view();
+            for (const auto& c : *clients) {
+                if (!c->closed && (c->features & resync::kSeqTags)) send_to(srv, c, tagged);
+            }
+        }
+    }
+    srv.history_bytes += msg.text.capacity();
+    h.insert(pos, std::move(msg));
+    trim_history(srv);
+}
+
+// Histrico inteiro para quem entra sem "/since": montado uma vez por verso.
+static std::shared_ptr<const std::string> history_snapshot(Server& srv) {
+    if (!srv.snapshot) {
+        auto s = std::make_shared<std::string>();
+        for (auto& m : srv.history) s->append(m.text.data(), m.text.size());
+        srv.snapshot = std::move(s);
+    }
+    return srv.snapshot;
+}
+
+// O mesmo snapshot comprimido, para quem entra com compresso: uma vez por
+// verso, qualquer que seja o nmero de sesses que o recebem.
+static std::shared_ptr<const std::string> packed_snapshot(Server& srv) {
+    if (!srv.packed) {
+        const auto snap = history_snapshot(srv);
+        srv.packed = std::make_shared<const std::string>(compression::pack(*snap, compression::kPackLevel));
+    }
+    return srv.packed;
+}
+
+// --------- Avisos e controle ----------
+// Linha "* texto" gerada pelo servidor, para a faixa indicada.
+static Message server_notice(Kind kind, Lane lane, std::string_view text) {
+    Message m;
+    m.kind = kind;
+    m.lane = lane;
+    m.text.reserve(text.size() + 3);
+    m.text.append("* ").append(text).push_back('\n');
+    return m;
+}
+
+// Itens que no so chat: s clientes locais, fora do histrico, do anel e
+// da federao (avisos no so retomados por "/since").
+static void handle_control(Server& srv, Message&& msg) {
+    const std::string_view text(msg.text.data(), msg.text.size());
+    switch (msg.kind) {
+    case Kind::Kick:
+        // S a sesso escolhida: o fd pode j ser de outra conexo
+        if (auto c = srv.clients.find(msg.target_fd); c && c->id == msg.target_id && !c->closed) {
+            send_to(srv, c, text);
+            drop(srv, *c); // a sesso percebe o fechamento e sai da tabela
+        }
+        break;
+    case Kind::Notice:
+    case Kind::Shutdown:
+        if (srv.fanout) {
+            srv.fanout->broadcast(std::make_shared<const std::string>(text), nullptr);
+        } else {
+            auto clients = srv.clients.view();
+            for (const auto& c : *clients)
+                if (!c->closed) send_to(srv, c, text);
+        }
+        if (msg.kind == Kind::Shutdown) srv.loop.request_stop();
+        break;
+    case Kind::Chat:
+        break;
+    }
+}
+
+static const char* lane_name(Lane l) {
+    switch (l) {
+        case Lane::Control: return "controle";
+        case Lane::System:  return "sistema";
+        default:            return "chat";
+    }
+}
+
+static bool parse_lane(std::string_view w, Lane& out) {
+    for (Lane l : {Lane::Control, Lane::System, Lane::Chat}) {
+        if (w == lane_name(l)) { out = l; return true; }
+    }
+    return false;
+}
+
+// "controle 0/64 estrita, 3 entradas, 0 esperas, espera mdia 12 s, mx 40 s"
+static std::string describe_lane(const Server& srv, Lane l) {
+    const auto& st = srv.queue.stats(l);
+    const uint32_t w = srv.queue.weight(l);
+    return std::string(lane_name(l)) + " " + std::to_string(srv.queue.size(l)) + "/" +
+           std::to_string(srv.queue.capacity(l)) + (w ? " peso " + std::to_string(w) : std::string(" estrita")) +
+           ", " + std::to_string(st.popped) + " entregues, " + std::to_string(st.blocked) + " esperas, espera mdia " +
+           std::to_string(st.popped ? st.wait_sum_us / st.popped : 0) + " s, mx " + std::to_string(st.wait_max_us) +
+           " s";
+}
+
+// --------- Corrotina: Broadcaster ----------
+static Task<> broadcaster(Server& srv) {
+    while (auto msg_opt = co_await srv.queue.pop()) {
+        Message msg = std::move(*msg_opt);
+        if (msg.kind != Kind::Chat) { handle_control(srv, std::move(msg)); continue; }
+        trace::mark(msg.trace, trace::Stage::Dequeue);
+        srv.share.release(msg.src_fd);
+        msg.origin = srv.cfg.node_id;
+        msg.epoch  = srv.epoch;
+        msg.seq    = ++srv.next_seq;
+        msg.ts_us  = now_us();
+        srv.seen.insert(msg.origin, msg.epoch, msg.seq);
+
+        // Log de amostra (primeiros 80 chars)
+        if (!msg.text.empty()) {
+            log::L().debug("Broadcast: {}", std::string_view(msg.text).substr(0, 80));
+        }
+        deliver(srv, std::move(msg), nullptr);
+    }
+    log::L().info("Broadcaster finalizado");
+}
+
+// --------- Corrotina por enlace de federao ----------
+static Task<> peer_link(Server& srv, int fd, std::string name) {
+    auto link  = std::allocate_shared<PeerLink>(pool::Allocator<PeerLink>{});
+    link->conn = std::allocate_shared<Connection>(pool::Allocator<Connection>{});
+    link->conn->fd = fd;
+    link->name = std::move(name);
+
+    // HELLO + nosso histrico; o peer mescla o que ainda no viu
+    link->batch = "HELLO " + std::to_string(srv.cfg.node_id) + "\n";
+    for (auto& m : srv.history) queue_frame(srv, link, 'H', m);
+    schedule_flush(srv, link);
+    srv.peers.push_back(link);
+
+    // (co_await fora de expresses com curto-circuito: ver flush_owned)
+    std::string hello;
+    const bool greeted = co_await async_read_line(srv.loop, *link->conn, hello);
+    if (greeted && hello.starts_with("HELLO ")) {
+        link->node = static_cast<uint32_t>(std::strtoul(hello.c_str() + 6, nullptr, 10));
+    }
+    if (link->node == 0 || link->node == srv.cfg.node_id) {
+        log::L().warn("Peer {}: handshake invlido", link->name);
+    } else {
+        log::L().info("Peer {} conectado (n {})", link->name, link->node);
+
+        // Heartbeat: PING a cada intervalo; um enlace mudo por trs
+        // intervalos  dado como morto (a rede pode no avisar).
+        const uint64_t hb_ms = uint64_t(srv.cfg.heartbeat_s) * 1000;
+        Timer heartbeat([&] {
+            if (srv.loop.stopping() || link->conn->closed) return;
+            link->batch += "PING\n";
+            schedule_flush(srv, link);
+            srv.loop.timers().schedule(heartbeat, hb_ms);
+        });
+        Timer silence([&] {
+            if (srv.loop.stopping() || link->conn->closed) return;
+            log::L().warn("Peer {}: sem trfego h {}s, derrubando o enlace", link->name, 3 * srv.cfg.heartbeat_s);
+            close_connection(srv.loop, *link->conn);
+        });
+        if (hb_ms) {
+            srv.loop.timers().schedule(heartbeat, hb_ms);
+            srv.loop.timers().schedule(silence, 3 * hb_ms);
+        }
 
-    // --------- Estruturas compartilhadas ----------
-    std::vector<Client> clients;
-    std::mutex clients_mtx;
-
-    // Histrico simples
-    std::vector<std::string> history;
-    const size_t HISTORY_MAX = 200;
-    std::mutex history_mtx;
-
-    // Fila bounded (monitor) para mensagens a serem broadcastadas
-    ThreadSafeQueue queue(1024);
-
-    // --------- Thread: Broadcaster ----------
-    std::thread broadcaster([&](){
-        while (true) {
-            auto msg_opt = queue.pop(running);
-            if (!msg_opt.has_value()) break; // shutdown sem itens
-            const std::string& msg = *msg_opt;
-
-            // Grava no histrico
-            {
-                std::lock_guard<std::mutex> lk(history_mtx);
-                history.push_back(msg);
-                if (history.size() > HISTORY_MAX) history.erase(history.begin());
+        uint64_t merged = 0;
+        std::string line;
+        for (;;) {
+            const bool ok = co_await async_read_line(srv.loop, *link->conn, line);
+            if (!ok) break;
+            if (hb_ms) srv.loop.timers().schedule(silence, 3 * hb_ms);
+            if (line == "PING") continue;
+            char kind;
+            Message m;
+            if (!parse_frame(line, kind, m)) {
+                log::L().warn("Peer {}: frame invlido", link->name);
+                continue;
             }
+            if (!srv.seen.insert(m.origin, m.epoch, m.seq)) continue; // duplicata
+            if (kind == 'H') { merge_history(srv, std::move(m)); ++merged; continue; }
+
+            srv.peer_latency.add(now_us() - m.ts_us);
+            if (srv.peer_latency.count() >= 1000) report_peer_latency(srv);
+            deliver(srv, std::move(m), link.get());
+        }
+        log::L().info("Peer {} (n {}) desconectou: {} frames em {} envios, {} entradas de histrico mescladas",
+                      link->name, link->node, link->frames, link->sends, merged);
+    }
+    close_connection(srv.loop, *link->conn);
+    auto& peers = srv.peers;
+    peers.erase(std::remove(peers.begin(), peers.end(), link), peers.end());
+}
+
+// Disca um peer e reconecta com backoff enquanto o servidor estiver ativo.
+static Task<> peer_dialer(Server& srv, std::string host, uint16_t port) {
+    const std::string name = host + ":" + std::to_string(port);
+    auto backoff = std::chrono::milliseconds(200);
+    while (!srv.loop.stopping()) {
+        int fd = co_await async_connect(srv.loop, host, port);
+        if (fd >= 0) {
+            backoff = std::chrono::milliseconds(200);
+            co_await peer_link(srv, fd, name);
+        }
+        if (srv.loop.stopping()) break;
+        co_await async_sleep(srv.loop, backoff);
+        backoff = std::min(backoff * 2, std::chrono::milliseconds(5000));
+    }
+}
+
+static Task<> peer_acceptor(Server& srv, int listen_fd) {
+    for (;;) {
+        int fd = co_await async_accept(srv.loop, listen_fd);
+        if (fd < 0) break; // encerrando
+        if (!srv.loop.watch(fd)) { ::close(fd); continue; }
+        spawn(peer_link(srv, fd, "entrada fd=" + std::to_string(fd)));
+    }
+}
+
+// --------- Comandos do cliente (/nick, /msg) ----------
+// Respostas e mensagens diretas vo direto para a sada da sesso alvo, sem
+// passar pela fila de broadcast nem pelo histrico.
+static void reply(Server& srv, const std::shared_ptr<Connection>& c, std::string_view text) {
+    std::string out;
+    out.reserve(text.size() + 3);
+    out.append("* ").append(text).push_back('\n');
+    send_to(srv, c, out);
+}
+
+// Separa a primeira palavra de `rest`
+static std::string_view next_word(std::string_view& rest) {
+    size_t b = rest.find_first_not_of(' ');
+    if (b == std::string_view::npos) { rest = {}; return {}; }
+    rest.remove_prefix(b);
+    size_t e = rest.find(' ');
+    std::string_view w = rest.substr(0, e);
+    rest = (e == std::string_view::npos) ? std::string_view{} : rest.substr(e + 1);
+    return w;
+}
+
+// --------- Anexos: payload por splice, fora da fila (ver Attachments.hpp) ----------
+static constexpr size_t kMaxStreams = 256; // envios de anexo simultneos
+
+static std::string sender_name(Server& srv, const Connection& c) {
+    const std::string_view nick = srv.nicks.nick_of(c.fd, c.id);
+    return nick.empty() ? "fd=" + std::to_string(c.fd) : std::string(nick);
+}
+
+// "/file <bytes> <nome>" seguido dos bytes: grava no spool e anuncia na
+// faixa de avisos. Recusado, o payload no  lido: o cliente recebe o
+// motivo e a conexo  encerrada. false = a conexo no serve mais.
+static Task<bool> receive_attachment(Server& srv, std::shared_ptr<Connection> c, std::string args,
+                                     std::function<void()> progress) {
+    std::string_view rest = args;
+    const std::string_view size_w = next_word(rest);
+    const std::string_view name   = next_word(rest);
+    size_t size = 0;
+    const auto [end, ec] = std::from_chars(size_w.data(), size_w.data() + size_w.size(), size);
+    if (ec != std::errc{} || end != size_w.data() + size_w.size()) {
+        reply(srv, c, "uso: /file <bytes> <nome>, seguido dos bytes");
+        co_return false; // sem o tamanho, no h como achar o fim do payload
+    }
+    if (size == 0) { reply(srv, c, "anexo vazio: nada a enviar"); co_return true; }
+
+    // Tudo validado antes de ler o payload: recusado, ele no  lido (nem
+    // para descarte, o tamanho anunciado pode ser qualquer um) e a conexo,
+    // parada no meio dele,  encerrada
+    std::string refused;
+    if (!srv.cfg.attach_max) refused = "anexos desligados neste servidor";
+    else if (srv.fanout) refused = "anexos indisponveis com --fanout-workers";
+    else if (size > srv.cfg.attach_max) refused = "anexo grande demais (mx " + membudget::human(srv.cfg.attach_max) + ")";
+    else if (!attach::valid_name(name) || !rest.empty()) refused = "nome invlido (1-128 caracteres: letras, dgitos, ., _ ou -)";
+    else if (std::string screened(name); !srv.pipeline.empty() && srv.pipeline.run(screened) != filter::Verdict::Pass) {
+        // O nome vai no aviso para todos: como o apelido, recusado em vez de mascarado
+        ++srv.blocked;
+        refused = "nome recusado pelo filtro";
+    }
+
+    int fd = -1;
+    if (refused.empty() && (fd = srv.spool.create()) < 0) {
+        log::L().error("Falha ao criar anexo em {}: {}", srv.spool.dir(), std::strerror(errno));
+        refused = "spool indisponvel";
+    }
+    if (!refused.empty()) {
+        log::L().info("Anexo de fd={} recusado ({} bytes): {}", c->fd, size, refused);
+        reply(srv, c, refused + ": conexo encerrada");
+        co_return false;
+    }
+
+    const uint64_t t0 = EventLoop::clock_ms();
+    const size_t got = co_await splicing::recv_to_file(srv.loop, *c, fd, size, std::move(progress));
+    if (srv.capture.ok()) srv.capture.payload(c->id, got, now_us());
+    if (got < size) {
+        ::close(fd);
+        log::L().warn("Anexo de fd={} incompleto: {} de {} bytes", c->fd, got, size);
+        co_return false;
+    }
+
+    const std::string from = sender_name(srv, *c);
+    auto f = srv.spool.add(from, std::string(name), size, fd);
+    const std::string id = std::to_string(f->id), amount = membudget::human(size);
+    log::L().info("Anexo {} de fd={}: '{}' ({} em {} ms)", id, c->fd, f->name, amount, EventLoop::clock_ms() - t0);
+    reply(srv, c, "anexo " + id + " recebido (" + amount + ")");
+    if (!srv.queue.try_push(server_notice(Kind::Notice, Lane::System,
+                                          from + " anexou " + f->name + " (" + amount + "): /get " + id))) {
+        log::L().warn("Faixa de avisos cheia: anncio do anexo {} descartado", id);
+    }
+    co_return true;
+}
+
+// Envia um anexo ("/file <id> <bytes> <nome>" e os bytes) no ritmo do
+// destinatrio; a escrita da conexo fica com o envio at o fim.
+static Task<> send_attachment(Server& srv, std::shared_ptr<Connection> c, std::shared_ptr<const attach::File> f) {
+    ++srv.streams;
+    std::string header = "/file " + std::to_string(f->id) + " " + std::to_string(f->size) + " " + f->name + "\n";
+    const bool ok = co_await splicing::send_file(srv.loop, c, std::move(header), f->fd, f->size);
+    --srv.streams;
+    if (ok) {
+        ++srv.spool.sent;
+        log::L().debug("Anexo {} enviado para fd={}", f->id, c->fd);
+    } else if (!c->closed) {
+        log::L().warn("Envio do anexo {} para fd={} interrompido: desconectando", f->id, c->fd);
+        drop(srv, *c);
+    }
+}
+
+// Sesso dona do apelido (nullptr se no h). O fd do registro s vale se
+// a conexo nele ainda  a que registrou, no uma nova no mesmo nmero.
+static std::shared_ptr<Connection> find_nick(Server& srv, std::string_view nick) {
+    const int fd = srv.nicks.lookup(nick);
+    auto c = srv.clients.find(fd);
+    if (!c || c->id != srv.nicks.owner_of(fd)) return nullptr;
+    return c;
+}
+
+// Filtro (--filter): pode mascarar trechos do texto ou bloque-lo; no
+// bloqueio o remetente  avisado. Vale para o broadcast e para as DMs.
+static filter::Verdict screen(Server& srv, const std::shared_ptr<Connection>& c, std::string& text) {
+    if (srv.pipeline.empty()) return filter::Verdict::Pass;
+    std::string_view stage;
+    const filter::Verdict v = srv.pipeline.run(text, &stage);
+    if (v == filter::Verdict::Block) {
+        ++srv.blocked;
+        reply(srv, c, "mensagem bloqueada pelo filtro (" + std::string(stage) + ")");
+    }
+    if (v == filter::Verdict::Masked) ++srv.masked;
+    return v;
+}
+
+// Trata a linha se for comando; false = mensagem comum para broadcast.
+static bool handle_command(Server& srv, const std::shared_ptr<Connection>& c, std::string_view line) {
+    if (line.empty() || line[0] != '/') return false;
+    std::string_view rest = line;
+    const std::string_view cmd = next_word(rest);
+
+    if (cmd == "/nick") {
+        const std::string_view nick = next_word(rest);
+        std::string screened(nick); // o filtro no mascara apelidos: recusa
+        if (!NickRegistry::valid(nick)) {
+            reply(srv, c, "apelido invlido (1-32 caracteres: letras, dgitos, _ ou -)");
+        } else if (!srv.pipeline.empty() && srv.pipeline.run(screened) != filter::Verdict::Pass) {
+            ++srv.blocked;
+            reply(srv, c, "apelido recusado pelo filtro: " + std::string(nick));
+        } else if (!srv.nicks.set(c->fd, c->id, nick)) {
+            reply(srv, c, "apelido em uso: " + std::string(nick));
+        } else {
+            log::L().info("fd={} agora  '{}'", c->fd, nick);
+            reply(srv, c, "agora voc  " + std::string(nick));
+        }
+        return true;
+    }
+
+    if (cmd == "/msg") {
+        const std::string_view to = next_word(rest);
+        if (to.empty() || rest.empty()) { reply(srv, c, "uso: /msg <apelido> <texto>"); return true; }
+        const std::string_view from = srv.nicks.nick_of(c->fd, c->id);
+        if (from.empty()) { reply(srv, c, "defina um apelido com /nick antes de usar /msg"); return true; }
+
+        auto target = find_nick(srv, to);
+        if (!target) { reply(srv, c, "usurio no encontrado: " + std::string(to)); return true; }
+        std::string body(rest);
+        if (screen(srv, c, body) == filter::Verdict::Block) return true;
+
+        pool::Buffer out;
+        out.reserve(from.size() + body.size() + 10);
+        out.append("[DM de ").append(from).append("] ").append(body).push_back('\n');
+        if (!send_to(srv, target, std::string_view(out.data(), out.size()))) {
+            reply(srv, c, "falha ao entregar para " + std::string(to));
+            return true;
+        }
+        log::L().debug("DM fd={} -> fd={} ({} bytes)", c->fd, target->fd, rest.size());
+        return true;
+    }
+
+    if (cmd == "/who") {
+        // Percorre a verso publicada do conjunto, sem travar entradas e sadas
+        constexpr size_t kMaxListed = 50;
+        auto view = srv.clients.view();
+        std::string out = "online (" + std::to_string(view->size()) + "):";
+        size_t listed = 0;
+        for (auto& s : *view) {
+            if (listed == kMaxListed) break;
+            const std::string_view nick = srv.nicks.nick_of(s->fd, s->id);
+            out += listed++ ? ", " : " ";
+            if (nick.empty()) out += "fd=" + std::to_string(s->fd);
+            else out += nick;
+        }
+        if (view->size() > listed) out += " e mais " + std::to_string(view->size() - listed);
+        reply(srv, c, out);
+        return true;
+    }
 
-            // Envia a TODOS os clientes conectados
-            std::lock_guard<std::mutex> lk(clients_mtx);
-            for (auto it = clients.begin(); it != clients.end();) {
-                if (send_all(it->fd, msg.data(), msg.size()) <= 0) {
-                    log::L().warn("Removendo cliente fd={} (send falhou)", it->fd);
-                    ::close(it->fd);
-                    it = clients.erase(it);
-                } else {
-                    ++it;
-                }
+    if (cmd == "/get") {
+        const std::string_view id_w = next_word(rest);
+        uint64_t id = 0;
+        std::from_chars(id_w.data(), id_w.data() + id_w.size(), id);
+        auto f = srv.spool.find(id);
+        if (!f) reply(srv, c, "anexo no encontrado: " + std::string(id_w));
+        else if (c->features & compression::kDeflate) reply(srv, c, "anexos exigem uma conexo sem compresso");
+        else if (srv.streams >= kMaxStreams) reply(srv, c, "envios de anexo demais em curso; tente de novo");
+        else spawn(send_attachment(srv, c, std::move(f)));
+        return true;
+    }
+
+    return false; // outros "/..." seguem como texto comum
+}
+
+// --------- Filtro de contedo ----------
+static void enable_terms(Server& srv) {
+    if (srv.terms_on) return;
+    srv.pipeline.add("termos", [&srv](std::string& line) { return srv.terms.apply(line); });
+    srv.terms_on = true;
+}
+
+// Recompila o filtro em segundo plano; o trfego segue com o autmato atual
+// at a troca. Devolve o resultado ("ok ..." / "erro: ...").
+static Task<std::string> reload_filter(Server& srv, std::string path) {
+    if (!srv.terms.reload(path)) co_return "erro: recarga do filtro j em andamento";
+    while (srv.terms.reloading()) co_await srv.loop.sleep_for(std::chrono::milliseconds(2));
+    std::string status = srv.terms.status();
+    if (status.starts_with("ok")) {
+        srv.cfg.filter_path = std::move(path);
+        enable_terms(srv);
+    }
+    log::L().info("Filtro {}: {}", srv.cfg.filter_path, status);
+    co_return status;
+}
+
+static Task<> reload_filter_logged(Server& srv) {
+    co_await reload_filter(srv, srv.cfg.filter_path);
+}
+
+// --------- Administrao (--admin): ajustes sem reiniciar ----------
+// Um comando por linha no socket UNIX e uma linha de resposta ("ok ..." ou
+// "erro: ..."). Tudo roda na thread do EventLoop, entre duas mensagens:
+// nada para o fluxo e nenhuma trava  necessria.
+static constexpr size_t kAdminMaxQueue   = size_t(1) << 20;
+static constexpr size_t kAdminMaxHistory = 100000;
+static constexpr auto   kDrainMax        = std::chrono::seconds(10);
+
+static const char* level_word(tslog::Level lv) {
+    switch (lv) {
+        case tslog::Level::Debug: return "debug";
+        case tslog::Level::Info:  return "info";
+        case tslog::Level::Warn:  return "warn";
+        default:                  return "error";
+    }
+}
+
+// Nmero inteiro em [lo, hi]; false se `w` no for um.
+static bool parse_size(std::string_view w, size_t lo, size_t hi, size_t& out) {
+    if (w.empty() || w.size() > 12 || w.find_first_not_of("0123456789") != std::string_view::npos) return false;
+    out = std::stoull(std::string(w));
+    return out >= lo && out <= hi;
+}
+
+static Task<std::string> admin_command(Server& srv, std::string line) {
+    std::string_view rest = line;
+    const std::string_view cmd = next_word(rest);
+    size_t n = 0;
+
+    if (cmd == "show") {
+        const std::string file = log::L().file();
+        co_return "ok fila=" + std::to_string(srv.queue.size(Lane::Chat)) + "/" +
+                  std::to_string(srv.queue.capacity(Lane::Chat)) +
+                  " sistema=" + std::to_string(srv.queue.size(Lane::System)) + "/" +
+                  std::to_string(srv.queue.capacity(Lane::System)) +
+                  " controle=" + std::to_string(srv.queue.size(Lane::Control)) + "/" +
+                  std::to_string(srv.queue.capacity(Lane::Control)) +
+                  " histrico=" + std::to_string(srv.history.size()) + "/" + std::to_string(srv.history_max) +
+                  " clientes=" + std::to_string(srv.clients.size()) +
+                  " memria=" + membudget::level_name(srv.mem.level()) +
+                  " anexos=" + std::to_string(srv.spool.count()) + " (" + membudget::human(srv.spool.bytes()) + ")" +
+                  " log=" + level_word(log::L().level()) +
+                  " stdout=" + (log::L().to_stdout ? "on" : "off") +
+                  " arquivo=" + (file.empty() ? "off" : file);
+    }
+
+    if (cmd == "queue") {
+        // queue <n> = faixa de chat; queue <faixa> <n> para as outras
+        Lane lane = Lane::Chat;
+        std::string_view arg = next_word(rest);
+        if (parse_lane(arg, lane)) arg = next_word(rest);
+        if (!parse_size(arg, 1, kAdminMaxQueue, n)) {
+            co_return "erro: uso: queue [controle|sistema|chat] <1-" + std::to_string(kAdminMaxQueue) + ">";
+        }
+        const size_t before = srv.queue.capacity(lane);
+        srv.queue.resize(lane, n);
+        if (lane == Lane::Chat) srv.share.resize(n);
+        log::L().info("Administrao: fila {} {} -> {} ({} na faixa)", lane_name(lane), before, n, srv.queue.size(lane));
+        co_return "ok fila " + std::string(lane_name(lane)) + " " + std::to_string(before) + " -> " + std::to_string(n);
+    }
+
+    if (cmd == "weight") {
+        Lane lane;
+        if (!parse_lane(next_word(rest), lane) || !parse_size(next_word(rest), 0, 1000, n)) {
+            co_return "erro: uso: weight <controle|sistema|chat> <0-1000> (0 = estrita)";
+        }
+        srv.queue.set_weight(lane, static_cast<uint32_t>(n));
+        log::L().info("Administrao: peso da faixa {} -> {}", lane_name(lane), n);
+        co_return "ok peso " + std::string(lane_name(lane)) + " " + std::to_string(n);
+    }
+
+    if (cmd == "mem") {
+        govern_memory(srv); // medida de agora, no a do ltimo tique
+        co_return "ok " + describe_memory(srv);
+    }
+
+    if (cmd == "lanes") {
+        co_return "ok " + describe_lane(srv, Lane::Control) + "; " + describe_lane(srv, Lane::System) + "; " +
+                  describe_lane(srv, Lane::Chat);
+    }
+
+    if (cmd == "notice") {
+        if (rest.empty()) co_return "erro: uso: notice <texto>";
+        const std::string text(rest);
+        Message m = server_notice(Kind::Notice, Lane::System, "aviso: " + text);
+        const bool queued = co_await srv.queue.push(std::move(m));
+        if (!queued) co_return "erro: servidor encerrando";
+        log::L().info("Administrao: aviso '{}'", text);
+        co_return "ok aviso enfileirado";
+    }
+
+    if (cmd == "kick") {
+        // Alvo por apelido ou "fd=N"; o motivo vai para o prprio cliente
+        const std::string_view who = next_word(rest);
+        std::shared_ptr<Connection> target;
+        if (who.starts_with("fd=") && parse_size(who.substr(3), 0, 1u << 30, n)) {
+            target = srv.clients.find(static_cast<int>(n));
+        } else if (!who.empty()) {
+            target = find_nick(srv, who);
+        }
+        if (!target) co_return "erro: uso: kick <apelido|fd=N> [motivo] (sesso no encontrada)";
+        const int fd = target->fd;
+        const std::string reason = rest.empty() ? std::string("sem motivo") : std::string(rest);
+        Message m = server_notice(Kind::Kick, Lane::Control, "removido pelo administrador: " + reason);
+        m.target_fd = fd;
+        m.target_id = target->id; // se a sesso sair antes, o kick no atinge quem herdar o fd
+        const bool queued = co_await srv.queue.push(std::move(m));
+        if (!queued) co_return "erro: servidor encerrando";
+        log::L().info("Administrao: removendo fd={} ({})", fd, reason);
+        co_return "ok removendo fd=" + std::to_string(fd);
+    }
+
+    if (cmd == "history") {
+        if (!parse_size(next_word(rest), 0, kAdminMaxHistory, n)) {
+            co_return "erro: uso: history <0-" + std::to_string(kAdminMaxHistory) + ">";
+        }
+        const size_t before = srv.history_max;
+        srv.history_max = n;
+        srv.history.reserve(n + 1);
+        trim_history(srv); // encolher descarta as mais antigas (a retomada v a lacuna)
+        log::L().info("Administrao: histrico {} -> {}", before, n);
+        co_return "ok histrico " + std::to_string(before) + " -> " + std::to_string(n);
+    }
+
+    if (cmd == "log") {
+        const std::string_view what = next_word(rest);
+        const std::string_view arg  = next_word(rest);
+        if (what == "level") {
+            tslog::Level lv;
+            if (!tslog::parse_level(arg, lv)) co_return "erro: uso: log level <debug|info|warn|error>";
+            log::L().set_level(lv);
+            co_return "ok log level " + std::string(arg);
+        }
+        if (what == "stdout" && (arg == "on" || arg == "off")) {
+            log::L().to_stdout = arg == "on";
+            co_return "ok log stdout " + std::string(arg);
+        }
+        if (what == "file" && !arg.empty()) {
+            // Mesmo caminho de novo: reabre (rotao externa do arquivo)
+            const std::string path = arg == "off" ? std::string() : std::string(arg);
+            if (!log::L().set_file(path)) {
+                co_return "erro: no foi possvel abrir " + path + ": " + std::strerror(errno) + " (arquivo atual mantido)";
             }
-            // Log de amostra (primeiros 80 chars)
-            if (!msg.empty()) {
-                log::L().debug("Broadcast: {}", msg.substr(0, std::min<size_t>(msg.size(), 80)));
+            co_return "ok log file " + (path.empty() ? std::string("off") : path);
+        }
+        co_return "erro: uso: log level <nvel> | log stdout <on|off> | log file <caminho|off>";
+    }
+
+    if (cmd == "drain") {
+        // Espera a fila de broadcast esvaziar; a ingesto segue normalmente
+        const uint64_t t0 = EventLoop::clock_ms();
+        const uint64_t first = srv.hist_seq;
+        while (srv.queue.size() > 0 && !srv.loop.stopping()) {
+            if (EventLoop::clock_ms() - t0 >= uint64_t(kDrainMax.count()) * 1000) {
+                co_return "erro: fila no esvaziou em " + std::to_string(kDrainMax.count()) + "s (" +
+                          std::to_string(srv.queue.size()) + " na fila)";
             }
+            co_await srv.loop.sleep_for(std::chrono::milliseconds(5));
+        }
+        co_return "ok fila vazia: " + std::to_string(srv.hist_seq - first) + " mensagens escoadas em " +
+                  std::to_string(EventLoop::clock_ms() - t0) + " ms";
+    }
+
+    if (cmd == "filter") {
+        const std::string_view what = next_word(rest);
+        if (what == "reload") {
+            std::string path(next_word(rest));
+            if (path.empty()) path = srv.cfg.filter_path;
+            if (path.empty()) co_return "erro: uso: filter reload <arquivo> (sem --filter na partida)";
+            co_return co_await reload_filter(srv, std::move(path));
+        }
+        if (what == "show") {
+            co_return "ok filtro=" + (srv.terms_on ? srv.cfg.filter_path : std::string("off")) +
+                      " padres=" + std::to_string(srv.terms.patterns()) +
+                      " mascaradas=" + std::to_string(srv.masked) + " bloqueadas=" + std::to_string(srv.blocked);
         }
-        log::L().info("Broadcaster finalizado");
+        co_return "erro: uso: filter reload [arquivo] | filter show";
+    }
+
+    if (cmd == "flush") {
+        log::L().flush();
+        co_return "ok log descarregado";
+    }
+
+    co_return "erro: comandos: show, queue [faixa] <n>, weight <faixa> <n>, lanes, mem, history <n>, notice <texto>, "
+              "kick <alvo> [motivo], log ..., filter ..., drain, flush";
+}
+
+static Task<> admin_session(Server& srv, std::shared_ptr<Connection> c) {
+    log::L().info("Administrao: conexo fd={}", c->fd);
+    std::string line;
+    for (;;) {
+        const bool ok = co_await async_read_line(srv.loop, *c, line);
+        if (!ok) break;
+        trim_cr(line);
+        if (line.empty()) continue;
+        std::string out = co_await admin_command(srv, line);
+        out.push_back('\n');
+        if (!send_nowait(srv.loop, c, out)) break;
+    }
+    close_connection(srv.loop, *c);
+}
+
+static Task<> admin_acceptor(Server& srv, int listen_fd) {
+    for (;;) {
+        int fd = co_await async_accept(srv.loop, listen_fd);
+        if (fd < 0) break; // encerrando
+        if (!srv.loop.watch(fd)) { ::close(fd); continue; }
+        auto c = std::allocate_shared<Connection>(pool::Allocator<Connection>{});
+        c->fd = fd;
+        spawn(admin_session(srv, std::move(c)));
+    }
+}
+
+// --------- Corrotina por cliente: recebe por linhas e publica na fila ----------
+// Prazo para as primeiras linhas ("/compress", "/since"): o cliente as manda
+// logo ao conectar, mas numa rede real o segmento com os dados costuma
+// chegar depois do accept. A espera termina na primeira linha, ento quem
+// se anuncia no paga nada alm do trajeto; s quem no manda nada (ou uma
+// linha vazia) recebe o histrico com at kHelloWait de atraso. Pedidos que
+// chegarem depois disso so tratados no lao da sesso.
+static constexpr auto kHelloWait = std::chrono::milliseconds(100);
+
+// "/since" que chegou depois do histrico completo: a sesso j tem tudo e
+// s passa a receber linhas numeradas. "* gap" zera a posio do cliente,
+// que recomea pelo que vier numerado daqui em diante.
+static void start_tags(Server& srv, const std::shared_ptr<Connection>& c) {
+    c->features |= resync::kSeqTags;
+    ++srv.seq_clients;
+    std::string head;
+    resync::append_header(head, true, srv.epoch, srv.hist_seq);
+    send_to(srv, c, head);
+    if (srv.fanout) srv.fanout->tag(c->fd);
+}
+
+static Task<> session(Server& srv, std::shared_ptr<Connection> c) {
+    const int cfd = c->fd;
+    const uint64_t sid = c->id = ++srv.sessions;
+    log::L().info("Novo cliente conectado (fd={})", cfd);
+    if (srv.capture.ok()) srv.capture.connect(sid, cfd, now_us());
+
+    // Olha as primeiras linhas ("/since") antes de escolher entre o
+    // histrico inteiro e s o que falta. Fora da lista de clientes nesse
+    // intervalo: o que for difundido entra no histrico e sai no replay abaixo.
+    std::string line; // reaproveitado a cada linha
+    int first = co_await async_read_line(srv.loop, *c, line, kHelloWait);
+    bool pending = first > 0;
+    if (pending) {
+        trim_cr(line);
+        if (srv.capture.ok()) srv.capture.line(sid, line, now_us());
+    }
+    // "/compress deflate" vem antes do "/since" (ver compression.hpp)
+    const bool want_z = pending && line == "/compress deflate";
+    if (want_z) {
+        first = co_await async_read_line(srv.loop, *c, line, kHelloWait);
+        pending = first > 0;
+        if (pending) {
+            trim_cr(line);
+            if (srv.capture.ok()) srv.capture.line(sid, line, now_us());
+        }
+    }
+    srv.mem.oversized += c->oversized;
+    uint64_t epoch = 0, since = 0;
+    const bool resume = pending && resync::parse_since(line, epoch, since);
+    if (resume) {
+        pending = false;
+        c->features |= resync::kSeqTags;
+        ++srv.seq_clients;
+    }
+
+    // Compresso: a resposta sai em claro e tudo depois dela, comprimido.
+    // Com fanout no h contexto por sesso: os workers mandam o mesmo
+    // buffer a todos.
+    if (want_z && first >= 0) {
+        const bool on = srv.cfg.compress_level > 0 && !srv.fanout;
+        if (on) {
+            srv.deflaters[c.get()] = std::make_unique<compression::Deflater>(srv.cfg.compress_level);
+            c->features |= compression::kDeflate;
+        }
+        send_nowait(srv.loop, c, on ? "* compress deflate\n" : "* compress off\n");
+    }
+
+    // Entra na lista antes do histrico: o envio abaixo enfileira o
+    // histrico antes de qualquer broadcast novo, preservando a ordem.
+    if (first >= 0) {
+        srv.clients.add(c);
+        if (srv.fanout) srv.fanout->add(cfd, resume);
+        if (!srv.mem_watch) spawn(memory_governor(srv));
+    }
+
+    // Histrico (um nico envio): completo, ou s as entradas depois de
+    // `since` se a sesso pediu e o histrico ainda cobre a lacuna.
+    std::string replay;
+    if (resume) {
+        const bool gap = epoch != srv.epoch || since < srv.evicted_seq || since > srv.hist_seq;
+        if (gap) since = 0;
+        resync::append_header(replay, gap, srv.epoch, srv.hist_seq);
+        size_t sent = 0;
+        for (auto& m : srv.history) {
+            if (m.hist_seq > since) { resync::append_tagged(replay, m); ++sent; }
+        }
+        log::L().info("Retomada fd={}: {} ({} de {} entradas)", cfd, gap ? "lacuna grande" : "incremental",
+                      sent, srv.history.size());
+        if (srv.fanout) srv.fanout->unicast(cfd, std::make_shared<const std::string>(std::move(replay)));
+        else if (c->features & compression::kDeflate) send_packed(srv, c, replay);
+        else co_await async_send(srv.loop, *c, replay);
+    } else if (first >= 0) {
+        // Mesmo buffer para todos os que entram; grande o bastante, vai sem cpia
+        auto snap = history_snapshot(srv);
+        if (c->features & compression::kDeflate) {
+            // Comprimido uma vez para todos; o contexto da sesso continua dele
+            auto packed = packed_snapshot(srv);
+            srv.deflaters[c.get()]->prime(*snap);
+            if (srv.cfg.zerocopy_min && packed->size() >= srv.cfg.zerocopy_min) zerocopy::send_nowait(srv.loop, c, packed);
+            else if (!packed->empty()) send_nowait(srv.loop, c, *packed);
+        }
+        else if (srv.fanout) { if (!snap->empty()) srv.fanout->unicast(cfd, snap); }
+        else if (srv.cfg.zerocopy_min && snap->size() >= srv.cfg.zerocopy_min) zerocopy::send_nowait(srv.loop, c, snap);
+        else if (!snap->empty()) co_await async_send(srv.loop, *c, *snap);
+    }
+
+    // Inatividade: reagendado a cada linha recebida
+    const uint64_t idle_ms = uint64_t(srv.cfg.idle_timeout_s) * 1000;
+    Timer idle([&srv, c, cfd] {
+        if (srv.loop.stopping() || c->closed) return;
+        log::L().info("Cliente fd={} inativo h {}s: desconectando", cfd, srv.cfg.idle_timeout_s);
+        send_to(srv, c, "* desconectado por inatividade\n");
+        drop(srv, *c); // acorda a leitura abaixo, que termina
     });
+    if (idle_ms && first >= 0) srv.loop.timers().schedule(idle, idle_ms);
 
-    // --------- Thread: Aceitao de clientes ----------
-    std::thread accept_th([&](){
-        while (running.load()) {
-            sockaddr_in cli{}; socklen_t cl = sizeof(cli);
-            int cfd = ::accept(listen_fd, (sockaddr*)&cli, &cl);
-            if (cfd < 0) {
-                if (!running.load()) break;
-                int e = errno;
-                if (e == EBADF || e == EINVAL) { // fd invlido/fechado -> estamos encerrando
-                    log::L().info("Aceitao finalizada (listen_fd fechado)");
-                    break;
-                }
-                if (e == EINTR) continue; // sinal -> tenta de novo
-                // demais erros transitrios -> continua
-                continue;
+    // Limite de taxa (por sesso) e partilha da fila (entre sesses)
+    ratelimit::TokenBucket bucket(srv.cfg.rate, srv.cfg.burst, EventLoop::clock_ms());
+    uint64_t throttled = 0, dropped = 0;
+    bool warned = false; // aviso de descarte j enviado nesta sequncia
+
+    // Linhas seguidas sem suspender: um cliente que nunca esvazia o socket
+    // prenderia o loop (accept e as outras sesses esperariam). A cada
+    // kReadBurst a sesso cede a vez at a prxima volta do epoll; sem
+    // otimizao, isso tambm limita a pilha, j que o GCC no faz da
+    // transferncia simtrica uma chamada de cauda.
+    constexpr unsigned kReadBurst = 64;
+    unsigned burst = 0;
+
+    // (co_await fora de expresses com curto-circuito: o GCC 12 as avalia mal)
+    while (first >= 0) {
+        if (++burst == kReadBurst) {
+            burst = 0;
+            co_await srv.loop.next_round();
+            if (c->closed || srv.loop.stopping()) break;
+        }
+        // Memria sob presso: para de ler at o governador liberar
+        while (srv.mem.throttle() && !c->closed && !srv.loop.stopping()) {
+            ++srv.mem.paused;
+            co_await srv.loop.sleep_for(kMemTick);
+        }
+        if (c->closed || srv.loop.stopping()) break;
+        if (!pending) {
+            const uint64_t oversized = c->oversized;
+            const bool ok = co_await async_read_line(srv.loop, *c, line);
+            if (c->oversized != oversized) {
+                srv.mem.oversized += c->oversized - oversized;
+                reply(srv, c, "linha longa demais (mx " + std::to_string(c->line_max) + " bytes): descartada");
+            }
+            if (!ok) break;
+            trim_cr(line);
+            if (srv.capture.ok()) srv.capture.line(sid, line, now_us());
+        }
+        pending = false;
+        if (idle_ms) srv.loop.timers().schedule(idle, idle_ms);
+        if (line.empty()) continue;
+
+        // Toda linha paga uma ficha, comandos inclusive (/msg, /who, /file
+        // custam tanto quanto um broadcast). Sem ficha: para de ler at a
+        // prxima (o TCP segura o cliente). O timer pode acordar um pouco
+        // antes da ficha: tenta de novo at consumir uma, seno a linha
+        // passaria sem pagar.
+        if (srv.cfg.rate) {
+            uint64_t wait = bucket.take(EventLoop::clock_ms());
+            if (wait) { ++throttled; ++srv.throttled; }
+            while (wait && !c->closed && !srv.loop.stopping()) {
+                co_await srv.loop.sleep_for(std::chrono::milliseconds(wait));
+                wait = bucket.take(EventLoop::clock_ms());
             }
+            if (c->closed || srv.loop.stopping()) break;
+        }
+
+        // Pedidos de incio que chegaram depois da escolha acima. O histrico
+        // j saiu em claro: a resposta  sempre "off", e o cliente a reconhece
+        // porque nenhuma linha de usurio comea com "* compress " (abaixo)
+        if (line == "/compress deflate") { reply(srv, c, "compress off"); continue; }
+        if (line.starts_with("* compress ")) {
+            reply(srv, c, "linha reservada  negociao de compresso: descartada");
+            continue;
+        }
+        if (!(c->features & resync::kSeqTags) && resync::parse_since(line, epoch, since)) {
+            start_tags(srv, c);
+            continue;
+        }
+        if (line.starts_with("/file ")) {
+            // O prazo de inatividade segue valendo: cada bloco do payload o reagenda
+            auto progress = [&] { if (idle_ms) srv.loop.timers().schedule(idle, idle_ms); };
+            const bool ok = co_await receive_attachment(srv, c, line.substr(6), progress);
+            if (!ok) break;
+            progress();
+            continue;
+        }
+        if (handle_command(srv, c, line)) continue;
+
+        if (!srv.share.admit(cfd, srv.queue.size(Lane::Chat))) {
+            ++dropped; ++srv.dropped;
+            if (!warned) reply(srv, c, "fila congestionada: mensagens descartadas");
+            warned = true;
+            continue;
+        }
+        warned = false;
+
+        if (screen(srv, c, line) == filter::Verdict::Block) continue;
+
+        const uint64_t trace_id = trace::sample();
+        trace::mark(trace_id, trace::Stage::Recv);
+        Message m;
+        m.trace = trace_id;
+        m.text.reserve(line.size() + 1);
+        m.text.append(line).push_back('\n');
+        m.src_fd = cfd;
+
+        srv.share.acquire(cfd);
+        // (resultado num local, como em flush_owned)
+        const bool queued = co_await srv.queue.push(std::move(m));
+        if (!queued) { srv.share.release(cfd); break; }
+        trace::mark(trace_id, trace::Stage::Enqueue);
+        log::L().info("RX fd={} '{}'", cfd, line);
+    }
+    if (throttled || dropped) {
+        log::L().info("Cliente fd={} desconectou ({} linhas atrasadas, {} descartadas)", cfd, throttled, dropped);
+    } else {
+        log::L().info("Cliente fd={} desconectou", cfd);
+    }
+    if (srv.capture.ok()) srv.capture.disconnect(sid, now_us());
+    drop(srv, *c);
+    // Remove da lista (O(1) pelo ndice de fd) e libera o apelido
+    srv.clients.remove(c);
+    srv.nicks.erase(cfd, sid);
+    srv.deflaters.erase(c.get());
+    if (c->features & resync::kSeqTags) --srv.seq_clients;
+}
+
+// --------- Rastreamento: dump sob demanda (SIGUSR1) ----------
+static void dump_trace(const std::string& path) {
+    const long n = trace::dump(path);
+    if (n < 0) log::L().error("Falha ao gravar rastreamento em {}", path);
+    else       log::L().info("Rastreamento: {} mensagens gravadas em {}", n, path);
+}
 
-            {
-                std::lock_guard<std::mutex> lk(clients_mtx);
-                clients.push_back(Client{cfd});
+// --------- Sinais via signalfd: chegam como leitura no loop ----------
+// SIGINT/SIGTERM encerram; SIGUSR1 grava o rastreamento; SIGHUP recarrega o filtro.
+static Task<> signal_watcher(Server& srv, int sfd) {
+    for (;;) {
+        signalfd_siginfo si;
+        ssize_t n = ::read(sfd, &si, sizeof(si));
+        if (n == static_cast<ssize_t>(sizeof(si))) {
+            if (si.ssi_signo == SIGUSR1) {
+                if (trace::enabled()) dump_trace(srv.cfg.trace_path);
+                else log::L().info("SIGUSR1 ignorado: rastreamento desligado (use --trace)");
+                continue;
             }
-            log::L().info("Novo cliente conectado (fd={})", cfd);
-
-            // Envia histrico ao novo cliente
-            {
-                std::lock_guard<std::mutex> lk(history_mtx);
-                for (auto& line : history) {
-                    if (send_all(cfd, line.data(), line.size()) <= 0) break;
-                }
+            if (si.ssi_signo == SIGHUP) {
+                if (srv.cfg.filter_path.empty()) log::L().info("SIGHUP ignorado: sem filtro (use --filter)");
+                else spawn(reload_filter_logged(srv));
+                continue;
             }
+            log::L().info("Sinal {} recebido", ::strsignal(static_cast<int>(si.ssi_signo)));
+            // Aviso pela faixa de controle,  frente do chat enfileirado; o
+            // broadcaster para o loop logo depois de entreg-lo
+            if (!srv.queue.try_push(server_notice(Kind::Shutdown, Lane::Control, "servidor encerrando"))) {
+                srv.loop.request_stop();
+            }
+            co_return;
+        }
+        if (n < 0 && errno == EINTR) continue;
+        if (srv.loop.stopping() || (n < 0 && errno != EAGAIN)) co_return;
+        co_await srv.loop.readable(sfd);
+    }
+}
 
-            // Thread por cliente: recebe por linhas e publica na fila
-            std::thread([&, cfd](){
-                char buf[1024];
-                std::string acc;
-                while (running.load()) {
-                    ssize_t n = ::recv(cfd, buf, sizeof(buf), 0);
-                    if (n <= 0) break; // desconectou ou erro
-                    acc.append(buf, buf + n);
-
-                    // Processa por linhas
-                    for (;;) {
-                        auto pos = acc.find('\n');
-                        if (pos == std::string::npos) break;
-                        std::string line = acc.substr(0, pos);
-                        acc.erase(0, pos + 1);
-                        trim_cr(line);
-                        if (line.empty()) continue;
-
-                        std::string out = line + "\n";
-
-                        if (!queue.push(out, running)) break;
-                        log::L().info("RX fd={} '{}'", cfd, line);
-                    }
-                }
-                log::L().info("Cliente fd={} desconectou", cfd);
-                ::close(cfd);
-                // Remove da lista
-                std::lock_guard<std::mutex> lk(clients_mtx);
-                for (auto it = clients.begin(); it != clients.end(); ++it) {
-                    if (it->fd == cfd) { clients.erase(it); break; }
-                }
-            }).detach();
-        }
-        log::L().info("Aceitao finalizada");
-    });
+// --------- Corrotina: Aceitao de clientes ----------
+static Task<> acceptor(Server& srv, int listen_fd) {
+    for (;;) {
+        int cfd = co_await async_accept(srv.loop, listen_fd);
+        if (cfd < 0) break; // encerrando
+        if (!srv.loop.watch(cfd)) {
+            log::L().warn("epoll recusou fd={}", cfd);
+            ::close(cfd);
+            continue;
+        }
+        auto c = std::allocate_shared<Connection>(pool::Allocator<Connection>{});
+        c->fd = cfd;
+        c->line_max = srv.cfg.line_max;
+        if (srv.cfg.zerocopy_min) zerocopy::enable(*c); // AF_UNIX recusa: segue com cpia
+        spawn(session(srv, std::move(c)));
+    }
+    log::L().info("Aceitao finalizada");
+}
+
+int main(int argc, char** argv) {
+    // Sinais bloqueados: so lidos pelo signalfd, dentro do loop
+    sigset_t sigs;
+    sigemptyset(&sigs);
+    sigaddset(&sigs, SIGINT);
+    sigaddset(&sigs, SIGTERM);
+    sigaddset(&sigs, SIGUSR1);
+    sigaddset(&sigs, SIGHUP);
+    ::pthread_sigmask(SIG_BLOCK, &sigs, nullptr);
+    // splice para um socket fechado gera SIGPIPE (no h MSG_NOSIGNAL); o erro
+    // volta como EPIPE
+    std::signal(SIGPIPE, SIG_IGN);
+
+    // Uso: ./chat_server [porta] [opes de federao]
+    ServerConfig cfg;
+    if (!parse_args(argc, argv, cfg)) {
+        print_usage(argv[0]);
+        return 2;
+    }
+    uint16_t port = cfg.port;
+    log::L().set_level(cfg.log_level);
 
-    while (running.load()) {
-        std::this_thread::sleep_for(std::chrono::milliseconds(100));
+    // Acceptor, sesses e broadcaster rodam todos na thread do EventLoop
+    // (esta). Fixa antes de criar o estado, para alocar no n NUMA local.
+    if (!placement::pin_current(cfg.cpus.of(placement::Role::Loop), "chat-loop")) {
+        std::cerr << "Falha ao aplicar afinidade de CPU: " << placement::describe(cfg.cpus) << "\n";
+        return 1;
     }
 
+    int listen_fd = make_server_socket(port);
+    if (listen_fd < 0) {
+        std::cerr << "Erro ao abrir porta " << port << "\n";
+        return 1;
+    }
+    int unix_fd = -1;
+    if (!cfg.unix_path.empty() && (unix_fd = make_unix_server_socket(cfg.unix_path)) < 0) {
+        std::cerr << "Erro ao abrir socket UNIX " << cfg.unix_path << ": " << std::strerror(errno) << "\n";
+        ::close(listen_fd);
+        return 1;
+    }
+    int peer_fd = -1;
+    if (cfg.peer_port != 0 && (peer_fd = make_server_socket(cfg.peer_port)) < 0) {
+        std::cerr << "Erro ao abrir porta de peers " << cfg.peer_port << "\n";
+        ::close(listen_fd);
+        if (unix_fd >= 0) { ::close(unix_fd); ::unlink(cfg.unix_path.c_str()); }
+        return 1;
+    }
+
+    int admin_fd = -1;
+    if (!cfg.admin_path.empty() && (admin_fd = make_unix_server_socket(cfg.admin_path)) < 0) {
+        std::cerr << "Erro ao abrir socket de administrao " << cfg.admin_path << ": " << std::strerror(errno) << "\n";
+        ::close(listen_fd);
+        if (unix_fd >= 0) { ::close(unix_fd); ::unlink(cfg.unix_path.c_str()); }
+        if (peer_fd >= 0) ::close(peer_fd);
+        return 1;
+    }
+
+    Server srv{cfg};
+    if (!cfg.capture_path.empty() && !srv.capture.open(cfg.capture_path, now_us())) {
+        std::cerr << "Erro ao criar o arquivo de captura " << cfg.capture_path << "\n";
+        ::close(listen_fd);
+        if (unix_fd >= 0) { ::close(unix_fd); ::unlink(cfg.unix_path.c_str()); }
+        if (peer_fd >= 0) ::close(peer_fd);
+        if (admin_fd >= 0) { ::close(admin_fd); ::unlink(cfg.admin_path.c_str()); }
+        return 1;
+    }
+    if (!cfg.filter_path.empty() && !srv.terms.load(cfg.filter_path)) {
+        std::cerr << "Erro ao ler os padres do filtro " << cfg.filter_path << "\n";
+        ::close(listen_fd);
+        if (unix_fd >= 0) { ::close(unix_fd); ::unlink(cfg.unix_path.c_str()); }
+        if (peer_fd >= 0) ::close(peer_fd);
+        if (admin_fd >= 0) { ::close(admin_fd); ::unlink(cfg.admin_path.c_str()); }
+        return 1;
+    }
+    if (!cfg.filter_path.empty()) enable_terms(srv);
+    if (!cfg.shm_name.empty() && !srv.ring.create(cfg.shm_name, size_t(cfg.shm_kb) * 1024)) {
+        std::cerr << "Erro ao criar o anel em memria compartilhada " << cfg.shm_name << "\n";
+        ::close(listen_fd);
+        if (unix_fd >= 0) { ::close(unix_fd); ::unlink(cfg.unix_path.c_str()); }
+        if (peer_fd >= 0) ::close(peer_fd);
+        if (admin_fd >= 0) { ::close(admin_fd); ::unlink(cfg.admin_path.c_str()); }
+        return 1;
+    }
+    const int sig_fd = ::signalfd(-1, &sigs, SFD_NONBLOCK | SFD_CLOEXEC);
+    if (!srv.loop.ok() || sig_fd < 0 || !srv.loop.watch(sig_fd) ||
+        !set_nonblocking(listen_fd) || !srv.loop.watch(listen_fd) ||
+        (unix_fd >= 0 && (!set_nonblocking(unix_fd) || !srv.loop.watch(unix_fd))) ||
+        (peer_fd >= 0 && (!set_nonblocking(peer_fd) || !srv.loop.watch(peer_fd))) ||
+        (admin_fd >= 0 && (!set_nonblocking(admin_fd) || !srv.loop.watch(admin_fd)))) {
+        std::cerr << "Erro ao iniciar o loop de eventos\n";
+        ::close(listen_fd);
+        if (unix_fd >= 0) { ::close(unix_fd); ::unlink(cfg.unix_path.c_str()); }
+        if (peer_fd >= 0) ::close(peer_fd);
+        if (admin_fd >= 0) { ::close(admin_fd); ::unlink(cfg.admin_path.c_str()); }
+        if (sig_fd >= 0) ::close(sig_fd);
+        return 1;
+    }
+    log::L().info("Servidor ouvindo na porta {} (n {})", port, cfg.node_id);
+    if (srv.ring.ok()) log::L().info("Publicando em memria compartilhada: {} ({} KiB)", cfg.shm_name, srv.ring.capacity() / 1024);
+    if (srv.terms_on) log::L().info("Filtro: {} padres de {}", srv.terms.patterns(), cfg.filter_path);
+    if (srv.capture.ok()) log::L().info("Capturando o trfego de entrada em {}", cfg.capture_path);
+    if (cfg.rate) log::L().info("Limite de taxa: {} linhas/s por cliente, rajada {}", cfg.rate, cfg.burst);
+    if (!cfg.cpus.empty()) {
+        log::L().info("Afinidade: {} (n NUMA {})", placement::describe(cfg.cpus), placement::current_node());
+    }
+    std::cout << "Servidor rodando (Ctrl+C para encerrar)\n";
+
+    if (cfg.fanout_workers) {
+        if (cfg.zerocopy_min) log::L().warn("--zerocopy  ignorado com --fanout-workers");
+        srv.fanout = std::make_unique<FanoutPool>(cfg.fanout_workers, cfg.cpus);
+        srv.fanout->set_out_cap(srv.mem.out_cap());
+        log::L().info("Fanout paralelo: {} workers", cfg.fanout_workers);
+    }
+
+    spawn(signal_watcher(srv, sig_fd));
+    spawn(broadcaster(srv));
+    spawn(acceptor(srv, listen_fd));
+    if (unix_fd >= 0) {
+        // Mesma sesso, mesmo conjunto de broadcast: s o transporte muda
+        log::L().info("Aceitando clientes locais em {}", cfg.unix_path);
+        spawn(acceptor(srv, unix_fd));
+    }
+    if (peer_fd >= 0) {
+        log::L().info("Federao: aceitando peers na porta {}", cfg.peer_port);
+        spawn(peer_acceptor(srv, peer_fd));
+    }
+    for (auto& [host, pport] : cfg.peers) spawn(peer_dialer(srv, host, pport));
+    if (admin_fd >= 0) {
+        log::L().info("Administrao em {} (fila {}, histrico {})", cfg.admin_path, cfg.queue_cap, cfg.history_max);
+        spawn(admin_acceptor(srv, admin_fd));
+    }
+    if (!cfg.trace_path.empty()) {
+        trace::enable(cfg.trace_every);
+        log::L().info("Rastreamento ligado: 1 a cada {} mensagens -> {}", cfg.trace_every, cfg.trace_path);
+    }
+
+    // Roda acceptor, sesses e broadcaster at SIGINT/SIGTERM
+    srv.loop.run();
+
     // --------- SHUTDOWN ----------
     log::L().info("Encerrando servidor...");
-    running.store(false);
 
-    // Acorda broadcaster/consumidores
-    queue.notify_all();
+    // Acorda toda corrotina parada em I/O (accept/recv/send falham daqui em diante)
+    srv.loop.stop();
 
-    // Desbloqueia accept()
-    ::shutdown(listen_fd, SHUT_RDWR);
-    ::close(listen_fd);
+    // Broadcaster drena o que restou na fila e termina
+    srv.queue.close();
+    srv.loop.drain();
 
-    // Desbloqueia possveis recv() nos clientes (threads destacadas)
-    {
-        std::lock_guard<std::mutex> lk(clients_mtx);
-        for (auto& c : clients) {
-            ::shutdown(c.fd, SHUT_RDWR);
-        }
+    ::close(listen_fd);
+    if (unix_fd >= 0) { ::close(unix_fd); ::unlink(cfg.unix_path.c_str()); }
+    if (peer_fd >= 0) ::close(peer_fd);
+    if (admin_fd >= 0) { ::close(admin_fd); ::unlink(cfg.admin_path.c_str()); }
+    ::close(sig_fd);
+    report_peer_latency(srv);
+    if (srv.ring.ok()) {
+        log::L().info("Anel {}: {} mensagens publicadas, {} despertares de leitores",
+                      cfg.shm_name, srv.ring.published(), srv.ring.wakeups());
+        srv.ring.close();
     }
+    if (srv.capture.ok()) {
+        srv.capture.close();
+        log::L().info("Captura {}: {} registros, {} bytes{}", cfg.capture_path, srv.capture.records(),
+                      srv.capture.bytes(), srv.capture.errors() ? " (com erros de escrita)" : "");
+    }
+    if (cfg.zerocopy_min) {
+        const auto& z = zerocopy::stats();
+        log::L().info("Zerocopy: {} envios ({} bytes), {} concludos ({} copiados pelo kernel), "
+                      "{} com cpia, desligado em {} sockets",
+                      z.sends, z.bytes, z.completed, z.copied, z.fallbacks, z.disabled);
+    }
+    log::L().info("Ingesto: {} linhas atrasadas pelo limite de taxa, {} descartadas pela partilha da fila",
+                  srv.throttled, srv.dropped);
+    if (srv.terms_on) log::L().info("Filtro: {} linhas mascaradas, {} bloqueadas", srv.masked, srv.blocked);
+    srv.mem.assess(memory_usage(srv), EventLoop::clock_ms());
+    log::L().info("Memria: {}", describe_memory(srv));
+    if (const auto& z = compression::stats(); z.plain) {
+        log::L().info("Compresso: {} de texto -> {} ({}% do original), {} ms de CPU", membudget::human(z.plain),
+                      membudget::human(z.packed), (z.packed * 100 + z.plain / 2) / z.plain, z.cpu_ns / 1000000);
+    }
+    if (srv.spool.received) {
+        const auto& sp = splicing::stats();
+        log::L().info("Anexos: {} recebidos, {} envios completos ({} bytes recebidos, {} enviados por splice)",
+                      srv.spool.received, srv.spool.sent, sp.received, sp.sent);
+    }
+    for (Lane l : {Lane::Control, Lane::System, Lane::Chat}) log::L().info("Fila: {}", describe_lane(srv, l));
+    if (trace::enabled()) dump_trace(cfg.trace_path);
+    log::L().info("Pool de memria: {}", pool::summary());
 
-    // Junta threads longas
-    accept_th.join();
-    broadcaster.join();
-
-    // Fecha FDs remanescentes (se alguma thread no fechou)
+    // Fecha FDs remanescentes (se alguma sesso no fechou)
     {
-        std::lock_guard<std::mutex> lk(clients_mtx);
-        for (auto& c : clients) ::close(c.fd);
-        clients.clear();
+        auto left = srv.clients.view();
+        for (auto& c : *left) drop(srv, *c);
+    }
+    srv.clients.clear();
+    srv.loop.drain();
+    if (srv.fanout) {
+        srv.fanout->stop(); // envia o que j foi publicado, escoa os pendentes e fecha os fds
+        const auto f = srv.fanout->stats();
+        log::L().info("Fanout: {} publicaes, {} envios ({} com pendncia), {} clientes com falha de envio, "
+                      "{} lentos derrubados", f.broadcasts, f.sends, f.backlogged, f.failures, f.slow);
     }
 
     log::L().info("Servidor finalizado com sucesso");
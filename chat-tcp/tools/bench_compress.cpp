@@ -0,0 +1,203 @@
+// Custo de CPU contra bytes economizados pela compresso negociada
+// ("/compress deflate", common/compression.hpp), sem rede: mede s o que o
+// servidor faz por sesso. Resultado em JSON no stdout, um bloco por nvel.
+//
+// Cenrio: `sessions` clientes entram com um histrico de `history` linhas
+// e depois recebem `messages` broadcasts.
+//  - join_per_client: o histrico comprimido de novo para cada um;
+//  - join_shared: comprimido uma vez, no nvel kPackLevel, e reaproveitado
+//    (o que o servidor faz), mais o prime do contexto de cada sesso;
+//  - live: cada broadcast comprimido no contexto de cada sesso (sync flush
+//    por mensagem, como no envio real).
+// A primeira sesso  descomprimida e comparada com o texto original.
+//
+// Linhas de --input (um log, uma captura exportada) ou, sem ele, chat
+// sinttico com apelidos e vocabulrio pequenos.
+//
+// Uso: ./bench_compress [--input arquivo] [--sessions 50] [--history 200] [--messages 5000] [--levels 1,6,9]
+#include <cstdint>
+#include <fstream>
+#include <iostream>
+#include <memory>
+#include <random>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include "common/compression.hpp"
+
+namespace {
+
+struct Options {
+    std::string      input;
+    size_t           sessions = 50;
+    size_t           history  = 200;
+    size_t           messages = 5000;
+    std::vector<int> levels{1, 6, 9};
+};
+
+struct Phase {
+    uint64_t plain  = 0; // bytes de texto
+    uint64_t wire   = 0; // bytes comprimidos
+    uint64_t cpu_ns = 0;
+};
+
+struct Result {
+    int   level = 0;
+    Phase per_client, shared, live;
+    bool  ok = false;
+};
+
+std::vector<std::string> synthetic(size_t n) {
+    static const char* nicks[] = {"alice", "bob", "carol", "dave", "erin", "frank"};
+    static const char* words[] = {"oi", "tudo", "bem", "hoje", "reunio", "servidor", "deploy", "amanh",
+                                  "ok", "certo", "log", "erro", "fila", "teste", "cliente", "verso"};
+    std::mt19937 rng(42);
+    std::vector<std::string> out;
+    out.reserve(n);
+    for (size_t i = 0; i < n; ++i) {
+        std::string s = nicks[rng() % 6];
+        s += ':';
+        for (unsigned w = 3 + rng() % 10; w; --w) { s += ' '; s += words[rng() % 16]; }
+        s += '\n';
+        out.push_back(std::move(s));
+    }
+    return out;
+}
+
+std::vector<std::string> load(const std::string& path, size_t n) {
+    std::ifstream f(path);
+    std::vector<std::string> out;
+    std::string line;
+    while (out.size() < n && std::getline(f, line)) out.push_back(line + '\n');
+    return out;
+}
+
+Result run(const Options& o, const std::vector<std::string>& lines, int level) {
+    Result r;
+    r.level = level;
+    std::string snapshot;
+    for (size_t i = 0; i < o.history; ++i) snapshot += lines[i];
+
+    // Histrico comprimido por cliente
+    uint64_t t0 = compression::thread_cpu_ns();
+    for (size_t s = 0; s < o.sessions; ++s) {
+        r.per_client.wire  += compression::pack(snapshot, level).size();
+        r.per_client.plain += snapshot.size();
+    }
+    r.per_client.cpu_ns = compression::thread_cpu_ns() - t0;
+
+    // Uma vez para todos, mais o contexto de cada sesso
+    std::vector<std::unique_ptr<compression::Deflater>> z;
+    t0 = compression::thread_cpu_ns();
+    const std::string packed = compression::pack(snapshot, compression::kPackLevel);
+    for (size_t s = 0; s < o.sessions; ++s) {
+        z.push_back(std::make_unique<compression::Deflater>(level));
+        z.back()->prime(snapshot);
+        r.shared.wire  += packed.size();
+        r.shared.plain += snapshot.size();
+    }
+    r.shared.cpu_ns = compression::thread_cpu_ns() - t0;
+
+    // Broadcasts: cada mensagem no contexto de cada sesso
+    std::string first = packed, out;
+    t0 = compression::thread_cpu_ns();
+    for (size_t m = 0; m < o.messages; ++m) {
+        const std::string& text = lines[o.history + m];
+        for (size_t s = 0; s < o.sessions; ++s) {
+            out.clear();
+            if (!z[s]->compress(text, out)) return r;
+            r.live.wire  += out.size();
+            r.live.plain += text.size();
+            if (s == 0) first += out;
+        }
+    }
+    r.live.cpu_ns = compression::thread_cpu_ns() - t0;
+
+    // Ida e volta da primeira sesso
+    std::string expect = snapshot, got;
+    for (size_t m = 0; m < o.messages; ++m) expect += lines[o.history + m];
+    compression::Inflater in;
+    r.ok = in.feed(first, got) && got == expect;
+    return r;
+}
+
+void print(std::string_view name, const Phase& p, bool last) {
+    const double mb = double(p.plain) / double(1 << 20);
+    const double ms = double(p.cpu_ns) / 1e6;
+    std::cout << "    \"" << name << "\": {\"plain\": " << p.plain << ", \"wire\": " << p.wire
+              << ", \"ratio\": " << (p.plain ? double(p.wire) / double(p.plain) : 0.0)
+              << ", \"saved\": " << (p.plain - p.wire) << ", \"cpu_ms\": " << ms
+              << ", \"cpu_ms_per_mb\": " << (mb > 0 ? ms / mb : 0.0)
+              << ", \"saved_kb_per_cpu_ms\": " << (ms > 0 ? double(p.plain - p.wire) / 1024 / ms : 0.0) << "}"
+              << (last ? "\n" : ",\n");
+}
+
+bool parse(int argc, char** argv, Options& o) {
+    try {
+        for (int i = 1; i < argc; ++i) {
+            std::string_view a = argv[i];
+            if (i + 1 >= argc) return false;
+            std::string v = argv[++i];
+            if      (a == "--input")    o.input    = v;
+            else if (a == "--sessions") o.sessions = std::stoul(v);
+            else if (a == "--history")  o.history  = std::stoul(v);
+            else if (a == "--messages") o.messages = std::stoul(v);
+            else if (a == "--levels") {
+                o.levels.clear();
+                size_t pos = 0;
+                while (pos <= v.size()) {
+                    size_t comma = v.find(',', pos);
+                    if (comma == std::string::npos) comma = v.size();
+                    const int lv = std::stoi(v.substr(pos, comma - pos));
+                    if (lv < 1 || lv > 9) return false;
+                    o.levels.push_back(lv);
+                    pos = comma + 1;
+                }
+            } else return false;
+        }
+    } catch (const std::exception&) {
+        return false;
+    }
+    return o.sessions > 0 && !o.levels.empty();
+}
+
+} // namespace
+
+int main(int argc, char** argv) {
+    Options opt;
+    if (!parse(argc, argv, opt)) {
+        std::cerr << "Uso: " << argv[0]
+                  << " [--input arquivo] [--sessions n] [--history n] [--messages n] [--levels 1,6,9]\n";
+        return 2;
+    }
+    const size_t need = opt.history + opt.messages;
+    std::vector<std::string> lines = opt.input.empty() ? synthetic(need) : load(opt.input, need);
+    if (lines.size() < need) {
+        std::cerr << "Entrada com " << lines.size() << " linhas; so necessrias " << need << "\n";
+        return 1;
+    }
+
+    std::vector<Result> results;
+    for (int lv : opt.levels) results.push_back(run(opt, lines, lv));
+
+    std::cout.setf(std::ios::fixed);
+    std::cout.precision(3);
+    std::cout << "{\n"
+              << "  \"config\": {\"input\": \"" << (opt.input.empty() ? "sinttico" : opt.input)
+              << "\", \"sessions\": " << opt.sessions << ", \"history\": " << opt.history
+              << ", \"messages\": " << opt.messages << ", \"state_kb_per_session\": "
+              << compression::kStateBytes / 1024 << "},\n";
+    bool ok = true;
+    for (size_t i = 0; i < results.size(); ++i) {
+        const Result& r = results[i];
+        ok = ok && r.ok;
+        std::cout << "  \"level_" << r.level << "\": {\"roundtrip_ok\": " << (r.ok ? "true" : "false") << ",\n";
+        print("join_per_client", r.per_client, false);
+        print("join_shared", r.shared, false);
+        print("live", r.live, true);
+        std::cout << "  }" << (i + 1 < results.size() ? ",\n" : "\n");
+    }
+    std::cout << "}\n";
+    return ok ? 0 : 1;
+}
@@ -0,0 +1,137 @@
+// Custo do filtro de contedo (server/Filter.hpp) por byte de mensagem,
+// contra a busca ingnua (um std::string::find por padro), conforme o
+// nmero de padres cresce. Sem rede nem servidor: s a varredura.
+//
+// Padres e linhas sintticos (palavras em minsculas, sementes fixas);
+// cerca de uma linha em oito contm um dos padres. As duas abordagens
+// mascaram a mesma sada: a ferramenta confere antes de medir.
+//
+// Uso: ./bench_filter [--patterns 1,10,100,1000,5000] [--lines 2000] [--line-size 200]
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <iostream>
+#include <random>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include "server/Filter.hpp"
+
+namespace {
+
+struct Options {
+    std::vector<size_t> patterns{1, 10, 100, 1000, 5000};
+    size_t              lines     = 2000;
+    size_t              line_size = 200;
+};
+
+std::string word(std::mt19937& rng, size_t min, size_t max) {
+    std::string w(min + rng() % (max - min + 1), 'a');
+    for (char& ch : w) ch = static_cast<char>('a' + rng() % 26);
+    return w;
+}
+
+std::vector<filter::Matcher::Pattern> make_patterns(size_t n) {
+    std::mt19937 rng(7);
+    std::vector<filter::Matcher::Pattern> out(n);
+    for (auto& p : out) p.text = word(rng, 5, 9);
+    return out;
+}
+
+std::vector<std::string> make_lines(const Options& o, const std::vector<filter::Matcher::Pattern>& pats) {
+    std::mt19937 rng(42);
+    std::vector<std::string> out(o.lines);
+    for (auto& s : out) {
+        while (s.size() < o.line_size) { s += word(rng, 2, 8); s += ' '; }
+        if (rng() % 8 == 0) {
+            const std::string& p = pats[rng() % pats.size()].text;
+            s.replace(rng() % (o.line_size - p.size()), p.size(), p);
+        }
+        s.resize(o.line_size);
+    }
+    return out;
+}
+
+// Referncia: cada padro procurado na linha inteira (em minsculas).
+void naive(const std::vector<filter::Matcher::Pattern>& pats, std::string& s, std::string& lower) {
+    lower = s;
+    for (char& ch : lower) if (ch >= 'A' && ch <= 'Z') ch = static_cast<char>(ch - 'A' + 'a');
+    for (auto& p : pats) {
+        for (size_t at = lower.find(p.text); at != std::string::npos; at = lower.find(p.text, at + 1)) {
+            std::fill_n(s.begin() + static_cast<std::ptrdiff_t>(at), p.text.size(), '*');
+        }
+    }
+}
+
+// ns por byte varrido; `fn` recebe uma cpia de cada linha, como no servidor.
+template <typename Fn>
+double ns_per_byte(const std::vector<std::string>& lines, Fn&& fn) {
+    using namespace std::chrono;
+    std::string work;
+    size_t bytes = 0;
+    const auto t0 = steady_clock::now();
+    do {
+        for (auto& l : lines) { work = l; fn(work); bytes += l.size(); }
+    } while (steady_clock::now() - t0 < milliseconds(200));
+    return double(duration_cast<nanoseconds>(steady_clock::now() - t0).count()) / double(bytes);
+}
+
+bool parse(int argc, char** argv, Options& o) {
+    try {
+        for (int i = 1; i < argc; ++i) {
+            std::string_view a = argv[i];
+            if (i + 1 >= argc) return false;
+            std::string v = argv[++i];
+            if      (a == "--lines")     o.lines     = std::stoul(v);
+            else if (a == "--line-size") o.line_size = std::stoul(v);
+            else if (a == "--patterns") {
+                o.patterns.clear();
+                size_t pos = 0;
+                while (pos <= v.size()) {
+                    size_t comma = v.find(',', pos);
+                    if (comma == std::string::npos) comma = v.size();
+                    const size_t n = std::stoul(v.substr(pos, comma - pos));
+                    if (n == 0) return false;
+                    o.patterns.push_back(n);
+                    pos = comma + 1;
+                }
+            } else return false;
+        }
+    } catch (const std::exception&) {
+        return false;
+    }
+    return o.lines > 0 && o.line_size >= 16 && !o.patterns.empty();
+}
+
+} // namespace
+
+int main(int argc, char** argv) {
+    Options opt;
+    if (!parse(argc, argv, opt)) {
+        std::cerr << "Uso: " << argv[0] << " [--patterns 1,10,100] [--lines n] [--line-size bytes]\n";
+        return 2;
+    }
+
+    std::printf("linhas de %zu bytes, ns/byte\n", opt.line_size);
+    std::printf("%10s %10s %10s %10s\n", "padres", "estados", "DFA", "find");
+    bool ok = true;
+    for (size_t n : opt.patterns) {
+        const auto pats  = make_patterns(n);
+        const auto lines = make_lines(opt, pats);
+        const filter::Matcher m(pats);
+
+        std::string a, b, lower;
+        for (auto& l : lines) {
+            a = l; m.apply(a);
+            b = l; naive(pats, b, lower);
+            ok = ok && a == b;
+        }
+        const double dfa  = ns_per_byte(lines, [&](std::string& s) { m.apply(s); });
+        const double find = ns_per_byte(lines, [&](std::string& s) { naive(pats, s, lower); });
+        std::printf("%10zu %10zu %10.2f %10.2f\n", n, m.states(), dfa, find);
+    }
+    if (!ok) std::cerr << "bench_filter: DFA e busca ingnua mascararam de forma diferente\n";
+    return ok ? 0 : 1;
+}
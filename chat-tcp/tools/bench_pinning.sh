@@ -0,0 +1,35 @@
+#!/usr/bin/env bash
+# Compara a latncia de fanout (chat_loadgen) com e sem afinidade de CPU.
+#
+# Uso: tools/bench_pinning.sh [dir_build] [cpu_loop] [cpus_io]
+#   ex.: tools/bench_pinning.sh build 2 4-7
+#
+# Cada rodada sobe um chat_server novo numa porta prpria. Sem afinidade, o
+# escalonador move a thread do loop e as do gerador entre ncleos; com
+# afinidade, o loop fica sozinho em `cpu_loop` e o gerador em `cpus_io`.
+set -euo pipefail
+
+BUILD=${1:-build}
+LOOP_CPU=${2:-0}
+IO_CPUS=${3:-1}
+LOADGEN_ARGS=${LOADGEN_ARGS:-"--conns 500 --threads 2 --senders 20 --rate 200 --size 128 --duration 5 --drain 1"}
+
+run() {
+    local label=$1 port=$2 server_cpu=$3 loadgen_cpu=$4
+    "$BUILD/chat_server" "$port" $server_cpu >/dev/null 2>&1 &
+    local pid=$!
+    sleep 0.5
+    local out
+    out=$("$BUILD/chat_loadgen" --port "$port" $LOADGEN_ARGS $loadgen_cpu 2>/dev/null)
+    kill -INT "$pid"; wait "$pid" || true
+    python3 - "$label" "$out" <<'EOF'
+import json, sys
+r = json.loads(sys.argv[2])
+l = r["latency_us"]
+print(f'{sys.argv[1]:<14} p50={l["p50"]:>9.1f}us  p99={l["p99"]:>9.1f}us  p999={l["p999"]:>9.1f}us  '
+      f'max={l["max"]:>9.1f}us  entrega={r["received"]["delivery_ratio"]:.3f}')
+EOF
+}
+
+run "sem afinidade" 7401 "" ""
+run "com afinidade" 7402 "--cpu loop=$LOOP_CPU" "--cpu io=$IO_CPUS"
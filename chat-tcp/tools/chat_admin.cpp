@@ -0,0 +1,81 @@
+// Cliente do socket de administrao do chat_server (--admin <caminho>).
+// Manda um comando por linha e imprime a resposta ("ok ..." / "erro: ...").
+//
+// Uso: ./chat_admin <caminho> [comando ...]
+//   sem comando: l comandos do stdin, um por linha
+// Ex.: ./chat_admin /tmp/chat.admin queue 4096
+//      ./chat_admin /tmp/chat.admin log level warn
+//      ./chat_admin /tmp/chat.admin drain
+#include <iostream>
+#include <string>
+#include <unistd.h>
+
+#include "common/net.hpp"
+
+namespace {
+
+// L at '\n' (inclusive); false se a conexo fechou antes.
+bool read_line(int fd, std::string& buf, std::string& line) {
+    for (;;) {
+        if (auto nl = buf.find('\n'); nl != std::string::npos) {
+            line = buf.substr(0, nl);
+            buf.erase(0, nl + 1);
+            return true;
+        }
+        char tmp[4096];
+        ssize_t n = ::read(fd, tmp, sizeof(tmp));
+        if (n <= 0) return false;
+        buf.append(tmp, static_cast<size_t>(n));
+    }
+}
+
+// Envia o comando e imprime a resposta; false se deu erro.
+bool run(int fd, std::string& buf, std::string cmd) {
+    cmd.push_back('\n');
+    if (send_all(fd, cmd.data(), cmd.size()) < 0) return false;
+    std::string reply;
+    if (!read_line(fd, buf, reply)) {
+        std::cerr << "chat_admin: conexo encerrada pelo servidor\n";
+        return false;
+    }
+    std::cout << reply << "\n";
+    return reply.starts_with("ok");
+}
+
+} // namespace
+
+int main(int argc, char** argv) {
+    if (argc < 2) {
+        std::cerr << "Uso: " << argv[0] << " <caminho> [comando ...]\n"
+                  << "Comandos: show | queue [controle|sistema|chat] <n> | weight <faixa> <n> | lanes | mem\n"
+                  << "          notice <texto> | kick <apelido|fd=N> [motivo] | history <n>\n"
+                  << "          log level <debug|info|warn|error>\n"
+                  << "          log stdout <on|off> | log file <caminho|off> | drain | flush\n"
+                  << "          filter show | filter reload [arquivo]\n";
+        return 2;
+    }
+    int fd = connect_unix(argv[1]);
+    if (fd < 0) {
+        std::cerr << "chat_admin: no foi possvel conectar a " << argv[1] << "\n";
+        return 1;
+    }
+
+    std::string buf;
+    bool ok = true;
+    if (argc > 2) {
+        std::string cmd;
+        for (int i = 2; i < argc; ++i) {
+            if (i > 2) cmd.push_back(' ');
+            cmd += argv[i];
+        }
+        ok = run(fd, buf, std::move(cmd));
+    } else {
+        std::string line;
+        while (std::getline(std::cin, line)) {
+            if (line.empty()) continue;
+            ok = run(fd, buf, line) && ok;
+        }
+    }
+    ::close(fd);
+    return ok ? 0 : 1;
+}
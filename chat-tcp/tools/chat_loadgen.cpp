@@ -0,0 +1,337 @@
+// Gerador de carga para o chat_server: abre muitas conexes a partir de
+// poucas threads (uma epoll por thread), envia mensagens com timestamp
+// embutido e mede a latncia de entrega do fanout em todos os receptores.
+// Resultado em JSON no stdout, para comparar builds do servidor.
+//
+// Uso: ./chat_loadgen [--host 127.0.0.1] [--port 5555] [--unix caminho] [--conns 1000]
+//                     [--threads 4] [--senders 10] [--rate 10] [--size 64]
+//                     [--duration 10] [--drain 2] [--cpu io=2-5]
+#include <algorithm>
+#include <atomic>
+#include <bit>
+#include <charconv>
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <iostream>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <vector>
+#include <cerrno>
+#include <unistd.h>
+#include <sys/epoll.h>
+#include <sys/resource.h>
+
+#include "common/net.hpp"
+#include "common/placement.hpp"
+
+namespace {
+
+struct Options {
+    std::string host     = "127.0.0.1";
+    uint16_t    port     = 5555;
+    std::string unix_path;       // no vazio: conecta por socket UNIX
+    int         conns    = 1000;
+    int         threads  = 4;
+    int         senders  = 10;   // conexes que enviam (as demais s recebem)
+    double      rate     = 10;   // mensagens/s por conexo emissora
+    size_t      size     = 64;   // bytes por mensagem (incluindo '\n')
+    double      duration = 10;   // segundos de envio
+    double      drain    = 2;    // segundos extras s recebendo
+    placement::Plan cpus;        // --cpu io=<lista>: uma CPU por thread
+};
+
+int64_t mono_ns() {
+    using namespace std::chrono;
+    return duration_cast<nanoseconds>(steady_clock::now().time_since_epoch()).count();
+}
+
+// Histograma log-linear (~1,5% de preciso) para latncias em ns.
+class Histogram {
+public:
+    Histogram() : b_(kExact + 58 * kSub, 0) {}
+
+    void add(uint64_t v) { ++b_[index(v)]; ++n_; sum_ += v; max_ = std::max(max_, v); min_ = std::min(min_, v); }
+    void merge(const Histogram& o) {
+        for (size_t i = 0; i < b_.size(); ++i) b_[i] += o.b_[i];
+        n_ += o.n_; sum_ += o.sum_; max_ = std::max(max_, o.max_); min_ = std::min(min_, o.min_);
+    }
+    uint64_t count() const { return n_; }
+    uint64_t max()   const { return max_; }
+    uint64_t min()   const { return n_ ? min_ : 0; }
+    double   mean()  const { return n_ ? double(sum_) / double(n_) : 0.0; }
+    uint64_t percentile(double p) const {
+        if (!n_) return 0;
+        uint64_t rank = static_cast<uint64_t>(p * double(n_ - 1)) + 1, acc = 0;
+        for (size_t i = 0; i < b_.size(); ++i) {
+            acc += b_[i];
+            if (acc >= rank) return std::min(value(i), max_);
+        }
+        return max_;
+    }
+
+private:
+    static constexpr int kSubBits = 6;
+    static constexpr uint64_t kSub = 1u << kSubBits;    // sub-buckets por potncia de 2
+    static constexpr uint64_t kExact = 2 * kSub;        // valores < kExact so exatos
+
+    std::vector<uint64_t> b_;
+    uint64_t n_ = 0, sum_ = 0, max_ = 0, min_ = UINT64_MAX;
+
+    static size_t index(uint64_t v) {
+        if (v < kExact) return v;
+        int g = (63 - std::countl_zero(v)) - kSubBits;  // >= 1
+        return kExact + (g - 1) * kSub + ((v >> g) - kSub);
+    }
+    static uint64_t value(size_t i) {
+        if (i < kExact) return i;
+        int g = int((i - kExact) / kSub) + 1;
+        uint64_t sub = (i - kExact) % kSub + kSub;
+        return (sub << g) + (uint64_t(1) << g) / 2;
+    }
+};
+
+struct Conn {
+    int         fd = -1;
+    bool        sender = false;
+    bool        alive = true;
+    uint64_t    seq = 0;
+    std::string in;
+    std::string out;
+};
+
+// Alinhado  linha de cache: os contadores de cada thread no
+// compartilham linha com os da thread vizinha no vetor.
+struct alignas(placement::kCacheLine) Worker {
+    int               id = 0;
+    std::vector<Conn> conns;
+    Histogram         hist;
+    uint64_t connect_failed = 0, disconnects = 0;
+    uint64_t sent_msgs = 0, sent_bytes = 0, send_backlogged = 0;
+    uint64_t recv_msgs = 0, recv_bytes = 0;
+};
+
+std::atomic<int64_t> g_send_start{0}, g_send_end{0}, g_stop_at{0};
+
+// Mensagem: "LG <ts_ns> <worker>:<conn>:<seq> xxx...\n" com `size` bytes
+void make_msg(std::string& out, size_t size, int wid, size_t ci, uint64_t seq) {
+    char head[96];
+    int n = std::snprintf(head, sizeof(head), "LG %lld %d:%zu:%llu ",
+                          (long long)mono_ns(), wid, ci, (unsigned long long)seq);
+    out.append(head, n);
+    if (size > static_cast<size_t>(n) + 1) out.append(size - n - 1, 'x');
+    out += '\n';
+}
+
+void on_line(Worker& w, std::string_view line, int64_t now) {
+    ++w.recv_msgs;
+    w.recv_bytes += line.size() + 1;
+    if (!line.starts_with("LG ")) return; // histrico ou trfego de terceiros
+    int64_t ts = 0;
+    auto [p, ec] = std::from_chars(line.data() + 3, line.data() + line.size(), ts);
+    if (ec != std::errc{} || ts < g_send_start.load(std::memory_order_relaxed)) return;
+    w.hist.add(static_cast<uint64_t>(std::max<int64_t>(now - ts, 0)));
+}
+
+void kill_conn(Worker& w, int ep, Conn& c) {
+    if (!c.alive) return;
+    c.alive = false;
+    ++w.disconnects;
+    ::epoll_ctl(ep, EPOLL_CTL_DEL, c.fd, nullptr);
+    ::close(c.fd);
+}
+
+void flush(Worker& w, int ep, Conn& c) {
+    while (c.alive && !c.out.empty()) {
+        ssize_t n = ::send(c.fd, c.out.data(), c.out.size(), MSG_NOSIGNAL | MSG_DONTWAIT);
+        if (n > 0) { w.sent_bytes += n; c.out.erase(0, n); continue; }
+        if (n < 0 && errno == EINTR) continue;
+        if (n < 0 && (errno == EAGAIN || errno == EWOULDBLOCK)) return;
+        kill_conn(w, ep, c);
+    }
+}
+
+void run_worker(Worker& w, const Options& opt) {
+    // Fixa antes de alocar: histograma e buffers ficam no n NUMA local
+    const std::string name = "loadgen-io-" + std::to_string(w.id);
+    placement::pin_worker(opt.cpus, placement::Role::Io, static_cast<size_t>(w.id), name.c_str());
+    w.hist = Histogram();
+    for (auto& c : w.conns) { c.in.reserve(2 * opt.size); c.out.reserve(4 * opt.size); }
+
+    int ep = ::epoll_create1(EPOLL_CLOEXEC);
+    for (size_t i = 0; i < w.conns.size(); ++i) {
+        auto& c = w.conns[i];
+        if (c.fd < 0) continue;
+        epoll_event ev{};
+        ev.events = EPOLLIN | EPOLLOUT | EPOLLRDHUP | EPOLLET;
+        ev.data.u64 = i;
+        ::epoll_ctl(ep, EPOLL_CTL_ADD, c.fd, &ev);
+    }
+
+    const int64_t start = g_send_start.load(), send_end = g_send_end.load(), stop = g_stop_at.load();
+    const int64_t interval = opt.rate > 0 ? static_cast<int64_t>(1e9 / opt.rate) : 0;
+    epoll_event evs[256];
+    char buf[64 * 1024];
+
+    for (;;) {
+        int64_t now = mono_ns();
+        if (now >= stop) break;
+
+        // Envios vencidos (ritmo fixo por emissor)
+        if (interval > 0 && now >= start && now < send_end) {
+            for (size_t i = 0; i < w.conns.size(); ++i) {
+                auto& c = w.conns[i];
+                if (!c.alive || !c.sender) continue;
+                uint64_t due = static_cast<uint64_t>((now - start) / interval) + 1;
+                while (c.seq < due) {
+                    if (c.out.size() > 64 * 1024) { w.send_backlogged += due - c.seq; c.seq = due; break; }
+                    make_msg(c.out, opt.size, w.id, i, c.seq++);
+                    ++w.sent_msgs;
+                }
+                flush(w, ep, c);
+            }
+        }
+
+        int n = ::epoll_wait(ep, evs, 256, 1);
+        now = mono_ns();
+        for (int k = 0; k < n; ++k) {
+            auto& c = w.conns[evs[k].data.u64];
+            if (!c.alive) continue;
+            if (evs[k].events & EPOLLOUT) flush(w, ep, c);
+            for (;;) {
+                ssize_t r = ::recv(c.fd, buf, sizeof(buf), 0);
+                if (r > 0) {
+                    c.in.append(buf, r);
+                    size_t pos, off = 0;
+                    while ((pos = c.in.find('\n', off)) != std::string::npos) {
+                        on_line(w, std::string_view(c.in).substr(off, pos - off), now);
+                        off = pos + 1;
+                    }
+                    c.in.erase(0, off);
+                    continue;
+                }
+                if (r < 0 && errno == EINTR) continue;
+                if (r < 0 && (errno == EAGAIN || errno == EWOULDBLOCK)) break;
+                kill_conn(w, ep, c); // r == 0 ou erro
+                break;
+            }
+        }
+    }
+    for (auto& c : w.conns) if (c.alive) ::close(c.fd);
+    ::close(ep);
+}
+
+bool parse(int argc, char** argv, Options& o) {
+    try {
+        for (int i = 1; i < argc; ++i) {
+            std::string_view a = argv[i];
+            if (i + 1 >= argc) return false;
+            std::string v = argv[++i];
+            if      (a == "--host")     o.host = v;
+            else if (a == "--port")     o.port = static_cast<uint16_t>(std::stoi(v));
+            else if (a == "--unix")     o.unix_path = v;
+            else if (a == "--conns")    o.conns = std::stoi(v);
+            else if (a == "--threads")  o.threads = std::stoi(v);
+            else if (a == "--senders")  o.senders = std::stoi(v);
+            else if (a == "--rate")     o.rate = std::stod(v);
+            else if (a == "--size")     o.size = std::stoul(v);
+            else if (a == "--duration") o.duration = std::stod(v);
+            else if (a == "--drain")    o.drain = std::stod(v);
+            else if (a == "--cpu")      { if (!placement::parse_assignment(v, o.cpus)) return false; }
+            else return false;
+        }
+    } catch (const std::exception&) {
+        return false;
+    }
+    return o.conns > 0 && o.threads > 0 && o.senders >= 0 && o.size >= 32;
+}
+
+} // namespace
+
+int main(int argc, char** argv) {
+    Options opt;
+    if (!parse(argc, argv, opt)) {
+        std::cerr << "Uso: " << argv[0] << " [--host h] [--port p] [--unix caminho] [--conns n] [--threads t]"
+                  << " [--senders s] [--rate msgs/s] [--size bytes] [--duration s] [--drain s]"
+                  << " [--cpu io=<cpus>]\n";
+        return 2;
+    }
+    opt.threads = std::min(opt.threads, opt.conns);
+    opt.senders = std::min(opt.senders, opt.conns);
+
+    // Milhares de conexes: sobe o limite de descritores at o mximo permitido
+    rlimit rl{};
+    if (::getrlimit(RLIMIT_NOFILE, &rl) == 0 && rl.rlim_cur < rl.rlim_max) {
+        rl.rlim_cur = rl.rlim_max;
+        ::setrlimit(RLIMIT_NOFILE, &rl);
+    }
+
+    // Conecta tudo antes de comear a medir (round-robin entre as threads)
+    std::vector<Worker> workers(opt.threads);
+    for (int t = 0; t < opt.threads; ++t) workers[t].id = t;
+    const int64_t t_conn0 = mono_ns();
+    for (int i = 0; i < opt.conns; ++i) {
+        auto& w = workers[i % opt.threads];
+        Conn c;
+        c.fd = opt.unix_path.empty() ? connect_to(opt.host, opt.port) : connect_unix(opt.unix_path);
+        if (c.fd < 0 || !set_nonblocking(c.fd)) {
+            if (c.fd >= 0) ::close(c.fd);
+            ++w.connect_failed;
+            continue;
+        }
+        c.sender = i < opt.senders;
+        w.conns.push_back(std::move(c));
+    }
+    const double connect_s = double(mono_ns() - t_conn0) / 1e9;
+    std::cerr << "chat_loadgen: " << opt.conns << " conexes em " << connect_s << "s, medindo...\n";
+
+    g_send_start = mono_ns() + 200'000'000; // folga para o histrico chegar
+    g_send_end   = g_send_start + static_cast<int64_t>(opt.duration * 1e9);
+    g_stop_at    = g_send_end + static_cast<int64_t>(opt.drain * 1e9);
+
+    std::vector<std::thread> th;
+    for (auto& w : workers) th.emplace_back(run_worker, std::ref(w), std::cref(opt));
+    for (auto& t : th) t.join();
+
+    Histogram hist;
+    uint64_t established = 0, failed = 0, disc = 0, sent = 0, sent_b = 0, backlog = 0, recv = 0, recv_b = 0;
+    for (auto& w : workers) {
+        hist.merge(w.hist);
+        established += w.conns.size();
+        failed += w.connect_failed; disc += w.disconnects;
+        sent += w.sent_msgs; sent_b += w.sent_bytes; backlog += w.send_backlogged;
+        recv += w.recv_msgs; recv_b += w.recv_bytes;
+    }
+    const double send_s  = opt.duration;
+    const double total_s = opt.duration + opt.drain;
+    const double expected = double(sent) * double(established);
+    auto us = [](uint64_t ns) { return double(ns) / 1000.0; };
+
+    std::cout.setf(std::ios::fixed);
+    std::cout.precision(3);
+    std::cout << "{\n"
+              << "  \"config\": {\"host\": \"" << opt.host << "\", \"port\": " << opt.port
+              << ", \"unix\": \"" << opt.unix_path << "\""
+              << ", \"conns\": " << opt.conns << ", \"threads\": " << opt.threads
+              << ", \"senders\": " << opt.senders << ", \"rate_per_sender\": " << opt.rate
+              << ", \"size\": " << opt.size << ", \"duration_s\": " << opt.duration
+              << ", \"drain_s\": " << opt.drain
+              << ", \"cpus\": \"" << placement::describe(opt.cpus) << "\"},\n"
+              << "  \"connections\": {\"established\": " << established << ", \"failed\": " << failed
+              << ", \"disconnects\": " << disc << ", \"connect_time_s\": " << connect_s << "},\n"
+              << "  \"sent\": {\"messages\": " << sent << ", \"bytes\": " << sent_b
+              << ", \"backlogged\": " << backlog << ", \"msgs_per_s\": " << double(sent) / send_s << "},\n"
+              << "  \"received\": {\"messages\": " << recv << ", \"bytes\": " << recv_b
+              << ", \"timed\": " << hist.count()
+              << ", \"msgs_per_s\": " << double(recv) / total_s
+              << ", \"mb_per_s\": " << double(recv_b) / total_s / 1e6
+              << ", \"delivery_ratio\": " << (expected > 0 ? double(hist.count()) / expected : 0.0) << "},\n"
+              << "  \"latency_us\": {\"min\": " << us(hist.min()) << ", \"mean\": " << hist.mean() / 1000.0
+              << ", \"p50\": " << us(hist.percentile(0.50)) << ", \"p90\": " << us(hist.percentile(0.90))
+              << ", \"p99\": " << us(hist.percentile(0.99)) << ", \"p999\": " << us(hist.percentile(0.999))
+              << ", \"max\": " << us(hist.max()) << "}\n"
+              << "}\n";
+    return 0;
+}
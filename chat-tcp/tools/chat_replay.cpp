@@ -0,0 +1,338 @@
+// Reproduz contra um chat_server o trfego gravado com --capture: as mesmas
+// conexes, linhas e desconexes, na mesma ordem, no ritmo original (ou
+// acelerado por --speed) ou o mais rpido possvel (--max; a as
+// desconexes ficam para o fim, seno as sesses sairiam antes de receber
+// o fanout). O payload de um anexo ("/file") no  gravado, s o tamanho:
+// vai como enchimento do mesmo tamanho, para a sesso seguir em fase com
+// o servidor. Cada sesso gravada vira uma conexo; todas tambm recebem, e
+// a latncia de entrega  medida pelo texto das linhas. Ficam fora da
+// amostra as linhas repetidas na captura (ambguas) e as enviadas antes de
+// a sesso entrar (chegam pelo replay do histrico). Resultado em JSON no
+// stdout, para comparar builds do servidor com o mesmo incidente.
+//
+// Uso: ./chat_replay <captura> [--host 127.0.0.1] [--port 5555] [--unix caminho]
+//                    [--speed 1.0] [--max] [--drain 2] [--stats]
+//   --stats: s resume a captura, sem conectar
+#include <algorithm>
+#include <chrono>
+#include <csignal>
+#include <cstdint>
+#include <functional>
+#include <iostream>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+#include <cerrno>
+#include <unistd.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <sys/epoll.h>
+#include <sys/socket.h>
+
+#include "common/capture.hpp"
+#include "common/net.hpp"
+
+namespace {
+
+struct Options {
+    std::string path;
+    std::string host = "127.0.0.1";
+    uint16_t    port = 5555;
+    std::string unix_path;
+    double      speed = 1.0;
+    bool        max   = false; // ignora os intervalos gravados
+    double      drain = 2;     // segundos s recebendo, no fim
+    bool        stats = false;
+};
+
+int64_t mono_ns() {
+    using namespace std::chrono;
+    return duration_cast<nanoseconds>(steady_clock::now().time_since_epoch()).count();
+}
+
+struct Conn {
+    int         fd = -1;
+    std::string in;            // bytes recebidos ainda sem '\n'
+    std::string out;           // o que o socket ainda no aceitou
+    bool        closing = false; // desconexo gravada: fecha ao esvaziar `out`
+    int64_t     joined  = 0;     // incio da conexo (ns)
+};
+
+// Momento do envio de cada texto; count > 1 = texto repetido (ambguo)
+struct Sent {
+    int64_t  ns;
+    uint32_t count;
+};
+
+struct Totals {
+    uint64_t sessions = 0, lines = 0, bytes = 0, disconnects = 0;
+    uint64_t payloads = 0, payload_bytes = 0;
+    uint64_t connect_failures = 0, orphan_lines = 0;
+    uint64_t rx_lines = 0, rx_bytes = 0, dropped_conns = 0;
+    int64_t  last_rx_ns = 0; // ltima linha recebida
+};
+
+class Replayer {
+public:
+    explicit Replayer(const Options& o) : opt_(o), ep_(::epoll_create1(EPOLL_CLOEXEC)) {}
+    ~Replayer() {
+        for (auto& [id, c] : conns_) ::close(c.fd);
+        ::close(ep_);
+    }
+
+    void connect(uint64_t session) {
+        int fd = opt_.unix_path.empty() ? connect_to(opt_.host, opt_.port) : connect_unix(opt_.unix_path);
+        if (fd < 0) { ++t_.connect_failures; return; }
+        int one = 1;
+        if (opt_.unix_path.empty()) ::setsockopt(fd, IPPROTO_TCP, TCP_NODELAY, &one, sizeof(one));
+        set_nonblocking(fd);
+        epoll_event ev{};
+        ev.events   = EPOLLIN;
+        ev.data.u64 = session;
+        ::epoll_ctl(ep_, EPOLL_CTL_ADD, fd, &ev);
+        conns_[session] = Conn{fd, {}, {}, false, mono_ns()};
+        ++t_.sessions;
+    }
+
+    void line(uint64_t session, const std::string& text) {
+        auto it = conns_.find(session);
+        if (it == conns_.end()) { ++t_.orphan_lines; return; }
+        auto [s, fresh] = sent_.try_emplace(text, Sent{mono_ns(), 1});
+        if (!fresh) ++s->second.count;
+        ++t_.lines;
+        t_.bytes += text.size() + 1;
+        Conn& c = it->second;
+        c.out.append(text).push_back('\n');
+        flush(session, c);
+    }
+
+    // Enchimento no lugar dos bytes de um anexo (s o tamanho foi gravado).
+    void payload(uint64_t session, uint64_t size) {
+        auto it = conns_.find(session);
+        if (it == conns_.end()) return;
+        ++t_.payloads;
+        t_.payload_bytes += size;
+        Conn& c = it->second;
+        c.out.append(size, 'x');
+        flush(session, c);
+    }
+
+    void disconnect(uint64_t session) {
+        if (opt_.max && !finishing_) { deferred_.push_back(session); return; }
+        auto it = conns_.find(session);
+        if (it == conns_.end()) return;
+        ++t_.disconnects;
+        it->second.closing = true;
+        if (it->second.out.empty()) close(it);
+    }
+
+    // Processa envios pendentes e recepes por at `timeout_ms`.
+    void pump(int timeout_ms) {
+        epoll_event evs[256];
+        const int n = ::epoll_wait(ep_, evs, 256, timeout_ms);
+        char buf[65536];
+        for (int k = 0; k < n; ++k) {
+            const uint64_t id = evs[k].data.u64;
+            auto it = conns_.find(id);
+            if (it == conns_.end()) continue;
+            Conn& c = it->second;
+            if (evs[k].events & EPOLLOUT) flush(id, c);
+            if (!(evs[k].events & (EPOLLIN | EPOLLHUP | EPOLLERR))) {
+                if (c.closing && c.out.empty()) close(it);
+                continue;
+            }
+            bool eof = false;
+            for (;;) {
+                ssize_t r = ::recv(c.fd, buf, sizeof(buf), 0);
+                if (r > 0) { c.in.append(buf, static_cast<size_t>(r)); t_.rx_bytes += r; continue; }
+                if (r < 0 && errno == EINTR) continue;
+                eof = r == 0 || (errno != EAGAIN && errno != EWOULDBLOCK);
+                break;
+            }
+            received(c);
+            if (eof) { ++t_.dropped_conns; close(it); }
+            else if (c.closing && c.out.empty()) close(it);
+        }
+    }
+
+    // Aplica as desconexes adiadas pelo --max.
+    void finish() {
+        auto pending = std::move(deferred_);
+        finishing_ = true;
+        for (uint64_t s : pending) disconnect(s);
+    }
+
+    const Totals& totals() const { return t_; }
+    std::vector<uint32_t>& latencies() { return lat_us_; }
+
+private:
+    using Map = std::unordered_map<uint64_t, Conn>;
+
+    const Options&                         opt_;
+    int                                    ep_;
+    Map                                    conns_;   // sesso gravada -> conexo
+    std::unordered_map<std::string, Sent>  sent_;
+    std::vector<uint32_t>                  lat_us_;
+    std::vector<uint64_t>                  deferred_;  // desconexes adiadas (--max)
+    bool                                   finishing_ = false;
+    Totals                                 t_;
+
+    void flush(uint64_t id, Conn& c) {
+        size_t off = 0;
+        while (off < c.out.size()) {
+            ssize_t n = ::send(c.fd, c.out.data() + off, c.out.size() - off, MSG_NOSIGNAL);
+            if (n > 0) { off += static_cast<size_t>(n); continue; }
+            if (n < 0 && errno == EINTR) continue;
+            break; // EAGAIN (o servidor segura o cliente) ou erro: tenta no EPOLLOUT
+        }
+        c.out.erase(0, off);
+        epoll_event ev{};
+        ev.events   = EPOLLIN | (c.out.empty() ? 0u : static_cast<uint32_t>(EPOLLOUT));
+        ev.data.u64 = id;
+        ::epoll_ctl(ep_, EPOLL_CTL_MOD, c.fd, &ev);
+    }
+
+    void received(Conn& c) {
+        const int64_t now = mono_ns();
+        size_t start = 0;
+        for (size_t nl; (nl = c.in.find('\n', start)) != std::string::npos; start = nl + 1) {
+            ++t_.rx_lines;
+            t_.last_rx_ns = now;
+            // O broadcast  a linha original: acha o envio pelo texto
+            auto it = sent_.find(c.in.substr(start, nl - start));
+            if (it != sent_.end() && it->second.count == 1 && it->second.ns >= c.joined) {
+                lat_us_.push_back(static_cast<uint32_t>((now - it->second.ns) / 1000));
+            }
+        }
+        c.in.erase(0, start);
+    }
+
+    void close(Map::iterator it) {
+        ::close(it->second.fd);
+        conns_.erase(it);
+    }
+};
+
+// S o resumo da captura.
+int print_stats(const Options& o) {
+    capture::Reader r;
+    if (!r.open(o.path)) { std::cerr << "Captura invlida: " << o.path << "\n"; return 1; }
+    capture::Event ev;
+    uint64_t connects = 0, lines = 0, bytes = 0, disconnects = 0, open = 0, peak = 0;
+    uint64_t payloads = 0, payload_bytes = 0;
+    int64_t last = r.start_us();
+    while (r.next(ev)) {
+        last = ev.ts_us;
+        switch (ev.kind) {
+        case capture::Kind::Connect:    ++connects; peak = std::max(peak, ++open); break;
+        case capture::Kind::Line:       ++lines; bytes += ev.text.size() + 1; break;
+        case capture::Kind::Disconnect: ++disconnects; if (open) --open; break;
+        case capture::Kind::Payload:    ++payloads; payload_bytes += ev.size; break;
+        }
+    }
+    std::cout << "{\"capture\": \"" << o.path << "\", \"sessions\": " << connects << ", \"lines\": " << lines
+              << ", \"bytes\": " << bytes << ", \"payloads\": " << payloads << ", \"payload_bytes\": " << payload_bytes
+              << ", \"disconnects\": " << disconnects
+              << ", \"peak_sessions\": " << peak
+              << ", \"duration_s\": " << double(last - r.start_us()) / 1e6 << "}\n";
+    return 0;
+}
+
+bool parse(int argc, char** argv, Options& o) {
+    try {
+        for (int i = 1; i < argc; ++i) {
+            std::string_view a = argv[i];
+            if (a == "--max")   { o.max = true; continue; }
+            if (a == "--stats") { o.stats = true; continue; }
+            if (!a.starts_with("--")) {
+                if (!o.path.empty()) return false;
+                o.path = a;
+                continue;
+            }
+            if (i + 1 >= argc) return false;
+            std::string v = argv[++i];
+            if      (a == "--host")  o.host = v;
+            else if (a == "--port")  o.port = static_cast<uint16_t>(std::stoi(v));
+            else if (a == "--unix")  o.unix_path = v;
+            else if (a == "--speed") o.speed = std::stod(v);
+            else if (a == "--drain") o.drain = std::stod(v);
+            else return false;
+        }
+    } catch (const std::exception&) {
+        return false;
+    }
+    return !o.path.empty() && o.speed > 0;
+}
+
+} // namespace
+
+int main(int argc, char** argv) {
+    Options opt;
+    if (!parse(argc, argv, opt)) {
+        std::cerr << "Uso: " << argv[0] << " <captura> [--host h] [--port p] [--unix caminho]"
+                  << " [--speed x] [--max] [--drain s] [--stats]\n";
+        return 2;
+    }
+    if (opt.stats) return print_stats(opt);
+    std::signal(SIGPIPE, SIG_IGN);
+
+    capture::Reader reader;
+    if (!reader.open(opt.path)) {
+        std::cerr << "Captura invlida: " << opt.path << "\n";
+        return 1;
+    }
+
+    Replayer rp(opt);
+    capture::Event ev;
+    const int64_t t0 = mono_ns();
+    uint64_t events = 0;
+    while (reader.next(ev)) {
+        if (opt.max) {
+            // Sem esperar, mas sem deixar as recepes acumularem
+            if ((++events & 63) == 0) rp.pump(0);
+        } else {
+            const int64_t due = t0 + static_cast<int64_t>(double(ev.ts_us - reader.start_us()) * 1000 / opt.speed);
+            for (int64_t now; (now = mono_ns()) < due;) rp.pump(static_cast<int>((due - now) / 1'000'000));
+        }
+        switch (ev.kind) {
+        case capture::Kind::Connect:    rp.connect(ev.session); break;
+        case capture::Kind::Line:       rp.line(ev.session, ev.text); break;
+        case capture::Kind::Disconnect: rp.disconnect(ev.session); break;
+        case capture::Kind::Payload:    rp.payload(ev.session, ev.size); break;
+        }
+    }
+    const double send_s = double(mono_ns() - t0) / 1e9;
+    const int64_t end = mono_ns() + static_cast<int64_t>(opt.drain * 1e9);
+    for (int64_t now; (now = mono_ns()) < end;) rp.pump(static_cast<int>(std::max<int64_t>(1, (end - now) / 1'000'000)));
+    rp.finish();
+    // Do incio at a ltima linha recebida: com --max, a vazo do servidor
+    const int64_t last_rx = rp.totals().last_rx_ns;
+    const double  rx_s    = last_rx > t0 ? double(last_rx - t0) / 1e9 : 0.0;
+
+    const Totals& t = rp.totals();
+    auto& lat = rp.latencies();
+    std::sort(lat.begin(), lat.end());
+    auto pct = [&](double p) { return lat.empty() ? 0u : lat[static_cast<size_t>(p * double(lat.size() - 1))]; };
+
+    std::cout.setf(std::ios::fixed);
+    std::cout.precision(3);
+    std::cout << "{\n"
+              << "  \"config\": {\"capture\": \"" << opt.path << "\", \"target\": \""
+              << (opt.unix_path.empty() ? opt.host + ":" + std::to_string(opt.port) : opt.unix_path)
+              << "\", \"speed\": " << (opt.max ? std::string("\"max\"") : std::to_string(opt.speed)) << "},\n"
+              << "  \"replay\": {\"sessions\": " << t.sessions << ", \"lines\": " << t.lines
+              << ", \"bytes\": " << t.bytes << ", \"payloads\": " << t.payloads
+              << ", \"payload_bytes\": " << t.payload_bytes << ", \"disconnects\": " << t.disconnects
+              << ", \"connect_failures\": " << t.connect_failures << ", \"orphan_lines\": " << t.orphan_lines
+              << ", \"send_s\": " << send_s << ", \"lines_per_s\": " << (send_s > 0 ? double(t.lines) / send_s : 0.0)
+              << "},\n"
+              << "  \"received\": {\"lines\": " << t.rx_lines << ", \"bytes\": " << t.rx_bytes
+              << ", \"dropped_conns\": " << t.dropped_conns << ", \"rx_s\": " << rx_s
+              << ", \"lines_per_s\": " << (rx_s > 0 ? double(t.rx_lines) / rx_s : 0.0) << "},\n"
+              << "  \"latency_us\": {\"samples\": " << lat.size() << ", \"p50\": " << pct(0.5)
+              << ", \"p99\": " << pct(0.99) << ", \"p999\": " << pct(0.999)
+              << ", \"max\": " << (lat.empty() ? 0u : lat.back()) << "}\n"
+              << "}\n";
+    return t.connect_failures ? 1 : 0;
+}
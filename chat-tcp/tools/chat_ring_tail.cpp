@@ -0,0 +1,75 @@
+// Consumidor de teste do anel em memria compartilhada (chat_server --shm).
+// Imprime cada mensagem publicada ou, com --stats, s a taxa por segundo e
+// quantas voltas o leitor perdeu (lento demais para o produtor).
+//
+// Uso: ./chat_ring_tail <nome> [--stats] [--seq]
+//   ex.: ./chat_server 5555 --shm /chat-5555 & ./chat_ring_tail /chat-5555
+#include <chrono>
+#include <cstdio>
+#include <iostream>
+#include <string>
+#include <string_view>
+#include <csignal>
+
+#include <chatring.hpp>
+
+namespace {
+volatile std::sig_atomic_t g_stop = 0;
+void on_signal(int) { g_stop = 1; }
+}
+
+int main(int argc, char** argv) {
+    std::string name;
+    bool stats = false, show_seq = false;
+    for (int i = 1; i < argc; ++i) {
+        std::string_view a = argv[i];
+        if      (a == "--stats") stats = true;
+        else if (a == "--seq")   show_seq = true;
+        else if (name.empty() && !a.starts_with("--")) name = a;
+        else name.clear(), i = argc;
+    }
+    if (name.empty()) {
+        std::cerr << "Uso: " << argv[0] << " <nome> [--stats] [--seq]\n";
+        return 2;
+    }
+
+    chatring::Reader ring;
+    if (!ring.open(name)) {
+        std::cerr << "Falha ao abrir o anel " << name << " (o servidor est rodando com --shm?)\n";
+        return 1;
+    }
+    std::signal(SIGINT, on_signal);
+    std::signal(SIGTERM, on_signal);
+    std::cerr << "chat_ring_tail: " << name << " (" << ring.capacity() / 1024 << " KiB)\n";
+
+    using clock = std::chrono::steady_clock;
+    auto next_report = clock::now() + std::chrono::seconds(1);
+    uint64_t msgs = 0, bytes = 0, total = 0;
+    std::string payload;
+    uint64_t seq = 0;
+    while (!g_stop) {
+        const auto st = ring.next(payload, seq);
+        if (st == chatring::Reader::Status::Ok) {
+            ++msgs; ++total; bytes += payload.size();
+            if (!stats) {
+                if (show_seq) std::printf("#%llu ", static_cast<unsigned long long>(seq));
+                std::fwrite(payload.data(), 1, payload.size(), stdout);
+            }
+        } else if (st == chatring::Reader::Status::Lapped) {
+            if (!stats) std::fprintf(stderr, "chat_ring_tail: leitor ultrapassado, retomando\n");
+        } else {
+            if (!stats) std::fflush(stdout);
+            ring.wait(stats ? 200 : 1000);
+        }
+        if (stats && (st != chatring::Reader::Status::Ok || (msgs & 1023) == 0) && clock::now() >= next_report) {
+            std::fprintf(stderr, "%llu msgs/s, %.2f MB/s, %llu voltas perdidas\n",
+                         static_cast<unsigned long long>(msgs), double(bytes) / 1e6,
+                         static_cast<unsigned long long>(ring.lost()));
+            msgs = bytes = 0;
+            next_report = clock::now() + std::chrono::seconds(1);
+        }
+    }
+    std::fflush(stdout);
+    std::cerr << "chat_ring_tail: " << total << " mensagens, " << ring.lost() << " voltas perdidas\n";
+    return 0;
+}
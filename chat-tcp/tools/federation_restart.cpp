@@ -0,0 +1,248 @@
+// Teste de federao com reincio de n (ctest -R federation_restart).
+//
+// Sobe dois chat_server em portas efmeras de loopback: B aceita peers e A
+// disca B. Um cliente em A precisa ver as linhas enviadas a B; depois B 
+// reiniciado com o mesmo --node (a sequncia dele volta ao zero) e as
+// linhas novas de B tambm precisam chegar a A. Sem a epoch no id das
+// mensagens (ver server/Federation.hpp), A as tomaria por duplicatas das
+// linhas de antes do reincio e as descartaria.
+//
+// Um segundo cliente em A usa a numerao da retomada ("/since"). As linhas
+// que B recebeu antes de A voltar a disc-lo chegam a A pelo merge de
+// histrico; a sesso numerada precisa receb-las tambm, e uma retomada
+// a partir do maior nmero visto no pode repetir nem pular nada.
+//
+// Uso: ./federation_restart --server <chat_server>
+#include <algorithm>
+#include <chrono>
+#include <csignal>
+#include <cstdint>
+#include <cstdlib>
+#include <filesystem>
+#include <iostream>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <vector>
+#include <fcntl.h>
+#include <poll.h>
+#include <unistd.h>
+#include <netinet/in.h>
+#include <sys/socket.h>
+#include <sys/wait.h>
+
+#include "common/net.hpp"
+
+namespace {
+
+constexpr int kBefore = 50; // linhas antes do reincio (seq 1..50 em B)
+
+// --------- Servidores (processos filhos) ----------
+struct Node {
+    pid_t                    pid = -1;
+    uint16_t                 port = 0;
+    std::filesystem::path    dir;
+    std::vector<std::string> args;
+};
+
+std::vector<Node*> g_nodes; // encerrados tambm quando o teste falha
+
+void stop_node(Node& n) {
+    if (n.pid > 0) {
+        ::kill(n.pid, SIGINT);
+        ::waitpid(n.pid, nullptr, 0);
+        n.pid = -1;
+    }
+}
+
+[[noreturn]] void fail(const std::string& why) {
+    std::cerr << "federation_restart: " << why << "\n";
+    for (Node* n : g_nodes) {
+        stop_node(*n);
+        std::error_code ec;
+        if (!n->dir.empty()) std::filesystem::remove_all(n->dir, ec);
+    }
+    std::exit(1);
+}
+
+uint16_t free_port() {
+    int fd = make_server_socket(0);
+    sockaddr_in addr{};
+    socklen_t len = sizeof(addr);
+    if (fd < 0 || ::getsockname(fd, (sockaddr*)&addr, &len) < 0) fail("sem porta livre");
+    ::close(fd);
+    return ntohs(addr.sin_port);
+}
+
+void start_node(Node& n, const std::string& bin) {
+    if (n.dir.empty()) {
+        char tmpl[] = "/tmp/federation_restart.XXXXXX";
+        if (!::mkdtemp(tmpl)) fail("mkdtemp falhou");
+        n.dir = tmpl;
+    }
+    const std::string exe = std::filesystem::absolute(bin).string(); // o filho muda de diretrio
+
+    n.pid = ::fork();
+    if (n.pid < 0) fail("fork falhou");
+    if (n.pid == 0) {
+        if (::chdir(n.dir.c_str()) != 0) ::_exit(127);
+        int null = ::open("/dev/null", O_WRONLY);
+        ::dup2(null, STDOUT_FILENO);
+        ::dup2(null, STDERR_FILENO);
+        std::vector<char*> argv{const_cast<char*>(exe.c_str())};
+        for (auto& a : n.args) argv.push_back(a.data());
+        argv.push_back(nullptr);
+        ::execv(exe.c_str(), argv.data());
+        ::_exit(127);
+    }
+    // Pronto quando aceita conexes
+    for (int i = 0; i < 300; ++i) {
+        if (int fd = connect_to("127.0.0.1", n.port); fd >= 0) { ::close(fd); return; }
+        if (::waitpid(n.pid, nullptr, WNOHANG) == n.pid) {
+            n.pid = -1;
+            fail("chat_server terminou ao iniciar");
+        }
+        std::this_thread::sleep_for(std::chrono::milliseconds(10));
+    }
+    fail("chat_server no respondeu");
+}
+
+// --------- Cliente ----------
+class Client {
+public:
+    Client(uint16_t port, std::string_view hello = "") : fd_(connect_to("127.0.0.1", port)) {
+        if (fd_ < 0) fail("connect falhou");
+        send(hello);
+    }
+    ~Client() { ::close(fd_); }
+
+    void send(std::string_view text) {
+        std::string line(text);
+        line += '\n';
+        if (send_all(fd_, line.data(), line.size()) != (ssize_t)line.size()) fail("send falhou");
+    }
+
+    // L linhas at uma conter `needle` ou o prazo acabar
+    bool wait_for(std::string_view needle, int timeout_ms) {
+        const auto deadline = std::chrono::steady_clock::now() + std::chrono::milliseconds(timeout_ms);
+        std::string line;
+        while (next_line(line, deadline)) {
+            if (line.find(needle) != std::string::npos) return true;
+        }
+        return false;
+    }
+
+    // Prxima linha (sem o '\n'); false se o prazo acabar antes
+    bool next_line(std::string& line, std::chrono::steady_clock::time_point deadline) {
+        for (;;) {
+            if (const size_t nl = in_.find('\n'); nl != std::string::npos) {
+                line.assign(in_, 0, nl);
+                in_.erase(0, nl + 1);
+                return true;
+            }
+            const auto left = std::chrono::duration_cast<std::chrono::milliseconds>(
+                deadline - std::chrono::steady_clock::now()).count();
+            if (left <= 0) return false;
+            pollfd p{fd_, POLLIN, 0};
+            if (::poll(&p, 1, static_cast<int>(left)) <= 0) continue;
+            char buf[4096];
+            const ssize_t n = ::read(fd_, buf, sizeof(buf));
+            if (n <= 0) fail("conexo com o servidor caiu");
+            in_.append(buf, static_cast<size_t>(n));
+        }
+    }
+
+private:
+    int         fd_;
+    std::string in_;
+};
+
+} // namespace
+
+int main(int argc, char** argv) {
+    std::string server;
+    for (int i = 1; i < argc; ++i) {
+        const std::string_view a = argv[i];
+        if (a == "--server" && i + 1 < argc) server = argv[++i];
+    }
+    if (server.empty()) {
+        std::cerr << "Uso: " << argv[0] << " --server <chat_server>\n";
+        return 2;
+    }
+    std::signal(SIGPIPE, SIG_IGN);
+
+    Node a, b;
+    g_nodes = {&a, &b};
+    const uint16_t peer_port = free_port();
+    a.port = free_port();
+    b.port = free_port();
+    a.args = {std::to_string(a.port), "--node", "1", "--peer", "127.0.0.1:" + std::to_string(peer_port)};
+    b.args = {std::to_string(b.port), "--node", "2", "--peer-port", std::to_string(peer_port)};
+    start_node(a, server);
+    start_node(b, server);
+
+    Client on_a(a.port);
+    Client numbered(a.port, "/since 0 0");
+    {
+        Client on_b(b.port);
+        // O enlace B -> A sobe em segundo plano: repete at a primeira chegar
+        bool linked = false;
+        for (int i = 0; i < 50 && !linked; ++i) {
+            on_b.send("sonda " + std::to_string(i));
+            linked = on_a.wait_for("sonda ", 100);
+        }
+        if (!linked) fail("enlace entre os ns no subiu");
+        for (int i = 1; i <= kBefore; ++i) on_b.send("antes " + std::to_string(i));
+        if (!on_a.wait_for("antes " + std::to_string(kBefore), 5000)) fail("linhas de B no chegaram a A");
+    }
+
+    // Reincio: mesmo --node, sequncia de volta ao zero. A s volta a discar
+    // depois do backoff, ento as primeiras linhas abaixo ficam no histrico
+    // de B e chegam a A pelo merge
+    stop_node(b);
+    start_node(b, server);
+    Client on_b(b.port);
+    // Menos tentativas que kBefore: se A tomasse as linhas novas por
+    // duplicatas (mesmo origin e seq), nenhuma delas chegaria
+    bool delivered = false;
+    int sent = 0;
+    while (sent < kBefore / 2 && !delivered) {
+        on_b.send("depois " + std::to_string(sent++));
+        delivered = on_a.wait_for("depois ", 100);
+    }
+    if (!delivered) fail("linhas de B aps o reincio no chegaram a A");
+
+    // A sesso numerada viu todas as "depois", ao vivo ou mescladas
+    uint64_t epoch = 0, max_seq = 0;
+    std::vector<bool> seen(static_cast<size_t>(sent), false);
+    std::string line;
+    const auto settle = std::chrono::steady_clock::now() + std::chrono::milliseconds(500);
+    while (numbered.next_line(line, settle)) {
+        if (line.starts_with("* gap ")) { epoch = std::strtoull(line.c_str() + 6, nullptr, 10); continue; }
+        if (!line.starts_with("#")) continue;
+        max_seq = std::max<uint64_t>(max_seq, std::strtoull(line.c_str() + 1, nullptr, 10));
+        if (const size_t p = line.find(" depois "); p != std::string::npos) {
+            const size_t i = std::strtoul(line.c_str() + p + 8, nullptr, 10);
+            if (i < seen.size()) seen[i] = true;
+        }
+    }
+    for (int i = 0; i < sent; ++i) {
+        if (!seen[static_cast<size_t>(i)]) fail("sesso numerada no recebeu 'depois " + std::to_string(i) + "'");
+    }
+
+    // Retomada a partir do maior nmero visto: nada falta, nada se repete
+    Client resumed(a.port, "/since " + std::to_string(epoch) + " " + std::to_string(max_seq));
+    const auto soon = std::chrono::steady_clock::now() + std::chrono::milliseconds(300);
+    if (!resumed.next_line(line, soon) || !line.starts_with("* sync ")) fail("retomada sem '* sync': " + line);
+    if (resumed.next_line(line, std::chrono::steady_clock::now() + std::chrono::milliseconds(300))) {
+        fail("retomada repetiu uma linha: " + line);
+    }
+
+    for (Node* n : g_nodes) {
+        stop_node(*n);
+        std::error_code ec;
+        std::filesystem::remove_all(n->dir, ec);
+    }
+    std::cout << "federation_restart: ok\n";
+    return 0;
+}
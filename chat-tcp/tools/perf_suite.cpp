@@ -0,0 +1,480 @@
+// Sute de regresso de desempenho ponta a ponta (cmake -DCHAT_PERF_TESTS=ON
+// e ctest -L perf; fora da execuo padro do ctest).
+//
+// Sobe um chat_server novo numa porta efmera de loopback, dentro de um
+// diretrio temporrio (o log vai para l), e o exercita com clientes
+// simulados numa nica thread com epoll. O servidor roda como processo
+// filho: RSS e CPU dele ficam separados dos clientes. Mede:
+//   connect_per_s     conexes aceitas e registradas por segundo (/who)
+//   rss_per_conn_kb   memria residente do servidor por conexo ociosa
+//   msgs_per_s        mensagens difundidas por segundo (melhor de 3 rodadas)
+//   fanout_p50_us     latncia envio -> recepo, sob carga cadenciada
+//   fanout_p99_us
+//   log_cost          msgs_per_s sem log / msgs_per_s com log em debug
+// e compara com um arquivo de referncia pela razo atual / referncia:
+// falha (cdigo 1) se alguma mtrica piorar alm da tolerncia dela (piora
+// relativa, gravada na referncia; --threshold impe uma s para todas).
+// As tolerncias padro so largas (vazo pela metade, latncia 3x a 5x):
+// pegam regresses grosseiras sem falhar por rudo de uma mquina
+// compartilhada. Em outra mquina, grave uma referncia nova com
+// --write-baseline.
+//
+// Uso: ./perf_suite --server <chat_server> [--baseline arquivo] [--threshold 0.3]
+//                   [--write-baseline arquivo]
+#include <algorithm>
+#include <chrono>
+#include <csignal>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <functional>
+#include <iostream>
+#include <map>
+#include <sstream>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <vector>
+#include <cerrno>
+#include <fcntl.h>
+#include <unistd.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <sys/epoll.h>
+#include <sys/socket.h>
+#include <sys/wait.h>
+
+#include "common/net.hpp"
+
+namespace {
+
+struct Options {
+    std::string server;
+    std::string baseline;
+    std::string write_baseline;
+    double      threshold = 0; // > 0: mesma tolerncia para todas as mtricas
+};
+
+// Parmetros das fases (fixos: a referncia s vale para a mesma carga)
+constexpr int    kIdleConns     = 500;   // fase de conexo / RSS
+constexpr int    kConnectBatch  = 50;    // abaixo do backlog do listen (64)
+constexpr int    kConns         = 32;    // fases de vazo e latncia
+constexpr int    kSenders       = 4;
+constexpr int    kWindow        = 32;    // mensagens em voo por remetente
+constexpr int    kThroughputMsg = 20000;
+constexpr int    kLatencyRate   = 4000;  // mensagens/s no total
+constexpr double kLatencySecs   = 2.0;
+constexpr int    kMsgSize       = 64;    // bytes por linha, com '\n'
+
+int64_t mono_ns() {
+    using namespace std::chrono;
+    return duration_cast<nanoseconds>(steady_clock::now().time_since_epoch()).count();
+}
+
+// --------- Servidor (processo filho) ----------
+struct ServerProc {
+    pid_t                 pid = -1;
+    uint16_t              port = 0;
+    std::filesystem::path dir;
+    std::string           admin;
+};
+
+ServerProc* g_server = nullptr; // encerrado tambm quando uma fase falha
+
+void stop_server(ServerProc& s) {
+    if (s.pid > 0) {
+        ::kill(s.pid, SIGINT);
+        ::waitpid(s.pid, nullptr, 0);
+        s.pid = -1;
+    }
+    std::error_code ec;
+    if (!s.dir.empty()) std::filesystem::remove_all(s.dir, ec);
+}
+
+[[noreturn]] void fail(const std::string& why) {
+    std::cerr << "perf_suite: " << why << "\n";
+    if (g_server) stop_server(*g_server);
+    std::exit(2);
+}
+
+uint16_t free_port() {
+    int fd = make_server_socket(0);
+    sockaddr_in addr{};
+    socklen_t len = sizeof(addr);
+    if (fd < 0 || ::getsockname(fd, (sockaddr*)&addr, &len) < 0) fail("sem porta livre");
+    ::close(fd);
+    return ntohs(addr.sin_port);
+}
+
+void start_server(ServerProc& s, const std::string& bin) {
+    char tmpl[] = "/tmp/perf_suite.XXXXXX";
+    if (!::mkdtemp(tmpl)) fail("mkdtemp falhou");
+    s.dir   = tmpl;
+    s.port  = free_port();
+    s.admin = (s.dir / "admin.sock").string();
+    const std::string port = std::to_string(s.port);
+    const std::string exe  = std::filesystem::absolute(bin).string(); // o filho muda de diretrio
+
+    s.pid = ::fork();
+    if (s.pid < 0) fail("fork falhou");
+    if (s.pid == 0) {
+        if (::chdir(s.dir.c_str()) != 0) ::_exit(127);
+        int null = ::open("/dev/null", O_WRONLY);
+        ::dup2(null, STDOUT_FILENO);
+        ::dup2(null, STDERR_FILENO);
+        ::execl(exe.c_str(), exe.c_str(), port.c_str(), "--admin", s.admin.c_str(), "--log-level", "debug",
+                static_cast<char*>(nullptr));
+        ::_exit(127);
+    }
+    // Pronto quando aceita conexes
+    for (int i = 0; i < 300; ++i) {
+        if (int fd = connect_to("127.0.0.1", s.port); fd >= 0) { ::close(fd); return; }
+        if (::waitpid(s.pid, nullptr, WNOHANG) == s.pid) {
+            s.pid = -1;
+            fail("chat_server terminou ao iniciar");
+        }
+        std::this_thread::sleep_for(std::chrono::milliseconds(10));
+    }
+    fail("chat_server no respondeu");
+}
+
+long rss_kb(pid_t pid) {
+    std::ifstream in("/proc/" + std::to_string(pid) + "/status");
+    std::string key;
+    long v = 0;
+    while (in >> key) {
+        if (key == "VmRSS:") { in >> v; return v; }
+        in.ignore(4096, '\n');
+    }
+    return 0;
+}
+
+// Um comando no socket de administrao; devolve a resposta.
+std::string admin(const ServerProc& s, const std::string& cmd) {
+    int fd = connect_unix(s.admin);
+    if (fd < 0) fail("socket de administrao indisponvel");
+    const std::string line = cmd + "\n";
+    send_all(fd, line.data(), line.size());
+    std::string out;
+    char c;
+    while (::read(fd, &c, 1) == 1 && c != '\n') out.push_back(c);
+    ::close(fd);
+    return out;
+}
+
+// --------- Clientes simulados ----------
+struct Conn {
+    int         fd = -1;
+    std::string in; // bytes ainda sem '\n'
+};
+
+class Clients {
+public:
+    using OnLine = std::function<void(size_t, std::string_view)>;
+
+    Clients() : ep_(::epoll_create1(EPOLL_CLOEXEC)) {}
+    ~Clients() { close_all(); ::close(ep_); }
+
+    size_t open(uint16_t port) {
+        int fd = connect_to("127.0.0.1", port);
+        if (fd < 0) fail("connect falhou");
+        int one = 1;
+        ::setsockopt(fd, IPPROTO_TCP, TCP_NODELAY, &one, sizeof(one));
+        set_nonblocking(fd);
+        epoll_event ev{};
+        ev.events   = EPOLLIN;
+        ev.data.u64 = conns_.size();
+        ::epoll_ctl(ep_, EPOLL_CTL_ADD, fd, &ev);
+        conns_.push_back(Conn{fd, {}});
+        // Primeira linha vazia: o servidor no espera pelo "/since" e j
+        // registra a sesso
+        send(conns_.size() - 1, "\n");
+        return conns_.size() - 1;
+    }
+
+    void close_all() {
+        for (auto& c : conns_) ::close(c.fd);
+        conns_.clear();
+    }
+
+    Conn& operator[](size_t i) { return conns_[i]; }
+    size_t size() const { return conns_.size(); }
+
+    void send(size_t i, std::string_view line) {
+        // Linhas curtas e poucas em voo: o buffer do socket sempre absorve
+        if (send_all(conns_[i].fd, line.data(), line.size()) != static_cast<ssize_t>(line.size())) fail("send falhou");
+    }
+
+    // Processa o que chegar em at `timeout_ms`.
+    void poll(int timeout_ms, const OnLine& on_line) {
+        epoll_event evs[64];
+        const int n = ::epoll_wait(ep_, evs, 64, timeout_ms);
+        char buf[65536];
+        for (int k = 0; k < n; ++k) {
+            const size_t i = evs[k].data.u64;
+            Conn& c = conns_[i];
+            for (;;) {
+                ssize_t r = ::recv(c.fd, buf, sizeof(buf), 0);
+                if (r <= 0) {
+                    if (r < 0 && (errno == EAGAIN || errno == EWOULDBLOCK)) break;
+                    if (r < 0 && errno == EINTR) continue;
+                    fail("servidor fechou uma conexo");
+                }
+                c.in.append(buf, static_cast<size_t>(r));
+            }
+            size_t start = 0;
+            for (size_t nl; (nl = c.in.find('\n', start)) != std::string::npos; start = nl + 1) {
+                on_line(i, std::string_view(c.in).substr(start, nl - start));
+            }
+            c.in.erase(0, start);
+        }
+    }
+
+    // Pergunta /who em `i` at o servidor contar `want` sesses.
+    void wait_online(size_t i, size_t want) {
+        const int64_t deadline = mono_ns() + 10'000'000'000;
+        for (;;) {
+            send(i, "/who\n");
+            long seen = -1;
+            while (seen < 0) {
+                if (mono_ns() > deadline) fail("servidor no registrou as conexes a tempo");
+                poll(100, [&](size_t from, std::string_view l) {
+                    if (from == i && l.starts_with("* online (")) seen = std::atol(l.data() + 10);
+                });
+            }
+            if (static_cast<size_t>(seen) == want) return;
+            std::this_thread::sleep_for(std::chrono::milliseconds(1));
+        }
+    }
+
+private:
+    int               ep_;
+    std::vector<Conn> conns_;
+};
+
+// Linha de tamanho fixo: "<tag> <remetente> <ns>" + enchimento + '\n'
+std::string make_line(char tag, int sender, int64_t ns) {
+    std::string s = std::string(1, tag) + " " + std::to_string(sender) + " " + std::to_string(ns) + " ";
+    s.resize(kMsgSize - 1, 'x');
+    s.push_back('\n');
+    return s;
+}
+
+// --------- Fases ----------
+struct ConnectResult { double per_s; double rss_per_conn_kb; };
+
+ConnectResult phase_connect(const ServerProc& s) {
+    Clients cl;
+    const long rss0 = rss_kb(s.pid);
+    const int64_t t0 = mono_ns();
+    // Em lotes: sem isso, numa mquina com poucos ncleos a fila de accept
+    // enche e o kernel descarta SYNs (reenvio s depois de 1 s)
+    while (cl.size() < kIdleConns) {
+        for (int i = 0; i < kConnectBatch; ++i) cl.open(s.port);
+        cl.wait_online(cl.size() - 1, cl.size());
+    }
+    const double secs = double(mono_ns() - t0) / 1e9;
+    std::this_thread::sleep_for(std::chrono::milliseconds(200));
+    const long rss1 = rss_kb(s.pid);
+    ConnectResult r{kIdleConns / secs, double(rss1 - rss0) / kIdleConns};
+    cl.close_all();
+
+    Clients probe; // espera o servidor despachar as sadas
+    probe.open(s.port);
+    probe.wait_online(0, 1);
+    return r;
+}
+
+void open_group(Clients& cl, const ServerProc& s) {
+    for (int i = 0; i < kConns; ++i) cl.open(s.port);
+    cl.wait_online(0, kConns);
+}
+
+// Vazo: remetentes com janela fixa; termina quando todos receberam tudo.
+double phase_throughput(const ServerProc& s, char tag) {
+    Clients cl;
+    open_group(cl, s);
+    const int per_sender = kThroughputMsg / kSenders;
+    std::vector<int> sent(kSenders, 0), inflight(kSenders, 0);
+    uint64_t delivered = 0;
+    const uint64_t expected = uint64_t(kThroughputMsg) * kConns;
+
+    auto top_up = [&](int k) {
+        while (inflight[k] < kWindow && sent[k] < per_sender) {
+            cl.send(static_cast<size_t>(k), make_line(tag, k, 0));
+            ++sent[k];
+            ++inflight[k];
+        }
+    };
+    const int64_t t0 = mono_ns();
+    for (int k = 0; k < kSenders; ++k) top_up(k);
+    while (delivered < expected) {
+        if (mono_ns() - t0 > 60'000'000'000) fail("vazo: mensagens perdidas");
+        cl.poll(100, [&](size_t i, std::string_view l) {
+            if (l.empty() || l[0] != tag) return;
+            ++delivered;
+            // A prpria mensagem voltou: libera uma vaga na janela
+            if (i < size_t(kSenders) && std::atoi(l.data() + 2) == int(i)) {
+                --inflight[i];
+                top_up(static_cast<int>(i));
+            }
+        });
+    }
+    return kThroughputMsg / (double(mono_ns() - t0) / 1e9);
+}
+
+// Uma marca por rodada: o replay do histrico traz linhas das anteriores.
+double best_throughput(const ServerProc& s, std::string_view tags) {
+    double best = 0;
+    for (char tag : tags) best = std::max(best, phase_throughput(s, tag));
+    return best;
+}
+
+// Latncia: carga cadenciada; cada receptor mede agora - carimbo da linha.
+std::pair<double, double> phase_latency(const ServerProc& s) {
+    Clients cl;
+    open_group(cl, s);
+    std::vector<uint32_t> lat_us;
+    const int total = static_cast<int>(kLatencyRate * kLatencySecs);
+    lat_us.reserve(size_t(total) * kConns);
+    auto on_line = [&](size_t, std::string_view l) {
+        if (l.empty() || l[0] != 'L') return;
+        const char* p = std::strchr(l.data() + 2, ' ');
+        const int64_t ns = std::atoll(p + 1);
+        lat_us.push_back(static_cast<uint32_t>((mono_ns() - ns) / 1000));
+    };
+
+    const int64_t t0 = mono_ns(), step = 1'000'000'000 / kLatencyRate;
+    for (int n = 0; n < total; ++n) {
+        const int64_t due = t0 + n * step;
+        for (int64_t now; (now = mono_ns()) < due;) cl.poll(static_cast<int>((due - now) / 1'000'000), on_line);
+        cl.send(static_cast<size_t>(n % kSenders), make_line('L', n % kSenders, mono_ns()));
+    }
+    const int64_t deadline = mono_ns() + 5'000'000'000;
+    while (lat_us.size() < size_t(total) * kConns && mono_ns() < deadline) cl.poll(100, on_line);
+    if (lat_us.size() < size_t(total) * kConns) fail("latncia: mensagens perdidas");
+
+    std::sort(lat_us.begin(), lat_us.end());
+    auto pct = [&](double p) { return double(lat_us[static_cast<size_t>(p * double(lat_us.size() - 1))]); };
+    return {pct(0.50), pct(0.99)};
+}
+
+// --------- Referncia ----------
+// Tolerncia padro de cada mtrica: caudas e taxas de conexo oscilam
+// muito mais que a vazo numa mquina compartilhada.
+struct Metric {
+    const char* name;
+    bool        higher_better;
+    double      tolerance;
+    double      value;
+};
+
+struct Reference {
+    double value     = 0;
+    double tolerance = 0; // 0 -> a padro da mtrica
+};
+
+// Linhas "mtrica valor [tolerncia]"; '#' comenta.
+std::map<std::string, Reference> read_baseline(const std::string& path) {
+    std::map<std::string, Reference> m;
+    std::ifstream in(path);
+    if (!in) fail("no foi possvel ler " + path);
+    std::string line;
+    while (std::getline(in, line)) {
+        if (line.empty() || line[0] == '#') continue;
+        std::istringstream is(line);
+        std::string name;
+        Reference r;
+        if (is >> name >> r.value) {
+            is >> r.tolerance;
+            m[name] = r;
+        }
+    }
+    return m;
+}
+
+void write_baseline(const std::string& path, const std::vector<Metric>& ms) {
+    std::ofstream out(path);
+    out << "# Referncia do perf_suite: mtrica valor tolerncia (piora relativa).\n"
+        << "# Regrave com --write-baseline ao trocar de mquina ou ao aceitar uma\n"
+        << "# mudana de desempenho.\n";
+    for (auto& m : ms) out << m.name << " " << m.value << " " << m.tolerance << "\n";
+    if (!out) fail("no foi possvel gravar " + path);
+}
+
+// Tabela de comparao; false se houve regresso.
+bool compare(const std::vector<Metric>& ms, const std::map<std::string, Reference>& base, double thr) {
+    bool ok = true;
+    std::printf("%-18s %12s %12s %8s %6s\n", "mtrica", "atual", "referncia", "razo", "tol.");
+    for (auto& m : ms) {
+        auto it = base.find(m.name);
+        if (it == base.end() || it->second.value <= 0) {
+            std::printf("%-18s %12.1f %12s %8s\n", m.name, m.value, "-", "-");
+            continue;
+        }
+        const Reference& ref = it->second;
+        const double tol   = thr > 0 ? thr : ref.tolerance > 0 ? ref.tolerance : m.tolerance;
+        const double ratio = m.value / ref.value;
+        const bool   worse = m.higher_better ? ratio < 1 - tol : ratio > 1 + tol;
+        std::printf("%-18s %12.1f %12.1f %7.2fx %5.0f%%%s\n", m.name, m.value, ref.value, ratio,
+                    tol * 100, worse ? "  REGRESSO" : "");
+        ok = ok && !worse;
+    }
+    return ok;
+}
+
+bool parse(int argc, char** argv, Options& o) {
+    for (int i = 1; i + 1 < argc; i += 2) {
+        std::string_view a = argv[i];
+        if      (a == "--server")         o.server = argv[i + 1];
+        else if (a == "--baseline")       o.baseline = argv[i + 1];
+        else if (a == "--write-baseline") o.write_baseline = argv[i + 1];
+        else if (a == "--threshold")      o.threshold = std::atof(argv[i + 1]);
+        else return false;
+    }
+    return argc % 2 == 1 && !o.server.empty() && o.threshold >= 0;
+}
+
+} // namespace
+
+int main(int argc, char** argv) {
+    Options opt;
+    if (!parse(argc, argv, opt)) {
+        std::cerr << "Uso: " << argv[0] << " --server <chat_server> [--baseline arquivo] [--threshold 0.3]"
+                  << " [--write-baseline arquivo]\n";
+        return 2;
+    }
+    std::signal(SIGPIPE, SIG_IGN);
+
+    ServerProc srv;
+    g_server = &srv;
+    start_server(srv, opt.server);
+    const ConnectResult conn = phase_connect(srv);
+    const double with_log = best_throughput(srv, "ABC");
+    const auto [p50, p99] = phase_latency(srv);
+    admin(srv, "log level error");
+    const double no_log = best_throughput(srv, "DEF");
+    stop_server(srv);
+    g_server = nullptr;
+
+    const std::vector<Metric> ms = {
+        {"connect_per_s",   true,  0.6, conn.per_s},
+        {"rss_per_conn_kb", false, 0.5, conn.rss_per_conn_kb},
+        {"msgs_per_s",      true,  0.5, with_log},
+        {"fanout_p50_us",   false, 2.0, p50},
+        {"fanout_p99_us",   false, 4.0, p99},
+        {"log_cost",        false, 0.5, no_log / with_log},
+    };
+
+    if (!opt.write_baseline.empty()) {
+        write_baseline(opt.write_baseline, ms);
+        std::cout << "Referncia gravada em " << opt.write_baseline << "\n";
+    }
+    const auto base = opt.baseline.empty() ? std::map<std::string, Reference>{} : read_baseline(opt.baseline);
+    const bool ok = compare(ms, base, opt.threshold);
+    if (!ok) std::cout << "perf_suite: regresso acima da tolerncia\n";
+    return ok ? 0 : 1;
+}
@@ -0,0 +1,458 @@
+// Estatsticas de logs do tslog (logs/app.log) em uma passada paralela.
+// Os arquivos so mapeados com mmap e divididos em blocos alinhados a
+// linhas; cada thread varre blocos com contadores prprios, somados no fim.
+// O prefixo "YYYY-MM-DD HH:MM:SS [LEVEL] "  lido com largura fixa: a data
+//  comparada com a da linha anterior (muda uma vez por dia), a hora 
+// validada e convertida com operaes num registro de 64 bits (SWAR) e o
+// nvel  uma comparao de 8 bytes.
+//
+// Relatrios: linhas por nvel, histograma por segundo (linhas, RX,
+// desconexes, "send falhou", WARN/ERROR), top-N segundos por volume e por
+// desconexes (tempestades) e top-N fds por RX e por "send falhou". Os
+// contadores por fd somam todas as sesses que usaram o mesmo nmero.
+//
+// Uso: ./tslog_stats <arquivo> [arquivo ...] [--threads N] [--top N] [--csv saida.csv]
+//   ex.: ./tslog_stats logs/app.log logs/app.log.1 --top 20
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+namespace {
+
+constexpr size_t   kPrefixLen = 28;       // "YYYY-MM-DD HH:MM:SS [LEVEL] "
+constexpr size_t   kMinChunk  = 4u << 20; // blocos de no mnimo 4 MiB
+constexpr uint64_t kMaxFd     = 1u << 22; // fds acima disso no entram na tabela
+
+enum Lv { Debug, Info, Warn, Error, NLevels };
+constexpr const char* kLevelName[NLevels] = {"DEBUG", "INFO", "WARN", "ERROR"};
+
+struct Sec {
+    uint64_t lines = 0, warn = 0, rx = 0, disc = 0, send_fail = 0;
+    void add(const Sec& o) { lines += o.lines; warn += o.warn; rx += o.rx; disc += o.disc; send_fail += o.send_fail; }
+};
+
+struct FdStat {
+    uint64_t rx = 0, connects = 0, disc = 0, send_fail = 0;
+};
+
+// Contadores de uma thread
+struct Stats {
+    uint64_t lines = 0, no_prefix = 0, fd_overflow = 0;
+    uint64_t level[NLevels] = {};
+    std::unordered_map<int64_t, Sec> secs;
+    std::vector<FdStat>              fds;
+
+    FdStat& fd(uint64_t n) {
+        if (n >= fds.size()) fds.resize(std::max<size_t>(n + 1, fds.size() * 2));
+        return fds[n];
+    }
+};
+
+// --------- Prefixo ----------
+inline uint64_t load64(const char* p) { uint64_t v; std::memcpy(&v, p, 8); return v; }
+
+// Dias desde 1970-01-01 (calendrio gregoriano prolptico).
+int64_t days_from_civil(int64_t y, unsigned m, unsigned d) {
+    y -= m <= 2;
+    const int64_t era = (y >= 0 ? y : y - 399) / 400;
+    const unsigned yoe = static_cast<unsigned>(y - era * 400);
+    const unsigned doy = (153 * (m + (m > 2 ? -3 : 9)) + 2) / 5 + d - 1;
+    const unsigned doe = yoe * 365 + yoe / 4 - yoe / 100 + doy;
+    return era * 146097 + static_cast<int64_t>(doe) - 719468;
+}
+
+std::string format_sec(int64_t t) {
+    int64_t z = (t >= 0 ? t : t - 86399) / 86400;
+    const unsigned s = static_cast<unsigned>(t - z * 86400) % 86400; // [0, 86400)
+    z += 719468;
+    const int64_t era = (z >= 0 ? z : z - 146096) / 146097;
+    const unsigned doe = static_cast<unsigned>(z - era * 146097);
+    const unsigned yoe = (doe - doe / 1460 + doe / 36524 - doe / 146096) / 365;
+    const unsigned doy = doe - (365 * yoe + yoe / 4 - yoe / 100);
+    const unsigned mp = (5 * doy + 2) / 153;
+    const unsigned d = doy - (153 * mp + 2) / 5 + 1;
+    const unsigned m = mp < 10 ? mp + 3 : mp - 9;
+    const int64_t y = static_cast<int64_t>(yoe) + era * 400 + (m <= 2);
+    // Pior caso: ano com sinal e 19 dgitos, ms e dia com 10 (o compilador
+    // no sabe que ficam em 1..31)
+    char buf[64];
+    std::snprintf(buf, sizeof(buf), "%04lld-%02u-%02u %02u:%02u:%02u", static_cast<long long>(y), m, d,
+                  s / 3600, s / 60 % 60, s % 60);
+    return buf;
+}
+
+// 8 bytes s de dgitos ASCII?
+inline bool all_digits(uint64_t v) {
+    return (((v & 0xF0F0F0F0F0F0F0F0ull) | (((v + 0x0606060606060606ull) & 0xF0F0F0F0F0F0F0F0ull) >> 4)) ==
+            0x3333333333333333ull);
+}
+
+// "HH:MM:SS" -> segundos do dia; -1 se invlido. Os ':' viram '0' para a
+// validao de dgitos, e os trs pares so convertidos de uma vez.
+inline int64_t parse_hms(const char* p) {
+    constexpr uint64_t kColons = (uint64_t(0xFF) << 16) | (uint64_t(0xFF) << 40);
+    constexpr uint64_t kColonV = (uint64_t(':') << 16) | (uint64_t(':') << 40);
+    constexpr uint64_t kZeros  = (uint64_t('0') << 16) | (uint64_t('0') << 40);
+    const uint64_t v = load64(p);
+    if ((v & kColons) != kColonV) return -1;
+    const uint64_t w = (v & ~kColons) | kZeros;
+    if (!all_digits(w)) return -1;
+    const uint64_t d = w - 0x3030303030303030ull;  // cada byte 0..9
+    const uint64_t t = d * 10 + (d >> 8);          // bytes 0, 3 e 6: dezena*10 + unidade
+    const int64_t hh = t & 0xFF, mm = (t >> 24) & 0xFF, ss = (t >> 48) & 0xFF;
+    if (hh > 23 || mm > 59 || ss > 60) return -1;
+    return hh * 3600 + mm * 60 + ss;
+}
+
+// "YYYY-MM-DD" -> dias; -1 se invlido.
+int64_t parse_date(const char* p) {
+    if (p[4] != '-' || p[7] != '-') return -1;
+    int v[8], k = 0;
+    for (int i : {0, 1, 2, 3, 5, 6, 8, 9}) {
+        if (p[i] < '0' || p[i] > '9') return -1;
+        v[k++] = p[i] - '0';
+    }
+    const int y = v[0] * 1000 + v[1] * 100 + v[2] * 10 + v[3];
+    const unsigned m = static_cast<unsigned>(v[4] * 10 + v[5]), d = static_cast<unsigned>(v[6] * 10 + v[7]);
+    if (m < 1 || m > 12 || d < 1 || d > 31) return -1;
+    return days_from_civil(y, m, d);
+}
+
+// " [LEVEL]" inteiro numa comparao de 8 bytes.
+inline int parse_level(const char* p) {
+    static const uint64_t kTags[NLevels] = {load64(" [DEBUG]"), load64(" [INFO ]"), load64(" [WARN ]"),
+                                            load64(" [ERROR]")};
+    const uint64_t v = load64(p);
+    for (int i = 0; i < NLevels; ++i)
+        if (v == kTags[i]) return i;
+    return -1;
+}
+
+// Nmero decimal em [p, end); false se no houver dgito.
+inline bool parse_uint(const char*& p, const char* end, uint64_t& out) {
+    const char* s = p;
+    out = 0;
+    while (p < end && *p >= '0' && *p <= '9' && p - s < 18) out = out * 10 + uint64_t(*p++ - '0');
+    return p != s;
+}
+
+inline bool starts(const char* p, const char* end, std::string_view lit) {
+    return size_t(end - p) >= lit.size() && std::memcmp(p, lit.data(), lit.size()) == 0;
+}
+
+// --------- Varredura ----------
+class Scanner {
+public:
+    explicit Scanner(Stats& st) : st_(st) {}
+
+    // Linhas que comeam em [begin, end); a ltima pode passar de `end`
+    // at `limit` (fim do arquivo).
+    void scan(const char* begin, const char* end, const char* limit) {
+        const char* p = begin;
+        while (p < end) {
+            const char* nl = static_cast<const char*>(std::memchr(p, '\n', size_t(limit - p)));
+            const char* eol = nl ? nl : limit;
+            line(p, eol);
+            p = eol + 1;
+        }
+    }
+
+private:
+    Stats&      st_;
+    char        date_[10] = {};     // data da linha anterior
+    int64_t     day_ = -1;
+    int64_t     sec_key_ = INT64_MIN;
+    Sec*        sec_ = nullptr;     // segundo da linha anterior
+
+    void line(const char* p, const char* eol) {
+        ++st_.lines;
+        if (size_t(eol - p) < kPrefixLen) { ++st_.no_prefix; return; }
+
+        if (day_ < 0 || std::memcmp(p, date_, 10) != 0) {
+            const int64_t d = parse_date(p);
+            if (d < 0 || p[10] != ' ') { ++st_.no_prefix; return; }
+            std::memcpy(date_, p, 10);
+            day_ = d;
+        }
+        const int64_t hms = parse_hms(p + 11);
+        const int lv = parse_level(p + 19);
+        if (hms < 0 || lv < 0 || p[27] != ' ') { ++st_.no_prefix; return; }
+        ++st_.level[lv];
+
+        const int64_t key = day_ * 86400 + hms;
+        if (key != sec_key_) { sec_ = &st_.secs[key]; sec_key_ = key; }
+        ++sec_->lines;
+        if (lv >= Warn) ++sec_->warn;
+
+        message(p + kPrefixLen, eol, lv);
+    }
+
+    // Mensagens do chat_server que viram contadores
+    void message(const char* m, const char* eol, int lv) {
+        uint64_t fd = 0;
+        if (starts(m, eol, "RX fd=")) {
+            m += 6;
+            if (!parse_uint(m, eol, fd)) return;
+            ++sec_->rx;
+            if (FdStat* f = fd_stat(fd)) ++f->rx;
+        } else if (starts(m, eol, "Cliente fd=")) {
+            m += 11;
+            if (!parse_uint(m, eol, fd) || !starts(m, eol, " desconectou")) return;
+            ++sec_->disc;
+            if (FdStat* f = fd_stat(fd)) ++f->disc;
+        } else if (starts(m, eol, "Novo cliente conectado (fd=")) {
+            m += 27;
+            if (!parse_uint(m, eol, fd)) return;
+            if (FdStat* f = fd_stat(fd)) ++f->connects;
+        } else if (lv >= Warn) {
+            // Avisos so raros: aqui a busca por substring no pesa
+            const std::string_view msg(m, size_t(eol - m));
+            if (msg.find("send falhou") == std::string_view::npos) return;
+            ++sec_->send_fail;
+            if (auto at = msg.find("fd="); at != std::string_view::npos) {
+                const char* q = m + at + 3;
+                if (parse_uint(q, eol, fd))
+                    if (FdStat* f = fd_stat(fd)) ++f->send_fail;
+            }
+        }
+    }
+
+    FdStat* fd_stat(uint64_t fd) {
+        if (fd >= kMaxFd) { ++st_.fd_overflow; return nullptr; }
+        return &st_.fd(fd);
+    }
+};
+
+// --------- Arquivos e blocos ----------
+struct Mapped {
+    std::string name;
+    const char* data = nullptr;
+    size_t      size = 0;
+};
+
+struct Chunk {
+    const Mapped* file;
+    size_t        begin, end;
+};
+
+bool map_file(const std::string& path, Mapped& out) {
+    int fd = ::open(path.c_str(), O_RDONLY | O_CLOEXEC);
+    if (fd < 0) return false;
+    struct stat sb{};
+    if (::fstat(fd, &sb) != 0) { ::close(fd); return false; }
+    out.name = path;
+    out.size = static_cast<size_t>(sb.st_size);
+    if (out.size > 0) {
+        void* p = ::mmap(nullptr, out.size, PROT_READ, MAP_PRIVATE, fd, 0);
+        if (p == MAP_FAILED) { ::close(fd); return false; }
+        ::madvise(p, out.size, MADV_SEQUENTIAL);
+        ::madvise(p, out.size, MADV_WILLNEED);
+        out.data = static_cast<const char*>(p);
+    }
+    ::close(fd);
+    return true;
+}
+
+// Corta cada arquivo em blocos; cada borda avana at depois do prximo
+// '\n', para que toda linha pertena a exatamente um bloco.
+std::vector<Chunk> split(const std::vector<Mapped>& files, unsigned threads) {
+    size_t total = 0;
+    for (auto& f : files) total += f.size;
+    const size_t target = std::max(kMinChunk, total / (size_t(threads) * 4) + 1);
+    std::vector<Chunk> chunks;
+    for (auto& f : files) {
+        size_t begin = 0;
+        while (begin < f.size) {
+            size_t end = std::min(f.size, begin + target);
+            if (end < f.size) {
+                const void* nl = std::memchr(f.data + end, '\n', f.size - end);
+                end = nl ? size_t(static_cast<const char*>(nl) - f.data) + 1 : f.size;
+            }
+            chunks.push_back({&f, begin, end});
+            begin = end;
+        }
+    }
+    return chunks;
+}
+
+// --------- Relatrio ----------
+std::string human_bytes(double b) {
+    const char* unit[] = {"B", "KB", "MB", "GB", "TB"};
+    int u = 0;
+    while (b >= 1024 && u < 4) { b /= 1024; ++u; }
+    char buf[32];
+    std::snprintf(buf, sizeof(buf), "%.2f %s", b, unit[u]);
+    return buf;
+}
+
+template <class T, class Key>
+std::vector<T> top(std::vector<T> v, size_t n, Key key) {
+    n = std::min(n, v.size());
+    std::partial_sort(v.begin(), v.begin() + static_cast<std::ptrdiff_t>(n), v.end(),
+                      [&](const T& a, const T& b) { return key(a) > key(b); });
+    v.resize(n);
+    return v;
+}
+
+} // namespace
+
+int main(int argc, char** argv) {
+    std::vector<std::string> paths;
+    unsigned threads = std::max(1u, std::thread::hardware_concurrency());
+    size_t top_n = 10;
+    std::string csv;
+    bool bad = false;
+    for (int i = 1; i < argc; ++i) {
+        std::string_view a = argv[i];
+        if      (a == "--threads" && i + 1 < argc) threads = std::max(1, std::atoi(argv[++i]));
+        else if (a == "--top" && i + 1 < argc)     top_n = static_cast<size_t>(std::max(1, std::atoi(argv[++i])));
+        else if (a == "--csv" && i + 1 < argc)     csv = argv[++i];
+        else if (!a.starts_with("--"))             paths.emplace_back(a);
+        else bad = true;
+    }
+    if (paths.empty() || bad) {
+        std::cerr << "Uso: " << argv[0] << " <arquivo> [arquivo ...] [--threads N] [--top N] [--csv saida.csv]\n";
+        return 2;
+    }
+
+    std::vector<Mapped> files(paths.size());
+    for (size_t i = 0; i < paths.size(); ++i) {
+        if (!map_file(paths[i], files[i])) {
+            std::cerr << "tslog_stats: no foi possvel abrir " << paths[i] << "\n";
+            return 1;
+        }
+    }
+
+    const auto t0 = std::chrono::steady_clock::now();
+    const std::vector<Chunk> chunks = split(files, threads);
+    threads = static_cast<unsigned>(std::max<size_t>(1, std::min<size_t>(threads, chunks.size())));
+    std::vector<Stats> per_thread(threads);
+    std::atomic<size_t> next{0};
+    auto worker = [&](Stats& st) {
+        Scanner sc(st);
+        for (size_t i; (i = next.fetch_add(1, std::memory_order_relaxed)) < chunks.size();) {
+            const Chunk& c = chunks[i];
+            sc.scan(c.file->data + c.begin, c.file->data + c.end, c.file->data + c.file->size);
+        }
+    };
+    std::vector<std::thread> pool;
+    for (unsigned t = 1; t < threads; ++t) pool.emplace_back(worker, std::ref(per_thread[t]));
+    worker(per_thread[0]);
+    for (auto& th : pool) th.join();
+
+    // Soma das threads
+    Stats all;
+    std::unordered_map<int64_t, Sec> secs;
+    for (auto& st : per_thread) {
+        all.lines += st.lines;
+        all.no_prefix += st.no_prefix;
+        all.fd_overflow += st.fd_overflow;
+        for (int l = 0; l < NLevels; ++l) all.level[l] += st.level[l];
+        for (auto& [k, s] : st.secs) secs[k].add(s);
+        if (st.fds.size() > all.fds.size()) all.fds.resize(st.fds.size());
+        for (size_t fd = 0; fd < st.fds.size(); ++fd) {
+            FdStat& d = all.fds[fd];
+            const FdStat& s = st.fds[fd];
+            d.rx += s.rx; d.connects += s.connects; d.disc += s.disc; d.send_fail += s.send_fail;
+        }
+    }
+    const double secs_elapsed =
+        std::chrono::duration<double>(std::chrono::steady_clock::now() - t0).count();
+
+    size_t bytes = 0;
+    for (auto& f : files) bytes += f.size;
+    std::vector<std::pair<int64_t, Sec>> hist(secs.begin(), secs.end());
+    std::sort(hist.begin(), hist.end(), [](auto& a, auto& b) { return a.first < b.first; });
+
+    std::printf("%zu arquivo(s), %s, %llu linhas em %.3f s (%s/s, %u threads)\n", files.size(),
+                human_bytes(double(bytes)).c_str(), static_cast<unsigned long long>(all.lines), secs_elapsed,
+                human_bytes(secs_elapsed > 0 ? double(bytes) / secs_elapsed : 0).c_str(), threads);
+    std::printf("nveis:");
+    for (int l = 0; l < NLevels; ++l)
+        std::printf(" %s %llu", kLevelName[l], static_cast<unsigned long long>(all.level[l]));
+    std::printf("  sem prefixo %llu\n", static_cast<unsigned long long>(all.no_prefix));
+
+    if (!hist.empty()) {
+        Sec sum;
+        const std::pair<int64_t, Sec>* peak = &hist[0];
+        for (auto& h : hist) {
+            sum.add(h.second);
+            if (h.second.lines > peak->second.lines) peak = &h;
+        }
+        const int64_t span = hist.back().first - hist.front().first + 1;
+        std::printf("intervalo: %s .. %s (%lld s, %zu com linhas)\n", format_sec(hist.front().first).c_str(),
+                    format_sec(hist.back().first).c_str(), static_cast<long long>(span), hist.size());
+        std::printf("linhas/s: mdia %.1f, pico %llu em %s\n", double(sum.lines) / double(span),
+                    static_cast<unsigned long long>(peak->second.lines), format_sec(peak->first).c_str());
+        std::printf("RX %llu, desconexes %llu, send falhou %llu\n", static_cast<unsigned long long>(sum.rx),
+                    static_cast<unsigned long long>(sum.disc), static_cast<unsigned long long>(sum.send_fail));
+
+        auto print_secs = [](const char* title, const std::vector<std::pair<int64_t, Sec>>& v) {
+            std::printf("\n%s\n", title);
+            for (auto& [k, s] : v)
+                std::printf("  %s  linhas %-8llu RX %-8llu desconexes %-6llu send falhou %-6llu warn+ %llu\n",
+                            format_sec(k).c_str(), static_cast<unsigned long long>(s.lines),
+                            static_cast<unsigned long long>(s.rx), static_cast<unsigned long long>(s.disc),
+                            static_cast<unsigned long long>(s.send_fail), static_cast<unsigned long long>(s.warn));
+        };
+        print_secs("top segundos por linhas:", top(hist, top_n, [](auto& h) { return h.second.lines; }));
+        if (sum.disc > 0) {
+            auto storms = top(hist, top_n, [](auto& h) { return h.second.disc; });
+            std::erase_if(storms, [](auto& h) { return h.second.disc == 0; });
+            print_secs("top segundos por desconexes:", storms);
+        }
+    }
+
+    std::vector<std::pair<uint64_t, FdStat>> fds;
+    for (size_t fd = 0; fd < all.fds.size(); ++fd) {
+        const FdStat& f = all.fds[fd];
+        if (f.rx || f.connects || f.disc || f.send_fail) fds.emplace_back(fd, f);
+    }
+    auto print_fds = [](const char* title, const std::vector<std::pair<uint64_t, FdStat>>& v) {
+        std::printf("\n%s\n", title);
+        for (auto& [fd, f] : v)
+            std::printf("  fd=%-6llu RX %-10llu conexes %-6llu desconexes %-6llu send falhou %llu\n",
+                        static_cast<unsigned long long>(fd), static_cast<unsigned long long>(f.rx),
+                        static_cast<unsigned long long>(f.connects), static_cast<unsigned long long>(f.disc),
+                        static_cast<unsigned long long>(f.send_fail));
+    };
+    if (!fds.empty()) {
+        print_fds("top fds por RX:", top(fds, top_n, [](auto& f) { return f.second.rx; }));
+        auto failing = top(fds, top_n, [](auto& f) { return f.second.send_fail; });
+        std::erase_if(failing, [](auto& f) { return f.second.send_fail == 0; });
+        if (!failing.empty()) print_fds("top fds por send falhou:", failing);
+    }
+    if (all.fd_overflow)
+        std::printf("\n%llu eventos com fd >= %llu ignorados na tabela por fd\n",
+                    static_cast<unsigned long long>(all.fd_overflow), static_cast<unsigned long long>(kMaxFd));
+
+    if (!csv.empty()) {
+        std::ofstream out(csv);
+        if (!out) {
+            std::cerr << "tslog_stats: no foi possvel gravar " << csv << "\n";
+            return 1;
+        }
+        out << "segundo,linhas,rx,desconexoes,send_falhou,warn\n";
+        for (auto& [k, s] : hist)
+            out << format_sec(k) << ',' << s.lines << ',' << s.rx << ',' << s.disc << ',' << s.send_fail << ','
+                << s.warn << '\n';
+    }
+
+    for (auto& f : files)
+        if (f.data) ::munmap(const_cast<char*>(f.data), f.size);
+    return 0;
+}